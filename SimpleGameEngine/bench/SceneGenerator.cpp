@@ -0,0 +1,219 @@
+#include "SceneGenerator.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "core/Game.h"
+#include "assistants/Resources.h"
+#include "components/ScriptComponent.h"
+#include "components/TextureComponent.h"
+#include "components/TilesetComponent.h"
+#include "components/AnimatedTextureComponent.h"
+
+// Width and height in pixels of a tile and of an animation frame
+#define BENCH_TILE_SIZE 16
+// Width and height in pixels of the texture of movers and hierarchy nodes
+#define BENCH_MOVER_SIZE 8
+// Frames of the sprite sheet of animated sprites
+#define BENCH_ANIMATION_FRAMES 4
+
+namespace sg
+{
+	namespace
+	{
+		const char* tilesPath = "bench/tiles.bmp";
+		const char* spriteSheetPath = "bench/sprite.bmp";
+		const char* animationPath = "bench/sprite.sganim";
+		const char* moverPath = "bench/mover.bmp";
+
+		// Moves its object in a straight line, bouncing on the edges of the scene
+		class BenchMover : public ScriptComponent
+		{
+		public:
+			virtual void update(float deltaSeconds) override
+			{
+				Object& object = getObject();
+				vec2 position = object.getRelativePosition() + velocity * deltaSeconds;
+
+				if (position.x < 0.f || position.x > bounds.x)
+				{
+					velocity.x = -velocity.x;
+					position.x = std::fmin(std::fmax(position.x, 0.f), bounds.x);
+				}
+				if (position.y < 0.f || position.y > bounds.y)
+				{
+					velocity.y = -velocity.y;
+					position.y = std::fmin(std::fmax(position.y, 0.f), bounds.y);
+				}
+
+				object.setPosition(position);
+			}
+
+			vec2 velocity = { 0.f, 0.f };
+			vec2 bounds = { 0.f, 0.f };
+		};
+
+		void saveImage(SDL_Surface* surface, const std::string& relativePath)
+		{
+			std::string path = Resources::pathTo(relativePath);
+			std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+			int saved = SDL_SaveBMP(surface, path.c_str());
+			SDL_FreeSurface(surface);
+			if (saved != 0)
+			{
+				throw std::runtime_error("Failed to write " + path + ": " + SDL_GetError());
+			}
+		}
+
+		// Image made of cells of the given size, each filled with a different color
+		SDL_Surface* createCells(int columns, int rows, int cellSize)
+		{
+			SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, columns * cellSize, rows * cellSize, 32, SDL_PIXELFORMAT_ARGB8888);
+			if (surface == nullptr)
+			{
+				throw std::runtime_error(std::string("Failed to create image: ") + SDL_GetError());
+			}
+
+			for (int y = 0; y < rows; ++y)
+			{
+				for (int x = 0; x < columns; ++x)
+				{
+					int cell = y * columns + x;
+					SDL_Rect rect{ x * cellSize, y * cellSize, cellSize, cellSize };
+					SDL_FillRect(surface, &rect, SDL_MapRGBA(surface->format,
+						(Uint8)(64 + cell * 37 % 192), (Uint8)(64 + cell * 71 % 192), (Uint8)(64 + cell * 113 % 192), 255));
+				}
+			}
+
+			return surface;
+		}
+
+		ComponentInitializationData makeData(ComponentTypes type, const std::string& path, int zIndex)
+		{
+			ComponentInitializationData data;
+			data.type = type;
+			data.path = path;
+			data.zIndex = zIndex;
+			return data;
+		}
+
+		vec2 randomVelocity(std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> speed(-120.f, 120.f);
+			return { speed(random), speed(random) };
+		}
+	}
+
+	SceneSettings SceneSettings::fromObjectCount(int objects, int hierarchyDepth)
+	{
+		SceneSettings settings;
+		settings.hierarchyDepth = hierarchyDepth;
+		settings.hierarchies = objects / 10 / (hierarchyDepth + 1);
+		settings.animatedSprites = objects / 5;
+		settings.movers = objects / 5;
+		// Tiles make up for the rounding so the scene has exactly the requested number of objects
+		settings.staticTiles = objects - settings.animatedSprites - settings.movers - settings.hierarchies * (hierarchyDepth + 1);
+		return settings;
+	}
+
+	void SceneGenerator::writeAssets()
+	{
+		saveImage(createCells(4, 4, BENCH_TILE_SIZE), tilesPath);
+		saveImage(createCells(BENCH_ANIMATION_FRAMES, 1, BENCH_TILE_SIZE), spriteSheetPath);
+		saveImage(createCells(1, 1, BENCH_MOVER_SIZE), moverPath);
+
+		std::string path = Resources::pathTo(animationPath);
+		std::ofstream file(path);
+		file << "<" << spriteSheetPath << ">\n";
+		file << "\t<loop | play>\n";
+		file << "\t\tframeWidth = " << BENCH_TILE_SIZE << "\n";
+		file << "\t\tframeHeight = " << BENCH_TILE_SIZE << "\n";
+		file << "\t\tnumFrames = " << BENCH_ANIMATION_FRAMES << "\n";
+		file << "\t\tframeRate = 12\n";
+		file << "\t</loop>\n";
+		file << "</" << spriteSheetPath << ">\n";
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write " + path);
+		}
+	}
+
+	vec2 SceneGenerator::getSceneSize(const SceneSettings& settings)
+	{
+		// Roughly one tile worth of space per object
+		float side = std::ceil(std::sqrt((float)std::max(settings.getObjectCount(), 1))) * BENCH_TILE_SIZE;
+		return { side, side };
+	}
+
+	void SceneGenerator::generate(const SceneSettings& settings)
+	{
+		std::mt19937 random(settings.seed);
+		vec2 size = getSceneSize(settings);
+		std::uniform_real_distribution<float> randomX(0.f, size.x), randomY(0.f, size.y);
+
+		// Tiles fill rows from the top left corner of the scene
+		int columns = std::max((int)(size.x / BENCH_TILE_SIZE), 1);
+		ComponentInitializationData tileData = makeData(ComponentTypes::TilesetComponent, tilesPath, 0);
+		tileData.size = { (float)BENCH_TILE_SIZE, (float)BENCH_TILE_SIZE };
+		tileData.isStatic = true;
+		for (int i = 0; i < settings.staticTiles; ++i)
+		{
+			vec2 position{ (float)(i % columns * BENCH_TILE_SIZE), (float)(i / columns * BENCH_TILE_SIZE) };
+			Object& tile = Game::instanciate(position, "Tile");
+			tile.addComponent<TilesetComponent>(tileData).setIndex(i % 16);
+		}
+
+		ComponentInitializationData spriteData = makeData(ComponentTypes::AnimatedTextureComponent, animationPath, 1);
+		for (int i = 0; i < settings.animatedSprites; ++i)
+		{
+			Object& sprite = Game::instanciate({ randomX(random), randomY(random) }, "Sprite");
+			sprite.addComponent<AnimatedTextureComponent>(spriteData);
+		}
+
+		ComponentInitializationData moverData = makeData(ComponentTypes::TextureComponent, moverPath, 2);
+		for (int i = 0; i < settings.movers; ++i)
+		{
+			Object& mover = Game::instanciate({ randomX(random), randomY(random) }, "Mover");
+			mover.addComponent<TextureComponent>(moverData);
+			BenchMover& script = mover.addScript<BenchMover>();
+			script.velocity = randomVelocity(random);
+			script.bounds = size;
+		}
+
+		// Every node is placed relative to its parent, moving the root moves the whole chain
+		for (int i = 0; i < settings.hierarchies; ++i)
+		{
+			Object& root = Game::instanciate({ randomX(random), randomY(random) }, "Hierarchy");
+			root.addComponent<TextureComponent>(moverData);
+			BenchMover& script = root.addScript<BenchMover>();
+			script.velocity = randomVelocity(random);
+			script.bounds = size;
+
+			Object* parent = &root;
+			for (int depth = 0; depth < settings.hierarchyDepth; ++depth)
+			{
+				Object& child = Game::instanciate({ (float)BENCH_MOVER_SIZE, (float)BENCH_MOVER_SIZE / 2.f }, "Node");
+				child.addComponent<TextureComponent>(moverData);
+				parent->attach(child);
+				parent = &child;
+			}
+		}
+	}
+
+	void SceneGenerator::clear()
+	{
+		for (Object* object : Game::getAllObjects())
+		{
+			Game::destroy(object);
+		}
+	}
+}
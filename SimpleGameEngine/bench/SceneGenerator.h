@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+#include "core/vec2.h"
+
+namespace sg
+{
+	struct SceneSettings
+	{
+		// Tiles flagged as static, laid out in a grid and baked by the StaticTileLayer
+		int staticTiles = 0;
+		// Sprites playing a looping animation at random positions
+		int animatedSprites = 0;
+		// Textured objects moved by a script every update, bouncing on the edges of the scene
+		int movers = 0;
+		// Moving roots with a chain of hierarchyDepth nested textured children
+		int hierarchies = 0;
+		int hierarchyDepth = 4;
+		unsigned int seed = 1;
+
+		// Number of objects instanciated for these settings
+		int getObjectCount() const { return staticTiles + animatedSprites + movers + hierarchies * (hierarchyDepth + 1); }
+
+		// Split a total number of objects between every kind of object:
+		// half static tiles, a fifth animated sprites, a fifth movers and a tenth in hierarchies
+		static SceneSettings fromObjectCount(int objects, int hierarchyDepth = 4);
+	};
+
+	/*
+		Builds synthetic scenes of any size to measure how the engine scales. Objects are spread
+		over a square area whose size grows with the number of objects, so the part of the scene
+		seen by the camera stays the same while the rest of it has to be culled.
+	*/
+	class SceneGenerator
+	{
+	public:
+		// Write the images and the animation file used by generated objects under resources/bench.
+		// Throws a std::runtime_error if they can't be written
+		static void writeAssets();
+
+		// Instanciate the objects described by settings, assets must have been written first
+		static void generate(const SceneSettings& settings);
+
+		// Destroy every object, they are deleted during the next update
+		static void clear();
+
+		// Width and height of the area objects of a scene are spread on
+		static vec2 getSceneSize(const SceneSettings& settings);
+
+	private:
+		SceneGenerator() = delete;
+		SceneGenerator(const SceneGenerator&) = delete;
+		SceneGenerator& operator=(const SceneGenerator&) = delete;
+	};
+}
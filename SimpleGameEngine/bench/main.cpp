@@ -0,0 +1,421 @@
+#define SDL_MAIN_HANDLED
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "core/Window.h"
+#include "core/Game.h"
+#include "core/AllocationTracker.h"
+#include "SceneGenerator.h"
+
+/*
+	Headless benchmark of the engine. Every run generates a synthetic scene, updates and draws it for a
+	number of frames and records the time spent in Window::processEvents (update), in Window::draw
+	(draw and present) and the resident memory of the process after each frame. Results are written
+	as JSON so scaling curves can be compared between object counts and between commits.
+
+	bench --objects 1000,10000,100000,1000000 --frames 300 --label $(git rev-parse --short HEAD)
+	bench --tiles 50000 --sprites 2000 --movers 2000 --hierarchies 100 --depth 8
+
+	Built with make TRACK_ALLOCATIONS=1, heap allocations of every frame are recorded as well and
+	--no-allocations fails when a measured frame allocates, writing the call sites to allocations.txt.
+*/
+
+namespace
+{
+	struct BenchOptions
+	{
+		// One run per element, empty when the scene is described object kind by object kind
+		std::vector<int> objectCounts;
+		sg::SceneSettings scene;
+		int frames = 300;
+		// Frames drawn before measuring, textures and static chunks are created during the first ones
+		int warmupFrames = 30;
+		unsigned int width = 1280;
+		unsigned int height = 720;
+		float zoom = 1.f;
+		// Open a real window with the default renderer instead of SDL's dummy drivers
+		bool window = false;
+		// Fail when a measured frame allocates, requires an engine built with SG_TRACK_ALLOCATIONS
+		bool noAllocations = false;
+		std::string label;
+		std::string outputPath = "bench_results.json";
+	};
+
+	struct FrameSample
+	{
+		double update;
+		double draw;
+		size_t memory;
+		uint64_t allocations;
+	};
+
+	struct RunResult
+	{
+		sg::SceneSettings scene;
+		double setupSeconds = 0.0;
+		size_t memoryBeforeScene = 0;
+		std::vector<FrameSample> frames;
+	};
+
+	void printUsage()
+	{
+		std::cout << "Usage: bench [options]\n"
+			<< "  --objects N[,N...]   Run one scene per total number of objects, split between every kind\n"
+			<< "  --tiles N            Static tiles\n"
+			<< "  --sprites N          Animated sprites\n"
+			<< "  --movers N           Objects moved by a script\n"
+			<< "  --hierarchies N      Moving roots with nested children\n"
+			<< "  --depth N            Children nested under each hierarchy root (default 4)\n"
+			<< "  --frames N           Measured frames per run (default 300)\n"
+			<< "  --warmup N           Frames drawn before measuring (default 30)\n"
+			<< "  --size WxH           Window size (default 1280x720)\n"
+			<< "  --zoom F             Camera zoom, below 1 shows more of the scene (default 1)\n"
+			<< "  --seed N             Seed of object positions and velocities (default 1)\n"
+			<< "  --label TEXT         Stored in the results, e.g. the commit being measured\n"
+			<< "  --output PATH        Results file (default bench_results.json)\n"
+			<< "  --window             Open a real window instead of running headless\n"
+			<< "  --no-allocations     Fail when a measured frame allocates, needs make TRACK_ALLOCATIONS=1\n";
+	}
+
+	std::vector<int> parseCounts(const std::string& list)
+	{
+		std::vector<int> counts;
+		std::stringstream ss(list);
+		std::string count;
+		while (std::getline(ss, count, ','))
+		{
+			counts.push_back(std::stoi(count));
+		}
+
+		return counts;
+	}
+
+	// Returns false if the arguments are not valid
+	bool parseArguments(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--window")
+			{
+				options.window = true;
+				continue;
+			}
+			if (argument == "--no-allocations")
+			{
+				options.noAllocations = true;
+				continue;
+			}
+
+			if (i + 1 >= argc) return false;
+			std::string value = argv[++i];
+
+			if (argument == "--objects") options.objectCounts = parseCounts(value);
+			else if (argument == "--tiles") options.scene.staticTiles = std::stoi(value);
+			else if (argument == "--sprites") options.scene.animatedSprites = std::stoi(value);
+			else if (argument == "--movers") options.scene.movers = std::stoi(value);
+			else if (argument == "--hierarchies") options.scene.hierarchies = std::stoi(value);
+			else if (argument == "--depth") options.scene.hierarchyDepth = std::stoi(value);
+			else if (argument == "--frames") options.frames = std::stoi(value);
+			else if (argument == "--warmup") options.warmupFrames = std::stoi(value);
+			else if (argument == "--zoom") options.zoom = std::stof(value);
+			else if (argument == "--seed") options.scene.seed = (unsigned int)std::stoul(value);
+			else if (argument == "--label") options.label = value;
+			else if (argument == "--output") options.outputPath = value;
+			else if (argument == "--size")
+			{
+				if (std::sscanf(value.c_str(), "%ux%u", &options.width, &options.height) != 2) return false;
+			}
+			else return false;
+		}
+
+		return options.frames > 0 && options.warmupFrames >= 0 && options.zoom > 0.f && options.scene.hierarchyDepth >= 0;
+	}
+
+	// Resident memory of the process in bytes, 0 if it can't be read on this platform
+	size_t residentMemory()
+	{
+#if defined(__APPLE__)
+		mach_task_basic_info_data_t info;
+		mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+		if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+		{
+			return (size_t)info.resident_size;
+		}
+#elif defined(__linux__)
+		// Read without streams, which allocate and would count in the frame's allocations
+		int file = open("/proc/self/statm", O_RDONLY);
+		if (file >= 0)
+		{
+			char text[128] = {};
+			ssize_t length = read(file, text, sizeof(text) - 1);
+			close(file);
+
+			size_t totalPages = 0, residentPages = 0;
+			if (length > 0 && std::sscanf(text, "%zu %zu", &totalPages, &residentPages) == 2)
+			{
+				return residentPages * (size_t)sysconf(_SC_PAGESIZE);
+			}
+		}
+#endif
+		return 0;
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Returns false if the window was closed
+	bool runFrame(sg::Window& window, FrameSample* sample)
+	{
+		auto updateStart = std::chrono::steady_clock::now();
+		if (!window.processEvents()) return false;
+		double update = millisecondsSince(updateStart);
+
+		auto drawStart = std::chrono::steady_clock::now();
+		window.draw();
+		double draw = millisecondsSince(drawStart);
+
+		if (sample)
+		{
+			*sample = { update, draw, residentMemory(), sg::AllocationTracker::getLastFrame().allocations };
+		}
+
+		return true;
+	}
+
+	// Returns false if the window was closed before the run ended
+	bool run(sg::Window& window, const BenchOptions& options, RunResult& result)
+	{
+		result.memoryBeforeScene = residentMemory();
+
+		auto setupStart = std::chrono::steady_clock::now();
+		sg::SceneGenerator::generate(result.scene);
+		result.setupSeconds = millisecondsSince(setupStart) / 1000.0;
+
+		for (int i = 0; i < options.warmupFrames; ++i)
+		{
+			if (!runFrame(window, nullptr)) return false;
+		}
+
+		result.frames.resize((size_t)options.frames);
+		for (FrameSample& sample : result.frames)
+		{
+			if (!runFrame(window, &sample)) return false;
+
+			if (options.noAllocations && sample.allocations > 0)
+			{
+				sg::AllocationTracker::writeReport("allocations.txt");
+				throw std::runtime_error("A measured frame allocated " + std::to_string(sample.allocations) +
+					" times, call sites written to allocations.txt");
+			}
+		}
+
+		// Objects are deleted during the update of the next frame
+		sg::SceneGenerator::clear();
+		return window.processEvents();
+	}
+
+	// Mean, median, 99th percentile and maximum of a series, in a JSON object
+	std::string summarize(std::vector<double> values, int precision = 4)
+	{
+		std::sort(values.begin(), values.end());
+		double total = 0.0;
+		for (double value : values)
+		{
+			total += value;
+		}
+
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(precision);
+		out << "{ \"mean\": " << total / (double)values.size()
+			<< ", \"p50\": " << values[values.size() / 2]
+			<< ", \"p99\": " << values[std::min(values.size() * 99 / 100, values.size() - 1)]
+			<< ", \"max\": " << values.back() << " }";
+		return out.str();
+	}
+
+	std::string escape(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+
+		return escaped;
+	}
+
+	bool writeResults(const BenchOptions& options, const sg::Window& window, const std::vector<RunResult>& results)
+	{
+		std::ofstream file(options.outputPath);
+		if (!file.is_open()) return false;
+
+		file << std::fixed << std::setprecision(4);
+		file << "{\n";
+		file << "  \"label\": \"" << escape(options.label) << "\",\n";
+		file << "  \"headless\": " << (options.window ? "false" : "true") << ",\n";
+		file << "  \"softwareRenderer\": " << (window.isSoftwareRenderer() ? "true" : "false") << ",\n";
+		file << "  \"width\": " << options.width << ",\n";
+		file << "  \"height\": " << options.height << ",\n";
+		file << "  \"zoom\": " << options.zoom << ",\n";
+		file << "  \"warmupFrames\": " << options.warmupFrames << ",\n";
+		file << "  \"runs\": [\n";
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const RunResult& result = results[i];
+			std::vector<double> update, draw, frame, memory, allocations;
+			for (const FrameSample& sample : result.frames)
+			{
+				update.push_back(sample.update);
+				draw.push_back(sample.draw);
+				frame.push_back(sample.update + sample.draw);
+				memory.push_back((double)sample.memory);
+				allocations.push_back((double)sample.allocations);
+			}
+
+			file << "    {\n";
+			file << "      \"objects\": " << result.scene.getObjectCount() << ",\n";
+			file << "      \"staticTiles\": " << result.scene.staticTiles << ",\n";
+			file << "      \"animatedSprites\": " << result.scene.animatedSprites << ",\n";
+			file << "      \"movers\": " << result.scene.movers << ",\n";
+			file << "      \"hierarchies\": " << result.scene.hierarchies << ",\n";
+			file << "      \"hierarchyDepth\": " << result.scene.hierarchyDepth << ",\n";
+			file << "      \"setupSeconds\": " << result.setupSeconds << ",\n";
+			file << "      \"memoryBeforeSceneBytes\": " << result.memoryBeforeScene << ",\n";
+			file << "      \"updateMs\": " << summarize(update) << ",\n";
+			file << "      \"drawMs\": " << summarize(draw) << ",\n";
+			file << "      \"frameMs\": " << summarize(frame) << ",\n";
+			file << "      \"memoryBytes\": " << summarize(memory, 0) << ",\n";
+			if (sg::AllocationTracker::isAvailable())
+			{
+				file << "      \"allocationsPerFrame\": " << summarize(allocations, 1) << ",\n";
+			}
+
+			// One [update, draw, memory] triplet per measured frame
+			file << "      \"frames\": [";
+			for (size_t f = 0; f < result.frames.size(); ++f)
+			{
+				const FrameSample& sample = result.frames[f];
+				file << ((f % 8 == 0) ? "\n        " : " ") << "[" << sample.update << ", " << sample.draw << ", " << sample.memory << "]";
+				if (f + 1 < result.frames.size()) file << ",";
+			}
+			file << "\n      ]\n";
+			file << "    }" << ((i + 1 < results.size()) ? "," : "") << "\n";
+		}
+
+		file << "  ]\n";
+		file << "}\n";
+		return (bool)file;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	try
+	{
+		if (!parseArguments(argc, argv, options))
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	catch (const std::exception&)
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<sg::SceneSettings> scenes;
+	for (int count : options.objectCounts)
+	{
+		scenes.push_back(sg::SceneSettings::fromObjectCount(count, options.scene.hierarchyDepth));
+		scenes.back().seed = options.scene.seed;
+	}
+	if (scenes.empty())
+	{
+		scenes.push_back(options.scene);
+	}
+
+	try
+	{
+		sg::WindowOptions windowOptions;
+		windowOptions.vsync = false;
+		windowOptions.headless = !options.window;
+		windowOptions.performanceOverlayKey = SDLK_UNKNOWN;
+
+		if (options.noAllocations && !sg::AllocationTracker::isAvailable())
+		{
+			std::cout << "--no-allocations needs an engine built with make TRACK_ALLOCATIONS=1" << std::endl;
+			return 1;
+		}
+
+		sg::Window window("SimpleGameEngine bench", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+			options.width, options.height, windowOptions);
+		sg::Window::getCamera()->zoom = options.zoom;
+		sg::SceneGenerator::writeAssets();
+
+		std::vector<RunResult> results;
+		for (const sg::SceneSettings& scene : scenes)
+		{
+			std::cout << "Running " << scene.getObjectCount() << " objects..." << std::endl;
+
+			RunResult result;
+			result.scene = scene;
+			if (!run(window, options, result))
+			{
+				std::cout << "Window closed, stopping" << std::endl;
+				break;
+			}
+
+			double update = 0.0, draw = 0.0;
+			for (const FrameSample& sample : result.frames)
+			{
+				update += sample.update;
+				draw += sample.draw;
+			}
+			std::cout << "  update " << update / (double)result.frames.size() << " ms, draw "
+				<< draw / (double)result.frames.size() << " ms per frame" << std::endl;
+
+			results.push_back(result);
+		}
+
+		if (!writeResults(options, window, results))
+		{
+			std::cout << "Failed to write " << options.outputPath << std::endl;
+			return 1;
+		}
+
+		std::cout << "Results written to " << options.outputPath << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
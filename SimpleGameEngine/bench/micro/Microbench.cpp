@@ -0,0 +1,119 @@
+#include "Microbench.h"
+#include "core/AllocationTracker.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+// Instrumented engine builds already replace operator new, their counts are used instead
+#if !defined(SG_TRACK_ALLOCATIONS)
+namespace
+{
+	std::atomic<uint64_t> allocations{ 0 };
+	std::atomic<uint64_t> allocatedBytes{ 0 };
+
+	void* allocate(size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (void* memory = std::malloc((size > 0) ? size : 1))
+		{
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+// Every allocation of the executable, engine included, goes through these
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+#endif
+
+namespace sg
+{
+	std::string Microbench::filter;
+	double Microbench::minimumTime = 0.25;
+	std::vector<MicrobenchResult> Microbench::results;
+	volatile uint64_t Microbench::sink = 0;
+
+	uint64_t Microbench::getAllocations()
+	{
+#if defined(SG_TRACK_ALLOCATIONS)
+		return AllocationTracker::getTotal().allocations;
+#else
+		return allocations.load(std::memory_order_relaxed);
+#endif
+	}
+
+	uint64_t Microbench::getAllocatedBytes()
+	{
+#if defined(SG_TRACK_ALLOCATIONS)
+		return AllocationTracker::getTotal().bytes;
+#else
+		return allocatedBytes.load(std::memory_order_relaxed);
+#endif
+	}
+
+	void Microbench::run(const std::string& name, uint64_t opsPerBatch, const std::function<void()>& batch)
+	{
+		if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+		// First batch warms caches up and isn't measured
+		batch();
+
+		uint64_t ops = 0;
+		uint64_t allocationsStart = getAllocations();
+		uint64_t bytesStart = getAllocatedBytes();
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed(0.0);
+		do
+		{
+			batch();
+			ops += opsPerBatch;
+			elapsed = std::chrono::steady_clock::now() - start;
+		} while (elapsed.count() < minimumTime);
+
+		MicrobenchResult result;
+		result.name = name;
+		result.ops = ops;
+		result.nanosecondsPerOp = elapsed.count() * 1e9 / (double)ops;
+		result.allocationsPerOp = (double)(getAllocations() - allocationsStart) / (double)ops;
+		result.bytesPerOp = (double)(getAllocatedBytes() - bytesStart) / (double)ops;
+		results.push_back(result);
+
+		std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+			<< std::setw(14) << std::setprecision(1) << result.nanosecondsPerOp << " ns/op"
+			<< std::setw(12) << std::setprecision(2) << result.allocationsPerOp << " allocs/op"
+			<< std::setw(12) << std::setprecision(1) << result.bytesPerOp << " B/op" << std::endl;
+	}
+
+	bool Microbench::writeResults(const std::string& path, const std::string& label)
+	{
+		std::ofstream file(path);
+		if (!file.is_open()) return false;
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\n  \"label\": \"" << label << "\",\n  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const MicrobenchResult& result = results[i];
+			file << "    { \"name\": \"" << result.name << "\", \"ops\": " << result.ops
+				<< ", \"nsPerOp\": " << result.nanosecondsPerOp
+				<< ", \"allocationsPerOp\": " << result.allocationsPerOp
+				<< ", \"bytesPerOp\": " << result.bytesPerOp << " }"
+				<< ((i + 1 < results.size()) ? "," : "") << "\n";
+		}
+		file << "  ]\n}\n";
+
+		return (bool)file;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sg
+{
+	struct MicrobenchResult
+	{
+		std::string name;
+		uint64_t ops = 0;
+		double nanosecondsPerOp = 0.0;
+		// Heap allocations and allocated bytes, counted by the microbench executable's operator new
+		double allocationsPerOp = 0.0;
+		double bytesPerOp = 0.0;
+	};
+
+	/*
+		Minimal timing harness for the microbenchmarks: a batch of operations is repeated until it ran
+		for a minimum time, then time and heap allocations are divided by the number of operations.
+		Allocations are counted by replacing the global operator new, only in the microbench executable.
+	*/
+	class Microbench
+	{
+	public:
+		// Time batch, which performs opsPerBatch operations, and print the result.
+		// Skipped if the name doesn't contain the filter
+		static void run(const std::string& name, uint64_t opsPerBatch, const std::function<void()>& batch);
+
+		// Only run benchmarks whose name contains filter, every benchmark when empty
+		static void setFilter(const std::string& newFilter) { filter = newFilter; }
+		// Shortest time in seconds every benchmark runs for
+		static void setMinimumTime(double seconds) { minimumTime = seconds; }
+
+		static const std::vector<MicrobenchResult>& getResults() { return results; }
+		// Write every result to a JSON file. Returns false if the file can't be written
+		static bool writeResults(const std::string& path, const std::string& label);
+
+		// Keep the compiler from removing computations whose result is otherwise unused
+		static void consume(uint64_t value) { sink = sink + value; }
+
+		// Heap allocations and allocated bytes since the program started
+		static uint64_t getAllocations();
+		static uint64_t getAllocatedBytes();
+
+	private:
+		Microbench() = delete;
+		Microbench(const Microbench&) = delete;
+		Microbench& operator=(const Microbench&) = delete;
+
+		static std::string filter;
+		static double minimumTime;
+		static std::vector<MicrobenchResult> results;
+		static volatile uint64_t sink;
+	};
+}
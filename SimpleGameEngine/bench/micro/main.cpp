@@ -0,0 +1,366 @@
+#define SDL_MAIN_HANDLED
+
+#include <SDL.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Cache.h"
+#include "core/Game.h"
+#include "core/Input.h"
+#include "core/Parser.h"
+#include "core/Quadtree.h"
+#include "core/Window.h"
+#include "components/BoxComponent.h"
+#include "components/DrawableComponent.h"
+#include "Microbench.h"
+
+/*
+	Microbenchmarks of the engine's core data structures, each reporting time, heap allocations and
+	allocated bytes per operation. Use them to measure a change to one of these classes in isolation,
+	the bench executable measures whole frames.
+
+	microbench [--filter NAME] [--time SECONDS] [--output PATH --label TEXT]
+*/
+
+using namespace sg;
+
+namespace
+{
+	// Destroy every object, deleted by the next update
+	void clearObjects(Window& window)
+	{
+		for (Object* object : Game::getAllObjects())
+		{
+			Game::destroy(object);
+		}
+		window.processEvents();
+	}
+
+	ComponentInitializationData boxData(float size)
+	{
+		ComponentInitializationData data;
+		data.type = ComponentTypes::BoxComponent;
+		data.size = { size, size };
+		return data;
+	}
+
+	void benchmarkCache()
+	{
+		const int numKeys = 1024;
+		std::vector<std::string> keys;
+		for (int i = 0; i < numKeys; ++i)
+		{
+			keys.push_back("resources/textures/generated_" + std::to_string(i) + ".png");
+		}
+
+		// The last reference going away removes the value, the next add inserts it again
+		Cache<std::string, int> churn;
+		Microbench::run("Cache add and release", numKeys, [&]()
+		{
+			for (int i = 0; i < numKeys; ++i)
+			{
+				CacheRef<std::string, int> ref = churn.add(keys[i], i);
+				Microbench::consume((uint64_t)ref.get());
+			}
+		});
+
+		// Values stay cached while a reference is held
+		Cache<std::string, int> cache;
+		std::vector<CacheRef<std::string, int>> held;
+		held.reserve(numKeys);
+		for (int i = 0; i < numKeys; ++i)
+		{
+			held.push_back(cache.add(keys[i], i));
+		}
+
+		Microbench::run("Cache find hit and release", numKeys, [&]()
+		{
+			for (int i = 0; i < numKeys; ++i)
+			{
+				auto found = cache.find(keys[i]);
+				Microbench::consume((uint64_t)found.first.get());
+			}
+		});
+
+		std::string missing = "resources/textures/missing.png";
+		Microbench::run("Cache find miss", numKeys, [&]()
+		{
+			for (int i = 0; i < numKeys; ++i)
+			{
+				Microbench::consume((uint64_t)cache.find(missing).second);
+			}
+		});
+	}
+
+	std::string writeGeneratedObject(const std::filesystem::path& directory, int numComponents)
+	{
+		std::string path = (directory / "generated.sgo").string();
+		std::ofstream file(path);
+		file << "<Generated | layer-world>\n";
+		file << "    position = 10, 20\n";
+		file << "    size = 1, 1\n";
+		file << "    <Components>\n";
+		for (int i = 0; i < numComponents; ++i)
+		{
+			file << "        <BoxComponent>\n";
+			file << "            size = " << 8 + i % 16 << ", " << 8 + i % 16 << "\n";
+			file << "            drawDebug = false\n";
+			file << "        </BoxComponent>\n";
+		}
+		file << "    </Components>\n";
+		file << "    <Scripts>\n";
+		file << "        GeneratedScript\n";
+		file << "    </Scripts>\n";
+		file << "</Generated>\n";
+		return path;
+	}
+
+	std::string writeGeneratedWorld(const std::filesystem::path& directory, int numObjects)
+	{
+		std::string path = (directory / "generated.sgworld").string();
+		std::ofstream file(path);
+		for (int i = 0; i < numObjects; ++i)
+		{
+			file << "<Object" << i << " | layer-world>\n";
+			file << "    position = " << i % 100 * 16 << ", " << i / 100 * 16 << "\n";
+			file << "    size = 1, 1\n";
+			file << "    <Components>\n";
+			file << "        <BoxComponent>\n";
+			file << "            size = 16, 16\n";
+			file << "        </BoxComponent>\n";
+			file << "    </Components>\n";
+			file << "</Object" << i << ">\n";
+		}
+		return path;
+	}
+
+	void benchmarkParser()
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "sge-microbench";
+		std::filesystem::create_directories(directory);
+
+		std::string objectPath = writeGeneratedObject(directory, 2000);
+		Microbench::run("Parser .sgo 2000 components", 1, [&]()
+		{
+			Parser parser(objectPath);
+			Microbench::consume(parser.getMainBlock().subBlocks.size());
+		});
+
+		std::string worldPath = writeGeneratedWorld(directory, 5000);
+		Microbench::run("Parser .sgworld 5000 objects", 1, [&]()
+		{
+			Parser parser(worldPath);
+			Microbench::consume(parser.getBlocks().size());
+		});
+
+		std::filesystem::remove_all(directory);
+	}
+
+	void benchmarkQuadtree(Window& window)
+	{
+		// The tree covers -500 to 500 on both axes
+		const int numObjects = 1000;
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-500.f, 500.f);
+		std::vector<Object*> objects;
+		for (int i = 0; i < numObjects; ++i)
+		{
+			objects.push_back(&Game::instanciate({ position(random), position(random) }, "Quadtree"));
+		}
+
+		Microbench::run("Quadtree::insert 1000 objects", numObjects, [&]()
+		{
+			Quadtree tree;
+			for (Object* object : objects)
+			{
+				tree.insert(object);
+			}
+		});
+
+		Microbench::run("Quadtree::insert then remove 1000 objects", 2 * numObjects, [&]()
+		{
+			Quadtree tree;
+			for (Object* object : objects)
+			{
+				tree.insert(object);
+			}
+			for (Object* object : objects)
+			{
+				tree.remove(object);
+			}
+		});
+
+		clearObjects(window);
+	}
+
+	void benchmarkBoxes(Window& window)
+	{
+		const int numBoxes = 1000;
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> position(0.f, 2000.f);
+		std::vector<BoxComponent*> boxes;
+		for (int i = 0; i < numBoxes; ++i)
+		{
+			Object& object = Game::instanciate({ position(random), position(random) }, "Box");
+			boxes.push_back(&object.addComponent<BoxComponent>(boxData(32.f)));
+		}
+
+		Microbench::run("BoxComponent::isOverlapping 1000 vs 1000", (uint64_t)numBoxes * numBoxes, [&]()
+		{
+			uint64_t overlaps = 0;
+			for (BoxComponent* box : boxes)
+			{
+				for (BoxComponent* other : boxes)
+				{
+					overlaps += box->isOverlapping(other);
+				}
+			}
+			Microbench::consume(overlaps);
+		});
+
+		clearObjects(window);
+	}
+
+	void benchmarkGetComponents(Window& window)
+	{
+		// Tree of depth 6 with 3 children per object, 1093 objects with a box each
+		const int depth = 6, fanOut = 3;
+		Object& root = Game::instanciate({ 0.f, 0.f }, "Root");
+		root.addComponent<BoxComponent>(boxData(16.f));
+		std::vector<Object*> level{ &root };
+		for (int d = 1; d < depth + 1; ++d)
+		{
+			std::vector<Object*> next;
+			for (Object* parent : level)
+			{
+				for (int i = 0; i < fanOut; ++i)
+				{
+					Object& child = Game::instanciate({ 1.f, 1.f }, "Node");
+					child.addComponent<BoxComponent>(boxData(16.f));
+					parent->attach(child);
+					next.push_back(&child);
+				}
+			}
+			level = next;
+		}
+
+		Microbench::run("Object::getComponents<T> returned, 1093 objects", 1, [&]()
+		{
+			Microbench::consume(root.getComponents<BoxComponent>().size());
+		});
+
+		std::vector<BoxComponent*> boxes;
+		Microbench::run("Object::getComponents<T> reused vector, 1093 objects", 1, [&]()
+		{
+			boxes.clear();
+			root.getComponents<BoxComponent>(boxes);
+			Microbench::consume(boxes.size());
+		});
+
+		Microbench::run("Object::getComponents<T> no match, 1093 objects", 1, [&]()
+		{
+			Microbench::consume(root.getComponents<DrawableComponent>().size());
+		});
+
+		clearObjects(window);
+	}
+
+	void benchmarkInput(Window& window)
+	{
+		// Keys are pressed through the event queue, the way the window receives them
+		const SDL_Keycode pressed[] = { SDLK_a, SDLK_d, SDLK_w, SDLK_s, SDLK_SPACE, SDLK_LSHIFT, SDLK_e, SDLK_q };
+		for (SDL_Keycode key : pressed)
+		{
+			SDL_Event event{};
+			event.type = SDL_KEYDOWN;
+			event.key.keysym.sym = key;
+			SDL_PushEvent(&event);
+		}
+		window.processEvents();
+
+		const int numQueries = 1000;
+		Microbench::run("Input::isKeyPressed, 8 keys pressed", numQueries, [&]()
+		{
+			uint64_t count = 0;
+			for (int i = 0; i < numQueries; ++i)
+			{
+				count += Input::isKeyPressed(pressed[i % 8]);
+			}
+			Microbench::consume(count);
+		});
+
+		Microbench::run("Input::isKeyPressed not pressed", numQueries, [&]()
+		{
+			uint64_t count = 0;
+			for (int i = 0; i < numQueries; ++i)
+			{
+				count += Input::isKeyPressed(SDLK_z);
+			}
+			Microbench::consume(count);
+		});
+
+		Microbench::run("Input::getKeyDown and getKeyUp", 2 * numQueries, [&]()
+		{
+			uint64_t count = 0;
+			for (int i = 0; i < numQueries; ++i)
+			{
+				count += Input::getKeyDown(pressed[i % 8]);
+				count += Input::getKeyUp(pressed[i % 8]);
+			}
+			Microbench::consume(count);
+		});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string outputPath, label;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string argument = argv[i];
+		if (argument == "--filter") Microbench::setFilter(argv[i + 1]);
+		else if (argument == "--time") Microbench::setMinimumTime(std::atof(argv[i + 1]));
+		else if (argument == "--output") outputPath = argv[i + 1];
+		else if (argument == "--label") label = argv[i + 1];
+		else
+		{
+			std::cout << "Usage: microbench [--filter NAME] [--time SECONDS] [--output PATH --label TEXT]" << std::endl;
+			return 1;
+		}
+	}
+
+	try
+	{
+		// Objects and input need an engine window, nothing is shown
+		WindowOptions options;
+		options.headless = true;
+		options.vsync = false;
+		Window window("SimpleGameEngine microbench", 0, 0, 64, 64, options);
+
+		benchmarkCache();
+		benchmarkParser();
+		benchmarkQuadtree(window);
+		benchmarkBoxes(window);
+		benchmarkGetComponents(window);
+		benchmarkInput(window);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	if (!outputPath.empty() && !Microbench::writeResults(outputPath, label))
+	{
+		std::cout << "Failed to write " << outputPath << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
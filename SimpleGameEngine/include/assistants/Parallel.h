@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace sg
+{
+	class Parallel
+	{
+	public:
+		// Split [0, count) in batches of at least minBatchSize elements and run job(begin, end) on every batch
+		// using a pool of worker threads. The calling thread processes batches too and the function returns
+		// once every batch is done. Small ranges are processed directly on the calling thread
+		static void forRange(size_t count, size_t minBatchSize, const std::function<void(size_t, size_t)>& job);
+
+		// Number of threads processing batches, including the calling thread
+		static unsigned int getNumThreads();
+
+	private:
+		Parallel() = delete;
+		Parallel(const Parallel&) = delete;
+		Parallel& operator=(const Parallel&) = delete;
+		Parallel(Parallel&&) = delete;
+	};
+}
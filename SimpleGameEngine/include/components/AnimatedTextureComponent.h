@@ -3,6 +3,7 @@
 #include "components/DrawableComponent.h"
 #include "components/Updatable.h"
 #include "core/Cache.h"
+#include "core/SpriteTrimmer.h"
 
 #include <unordered_map>
 #include <memory>
@@ -59,6 +60,8 @@ namespace sg
 		Progression progression = Progression::LeftToRight;
 		// Determines if the animation should be auto-played when a new component instanciates
 		bool autoPlay = false;
+		// One element per frame when the animation file has the "trim" specifier, empty otherwise
+		std::vector<TrimmedFrame> trimmedFrames;
 	};
 
 	enum class Flip { None, Horizontal, Vertical, UseLast };
@@ -80,6 +83,10 @@ namespace sg
 
 		virtual void update(float deltaSeconds) override;
 
+		virtual bool isAnimating() const override { return playing && currentAnim && currentAnim->numFrames > 1; }
+
+		static CacheStatistics getCacheStatistics() { return animCache.getStatistics(); }
+
 	private:
 
 		// Prepare the component using a cache ref
@@ -92,6 +99,12 @@ namespace sg
 		
 		void nextFrame();
 
+		// Use the trimmed source rectangle of the current frame
+		void applyTrimmedFrame();
+
+		// Trim frames of every animation and use the cooked sprite sheet
+		void cookTrimmedFrames(const std::string& filePath, const std::string& imagePath, std::map<std::string, Animation>& anims);
+
 		// Resets current animation to it's first frame
 		void resetAnimation();
 
@@ -18,9 +18,13 @@ namespace sg
 	class Component
 	{
 	public:
-		Component(Object* obj = nullptr) : m_object(obj) {}
+		Component(Object* obj = nullptr) : m_object(obj) { ++count; }
+		Component(const Component& other) : m_object(other.m_object) { ++count; }
 		virtual ~Component() = 0;
 
+		// Number of components alive, scripts included
+		static size_t getCount() { return count; }
+
 		Object& getObject() const { return *m_object; }
 
 		template <typename T, typename ... TArgs>
@@ -40,6 +44,9 @@ namespace sg
 
 		friend class ObjectData;
 		Object* m_object;
+
+	private:
+		static size_t count;
 	};
 }
 
@@ -17,6 +17,8 @@ namespace sg
 			TextComponent,
 			TextureComponent,
 			TilesetComponent,
+			ParticleSystemComponent,
+			PixelBufferComponent,
 		};
 
 		constexpr ComponentTypes(Value type = BoxComponent) : value(type) {}
@@ -32,6 +34,28 @@ namespace sg
 		Value value;
 	};
 
+	// Emission and simulation settings of a ParticleSystemComponent. Ranges are min, max
+	struct ParticleEmitterData
+	{
+		int maxParticles = 1000;
+		// Particles emitted per second
+		float rate = 0.f;
+		// Particles emitted at once when the emitter starts, then every burstInterval seconds if it's positive
+		int burst = 0;
+		float burstInterval = 0.f;
+		vec2 lifetime = { 1.f, 1.f };
+		// Speed in pixels per second and emission angle in degrees
+		vec2 speed = { 0.f, 0.f };
+		vec2 angle = { 0.f, 360.f };
+		vec2 gravity = { 0.f, 0.f };
+		// Size in pixels of a particle at the beginning and at the end of its life
+		vec2 particleSize = { 8.f, 8.f };
+		bool fadeOut = false;
+
+		ParticleEmitterData() {}
+		ParticleEmitterData(const Block& data);
+	};
+
 	struct ComponentInitializationData
 	{
 		ComponentTypes type = ComponentTypes::BoxComponent;
@@ -42,8 +66,11 @@ namespace sg
 		int zIndex = 0;
 		bool drawDebug = false;
 		bool centerOrigin = false;
+		// Tiles baked by the StaticTileLayer, they must never move nor change zIndex
+		bool isStatic = false;
 		int margin = 0;
 		int spacing = 0;
+		ParticleEmitterData particles;
 
 		ComponentInitializationData() {}
 		~ComponentInitializationData() {}
@@ -34,17 +34,50 @@ namespace sg
 
 		bool centerOrigin() const { return m_centerOrigin; }
 
+		// Source rectangles of trimmed sprites only hold the visible part of a frame. The trim gives
+		// the position of that part in the frame (x, y) and the size of the whole frame (w, h)
+		bool isTrimmed() const { return m_trim.w > 0; }
+		const SDL_Rect& getTrim() const { return m_trim; }
+
 		SDL_Rect getBounds() const;
+
+		// Rectangle covered by this component when drawn, in world coordinates
+		// or in screen coordinates if the owning object uses screen position
+		SDL_Rect getDrawRect() const;
+
+		// Static components are baked by the StaticTileLayer instead of being drawn every frame
+		bool isStatic() const { return m_static; }
 		
 		virtual void preDrawOperations() {}
 
+		// Returns true while the component changes on its own over time, e.g. a playing animation.
+		// The window doesn't go idle while a visible component is animating
+		virtual bool isAnimating() const { return false; }
+
+		// Returns true if the pixels of the texture were modified by the last pre-draw operations.
+		// The drawable is then drawn again even if nothing else changed
+		virtual bool hasUpdatedPixels() const { return false; }
+
+		// Components rendering themselves instead of copying their texture override the following functions.
+		// Custom drawn components are drawn again every frame
+		virtual bool hasCustomDraw() const { return false; }
+		// Area covered by the custom drawing, in world coordinates or in screen coordinates
+		// if the owning object uses screen position. May be called from several threads
+		virtual SDL_FRect getCustomDrawBounds() const { return { 0.f, 0.f, 0.f, 0.f }; }
+		// Offset is subtracted from positions: camera top left corner, or zero for screen-position objects
+		virtual void customDraw(SDL_Renderer*, const vec2&) {}
+
 	protected:
+		friend class StaticTileLayer;
 		void initializeTexture(const std::string& path) { m_texture = std::make_unique<Texture>(path); }
 
 		std::unique_ptr<Texture> m_texture;
 		SDL_Rect m_srcrect = { 0, 0, 0, 0 };
+		// Empty when the source rectangle isn't trimmed
+		SDL_Rect m_trim = { 0, 0, 0, 0 };
 		bool m_useSrcRect = false;
 		bool m_centerOrigin = false;
+		bool m_static = false;
 		SDL_RendererFlip m_flip = SDL_FLIP_NONE;
 	};
 }
\ No newline at end of file
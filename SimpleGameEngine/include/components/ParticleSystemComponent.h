@@ -0,0 +1,82 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <vector>
+#include <random>
+
+#include "components/DrawableComponent.h"
+#include "components/Updatable.h"
+#include "core/Object/Object.h"
+
+// Above this number of particles, vertices are built on several threads
+#define PARALLEL_PARTICLES_THRESHOLD 8192
+// Minimum number of particles handled by a thread at once
+#define PARTICLES_BATCH_SIZE 2048
+
+namespace sg
+{
+	/*
+		Emits particles from the owning object's position, by rate and/or bursts.
+		Particles are not objects: they live in structure-of-arrays buffers updated with SIMD
+		instructions when available, and every particle of the emitter is drawn with a single
+		geometry call using the component's texture, or plain squares if it has none.
+	*/
+	class ParticleSystemComponent : public DrawableComponent, public Updatable
+	{
+	public:
+		ParticleSystemComponent(Object* obj, const ComponentInitializationData& data);
+		virtual ~ParticleSystemComponent() override {};
+
+		virtual void update(float deltaSeconds) override;
+
+		// Emit particles right away, within the limit of settings.maxParticles
+		void emit(int count);
+		// Remove every living particle
+		void clear() { m_count = 0; }
+
+		size_t getNumParticles() const { return m_count; }
+
+		// Living particles move, and emitters with a rate or repeated bursts keep emitting
+		virtual bool isAnimating() const override
+		{
+			return m_count > 0 || (emitting && (settings.rate > 0.f || (settings.burst > 0 && settings.burstInterval > 0.f)));
+		}
+
+		virtual bool hasCustomDraw() const override { return true; }
+		virtual SDL_FRect getCustomDrawBounds() const override { return m_bounds; }
+		virtual void customDraw(SDL_Renderer* renderer, const vec2& offset) override;
+
+	public:
+		// Settings can be changed at any time, they apply to particles emitted afterwards
+		ParticleEmitterData settings;
+		// Emission can be paused, living particles are still updated
+		bool emitting = true;
+
+	private:
+		// Apply gravity and velocities, age particles and compute bounds of the particles
+		void integrate(float deltaSeconds);
+		// Swap dead particles with the last living ones
+		void removeDeadParticles();
+		void reserve(size_t capacity);
+		void buildVertices(size_t begin, size_t end, const vec2& offset);
+
+		size_t m_count = 0;
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_velocityX;
+		std::vector<float> m_velocityY;
+		std::vector<float> m_age;
+		std::vector<float> m_lifetime;
+
+		float m_emissionDebt = 0.f;
+		float m_burstTimer = 0.f;
+		bool m_started = false;
+		SDL_FRect m_bounds = { 0.f, 0.f, 0.f, 0.f };
+
+		std::vector<SDL_Vertex> m_vertices;
+		std::vector<int> m_indices;
+
+		std::mt19937 m_random;
+	};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include "components/DrawableComponent.h"
+#include "core/Object/Object.h"
+
+namespace sg
+{
+	/*
+		Draws a streaming texture whose pixels are written on the CPU, for minimaps, fog of war or
+		procedural effects. Scripts lock the region they write, unlock it, and regions modified since the
+		last frame are uploaded before drawing. The size in pixels comes from the component's size.
+
+		Pixels are ARGB8888 with straight alpha:
+			Uint32* pixels = buffer.lockPixels(&region);
+			pixels[y * buffer.getPitch() + x] = 0xFF00FF00;
+			buffer.unlockPixels();
+	*/
+	class PixelBufferComponent : public DrawableComponent
+	{
+	public:
+		PixelBufferComponent(Object* obj, const ComponentInitializationData& data);
+		PixelBufferComponent(Object* obj, int width, int height);
+		virtual ~PixelBufferComponent() override {};
+
+		// Returns a pointer to the top left pixel of region, or of the whole buffer if it's null.
+		// Returns nullptr if region is empty or not entirely inside the buffer, fill clips its region instead
+		Uint32* lockPixels(const SDL_Rect* region = nullptr) { return m_texture->lockPixels(region); }
+		void unlockPixels() { m_texture->unlockPixels(); }
+		// Number of pixels between two rows
+		int getPitch() const { return m_texture->getPixelPitch(); }
+		int getWidth() const { return m_texture->getWidth(); }
+		int getHeight() const { return m_texture->getHeight(); }
+
+		// Set every pixel of region, or of the whole buffer if it's null, to color
+		void fill(Uint32 color, const SDL_Rect* region = nullptr);
+
+		virtual void preDrawOperations() override;
+		virtual bool hasUpdatedPixels() const override { return m_uploaded; }
+
+	private:
+		// Modified regions were uploaded by the last pre-draw operations
+		bool m_uploaded = false;
+	};
+}
@@ -25,6 +25,9 @@ namespace sg
 
 	private:
 		int ptSize;
+		// Text and size the current texture was rendered with
+		std::string renderedText;
+		int renderedPtSize = 0;
 		std::string fontPath;
 		TTF_Font* m_font;
 	};
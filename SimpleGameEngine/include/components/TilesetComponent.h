@@ -9,7 +9,7 @@ namespace sg
 	public:
 		TilesetComponent(Object* obj, const ComponentInitializationData& data);
 		
-		virtual ~TilesetComponent() override {};
+		virtual ~TilesetComponent() override;
 
 		void setIndex(int newIndex);
 		int getIndex() const { return tileIndex; }
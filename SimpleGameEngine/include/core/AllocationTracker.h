@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Number of distinct call sites allocations are attributed to, later sites are counted as unknown
+#define ALLOCATION_TRACKER_SITES 4096
+// Stack frames looked through to find the code calling into the standard library
+#define ALLOCATION_TRACKER_FRAMES 8
+
+namespace sg
+{
+	struct AllocationCounts
+	{
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+	};
+
+	/*
+		Counts heap allocations made through operator new, in total and per frame, and attributes them to
+		the innermost profile scope and the code calling operator new. On Linux and macOS, frames of the
+		standard library are skipped, so a push_back is attributed to the function calling it rather than
+		to std::allocator. Elsewhere call sites are the direct callers of operator new and only scopes are
+		meaningful for containers. Counting replaces the global operator
+		new and delete, so it's only compiled in instrumented builds: define SG_TRACK_ALLOCATIONS for the
+		engine and the game (make TRACK_ALLOCATIONS=1). Otherwise every count stays at zero.
+		Frames are counted from one Window::draw to the next, allocations of every thread included.
+	*/
+	class AllocationTracker
+	{
+	public:
+		// Returns true if allocations are counted, i.e. the engine was built with SG_TRACK_ALLOCATIONS
+		static bool isAvailable();
+
+		static AllocationCounts getTotal();
+		static AllocationCounts getLastFrame() { return lastFrame; }
+		// Number of frames ended since the window was created
+		static uint64_t getFrame() { return frame; }
+
+		// Write the count call sites allocating the most, in the last frame and since the program started.
+		// Returns false if the file can't be written
+		static bool writeReport(const std::string& path, size_t count = 30);
+
+		// Called by profile scopes. Returns the scope that was current so it can be restored when leaving
+		static const char* enterScope(const char* name);
+		static void leaveScope(const char* previous);
+
+		// Called by operator new with its return address
+		static void record(size_t bytes, void* returnAddress);
+
+	private:
+		AllocationTracker() = delete;
+		AllocationTracker(const AllocationTracker&) = delete;
+		AllocationTracker& operator=(const AllocationTracker&) = delete;
+		AllocationTracker(AllocationTracker&&) = delete;
+
+		friend class Window;
+		static void endFrame();
+
+		static AllocationCounts lastFrame;
+		static AllocationCounts frameStart;
+		static uint64_t frame;
+	};
+}
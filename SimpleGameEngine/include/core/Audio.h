@@ -33,6 +33,9 @@ namespace sg
 		// This function will add the sound in cache to avoid loading it on next call. Use this function if you intend to play the sound often
 		static void playSoundFast(const std::string& path, int volume = SDL_MIX_MAXVOLUME);
 
+		// Number of sounds currently playing, music excluded
+		static int getNumPlayingSounds() { return Mix_Playing(-1); }
+
 	private:
 		static void channelFinished(int channel);
 
@@ -1,13 +1,27 @@
 #pragma once
 
-#include <iostream>
+#include <sstream>
 #include <unordered_map>
 #include <tuple>
 #include <string>
 #include <utility>
 
+#include "core/Log.h"
+
 namespace sg
 {
+	// Lookup counters of a cache
+	struct CacheStatistics
+	{
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		// Number of values currently cached
+		size_t size = 0;
+
+		// Ratio of lookups that found a value, between 0 and 1
+		float hitRate() const { return (hits + misses > 0) ? (float)hits / (float)(hits + misses) : 0.f; }
+	};
+
 	template <typename TKey, typename TValue>
 	class Cache;
 
@@ -124,23 +138,37 @@ namespace sg
 
 			if (kvp == m_cache.end())
 			{
+				++m_misses;
 				return std::pair<CRef, bool>( CRef(), false );
 			}
 			else
 			{
+				++m_hits;
 				return std::pair<CRef, bool>( CRef(kvp->first, kvp->second, this), true );
 			}
 		}
 
+		// Returns true if a value is cached with the key, doesn't count as a lookup
+		bool contains(const TKey& key) const { return m_cache.find(key) != m_cache.end(); }
+
+		CacheStatistics getStatistics() const
+		{
+			CacheStatistics statistics;
+			statistics.hits = m_hits;
+			statistics.misses = m_misses;
+			statistics.size = m_cache.size();
+			return statistics;
+		}
+
 		void print()
 		{
 #ifdef _DEBUG
-			for (auto element : m_cache)
+			for (const auto& element : m_cache)
 			{
-				std::cout << "Key: " << element.first << "\tValue:" << std::get<0>(element.second) << " #Ref: " << std::get<1>(element.second) << std::endl;
+				std::ostringstream line;
+				line << "Key: " << element.first << "\tValue:" << std::get<0>(element.second) << " #Ref: " << std::get<1>(element.second);
+				SG_LOG_DEBUG("%s", line.str().c_str());
 			}
-
-			std::cout << std::endl;
 #endif
 		}
 		
@@ -160,5 +188,7 @@ namespace sg
 		}
 
 		CacheMap m_cache;
+		unsigned long long m_hits = 0;
+		unsigned long long m_misses = 0;
 	};
 }
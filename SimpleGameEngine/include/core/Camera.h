@@ -12,9 +12,16 @@ namespace sg
 			position.y += movement.y;
 		}
 
+		// Multiply the zoom, factors above 1 zoom in
+		void zoomBy(float factor) { zoom *= factor; }
+
 	public:
 		vec2 position;
+		// Area of the world seen by the camera, updated by the window from its size and the zoom
 		vec2 size;
+		// Screen pixels per world unit, values below 1 show more of the world.
+		// Screen-position objects are not zoomed
+		float zoom = 1.f;
 	private:
 		// A Camera can only be instanciated by a window
 		friend class Window;
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL_rect.h>
+
+#include <vector>
+#include <cstdint>
+
+// Width and height in pixels of the screen cells tracked by the coverage grid
+#define COVERAGE_CELL_SIZE 16
+
+namespace sg
+{
+	/*
+		Coarse screen-space record of the cells already covered by opaque drawables.
+		Drawables are visited front to back: a drawable whose visible area only overlaps covered
+		cells can't be seen, otherwise the cells it fully covers are added if it's opaque.
+		Cells are stored as one bit each so rows are tested and filled 64 cells at a time.
+	*/
+	class CoverageGrid
+	{
+	public:
+		// Start a frame with every cell of a width x height screen uncovered
+		void reset(int width, int height);
+
+		// Returns true if the on-screen part of the rectangle is entirely covered.
+		// Rectangles entirely outside of the screen are not covered, they are left to other culling
+		bool isCovered(const SDL_Rect& rect) const;
+		// Mark the cells the rectangle fully covers, the rectangle must be opaque
+		void cover(const SDL_Rect& rect);
+		// Returns true once every cell of the screen is covered
+		bool isFull() const { return m_numCovered == (size_t)m_cellsX * m_cellsY; }
+
+	private:
+		// Clip the rectangle to the screen, returns false if nothing is left
+		bool clip(const SDL_Rect& rect, SDL_Rect& clipped) const;
+
+		int m_width = 0;
+		int m_height = 0;
+		int m_cellsX = 0;
+		int m_cellsY = 0;
+		size_t m_wordsPerRow = 0;
+		size_t m_numCovered = 0;
+		std::vector<uint64_t> m_cells;
+	};
+}
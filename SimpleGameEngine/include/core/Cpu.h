@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+	Instruction sets picked at runtime. The engine is built for the baseline of its target, e.g. SSE2 on
+	x86-64, so AVX and AVX2 code paths are compiled separately for these instruction sets and only called
+	once the CPU is known to support them:
+
+		SG_TARGET_AVX2 void blendRowAvx2(...);
+		if (Cpu::hasAvx2()) blendRowAvx2(...);
+
+	SG_USE_AVX and SG_USE_AVX2 are defined when such code paths can be compiled. Building with -mavx2
+	or -march=native makes the checks constant and lets the compiler inline these paths.
+*/
+
+#if defined(__AVX2__)
+#define SG_USE_AVX
+#define SG_USE_AVX2
+#define SG_TARGET_AVX
+#define SG_TARGET_AVX2
+#elif defined(__AVX__)
+#define SG_USE_AVX
+#define SG_TARGET_AVX
+#if defined(__GNUC__)
+#define SG_USE_AVX2
+#define SG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+// GCC and Clang compile functions for another instruction set with the target attribute
+#define SG_USE_AVX
+#define SG_USE_AVX2
+#define SG_TARGET_AVX __attribute__((target("avx")))
+#define SG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(SG_USE_AVX)
+#include <immintrin.h>
+#endif
+
+namespace sg
+{
+	class Cpu
+	{
+	public:
+		static bool hasAvx()
+		{
+#if defined(__AVX__)
+			return true;
+#elif defined(SG_USE_AVX)
+			static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx"));
+			return supported;
+#else
+			return false;
+#endif
+		}
+
+		static bool hasAvx2()
+		{
+#if defined(__AVX2__)
+			return true;
+#elif defined(SG_USE_AVX2)
+			static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+			return supported;
+#else
+			return false;
+#endif
+		}
+
+	private:
+		Cpu() = delete;
+		Cpu(const Cpu&) = delete;
+		Cpu& operator=(const Cpu&) = delete;
+		Cpu(Cpu&&) = delete;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "core/DrawCommand.h"
+
+// Above this number of regions, dirty regions are merged in a single rectangle
+#define MAX_DIRTY_REGIONS 16
+// Above this number of changed rectangles they are replaced by their bounds without merging them one by one
+#define MAX_PENDING_DIRTY_REGIONS (4 * MAX_DIRTY_REGIONS)
+// When dirty regions cover more than this fraction of the screen the whole screen is redrawn
+#define DIRTY_FULL_REDRAW_RATIO 0.6f
+
+namespace sg
+{
+	/*
+		Keeps track of what was drawn last frame to find which screen regions changed.
+		A drawable is considered changed when it moves, resizes, changes source rectangle,
+		texture, flip or zIndex, appears or disappears.
+	*/
+	class DirtyRegions
+	{
+	public:
+		// Record what a drawable looks like this frame
+		void track(const DrawCommand& command);
+
+		// Compare this frame with the previous one and compute the regions to redraw.
+		// The returned regions are clipped to the screen and don't overlap
+		const std::vector<SDL_Rect>& endFrame(const SDL_Rect& screen);
+
+		// Force the whole screen to be redrawn next frame
+		void invalidate() { m_invalidated = true; }
+
+		// Forget everything that was drawn
+		void clear();
+
+	private:
+		struct TrackedState
+		{
+			DrawCommand command;
+			unsigned int lastFrameSeen = 0;
+		};
+
+		void addRegion(const SDL_Rect& region);
+		void mergeRegions(const SDL_Rect& screen);
+
+		std::unordered_map<const void*, TrackedState> m_tracked;
+		// Regions that changed this frame, before merging
+		std::vector<SDL_Rect> m_pending;
+		std::vector<SDL_Rect> m_regions;
+		unsigned int m_frame = 1;
+		bool m_invalidated = true;
+	};
+}
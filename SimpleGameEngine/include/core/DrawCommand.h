@@ -0,0 +1,102 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <vector>
+
+#include "core/vec2.h"
+
+// Above this number of drawables, draw commands are prepared on several threads
+#define PARALLEL_PREPARATION_THRESHOLD 4096
+// Minimum number of drawables prepared by a thread at once
+#define PREPARATION_BATCH_SIZE 1024
+
+namespace sg
+{
+	class DrawableComponent;
+
+	// Everything needed to submit a drawable to the renderer
+	struct DrawCommand
+	{
+		SDL_Texture* texture;
+		DrawableComponent* component;
+		SDL_Rect source;
+		SDL_Rect destination;
+		SDL_RendererFlip flip;
+		int zIndex;
+		// Half resolution level of the component's texture drawn, 0 for the texture itself.
+		// texture and source are the level's
+		int level;
+		bool fullTexture;
+		// Drawn on the user interface layer: screen-position object or object on LAYER_UI
+		bool userInterface;
+		// The component draws itself, destination is the area it covers
+		bool customDraw;
+		// Hidden behind opaque drawables, skipped when drawing
+		bool occluded;
+		// Pixels of the texture were modified for this frame
+		bool pixelsUpdated;
+	};
+
+	// Two commands are equal when they draw the same pixels at the same place.
+	// Custom drawn commands and commands whose texture was modified are never considered equal
+	inline bool operator==(const DrawCommand& a, const DrawCommand& b)
+	{
+		return !a.customDraw && !b.customDraw && !a.pixelsUpdated && !b.pixelsUpdated && a.texture == b.texture && a.flip == b.flip && a.zIndex == b.zIndex &&
+			a.source.x == b.source.x && a.source.y == b.source.y && a.source.w == b.source.w && a.source.h == b.source.h &&
+			a.destination.x == b.destination.x && a.destination.y == b.destination.y &&
+			a.destination.w == b.destination.w && a.destination.h == b.destination.h;
+	}
+
+	inline bool operator!=(const DrawCommand& a, const DrawCommand& b) { return !(a == b); }
+
+	/*
+		Turns drawables into draw commands stored in a contiguous buffer.
+		Destination rectangles (size scaling, centering, camera offset and zoom) are computed with SIMD
+		instructions when available, and split across threads when there are many drawables.
+		Drawables much smaller on screen than their source use a half resolution level of their texture.
+	*/
+	class DrawCommandBuffer
+	{
+	public:
+		// Run pre-draw operations, compute draw commands and sort them by zIndex
+		void prepare(const std::vector<DrawableComponent*>& drawables, const vec2& cameraTopLeft, float zoom = 1.f);
+
+		const std::vector<DrawCommand>& getCommands() const { return m_commands; }
+		std::vector<DrawCommand>& getCommands() { return m_commands; }
+		size_t size() const { return m_commands.size(); }
+
+	private:
+		// Read object and component data into the command and the input arrays
+		void fetch(size_t begin, size_t end, const vec2& cameraTopLeft, float zoom);
+		// Compute destination rectangles from the input arrays
+		void computeDestinations(size_t begin, size_t end);
+		// Compute the destinations of the first drawables 8 at a time, returns the index of the first one left.
+		// Only defined when AVX code can be compiled, see Cpu
+		size_t computeDestinationsAvx(size_t begin, size_t end);
+		// Draw textures from the level closest to their on-screen size
+		void selectLevels(size_t begin, size_t end);
+		// Stable sort of commands by zIndex without allocating once buffers are large enough
+		void sortByZIndex();
+
+		const std::vector<DrawableComponent*>* m_drawables = nullptr;
+		std::vector<DrawCommand> m_commands;
+		// Merge sort destination, swapped with m_commands
+		std::vector<DrawCommand> m_sortBuffer;
+
+		// Inputs of the destination computation, one element per drawable
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_width;
+		std::vector<float> m_height;
+		std::vector<float> m_scaleX;
+		std::vector<float> m_scaleY;
+		// 1 when the component's origin is centered, 0 otherwise
+		std::vector<float> m_center;
+		// Camera top left corner, or zero for screen-position objects
+		std::vector<float> m_offsetX;
+		std::vector<float> m_offsetY;
+		// Camera zoom, 1 for screen-position objects
+		std::vector<float> m_zoom;
+	};
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Number of frames to wait after a scale change before changing it again
+#define DYNAMIC_RESOLUTION_COOLDOWN 30
+// Scales are rounded to a multiple of this step to avoid changing for tiny differences
+#define DYNAMIC_RESOLUTION_STEP (1.f / 64.f)
+
+namespace sg
+{
+	struct DynamicResolutionSettings
+	{
+		// Bounds of the scale the world is rendered at, use the same value for a fixed scale
+		float minScale = 0.5f;
+		float maxScale = 1.f;
+		// Time in seconds a frame should take to update, draw and present
+		float targetFrameTime = 1.f / 60.f;
+	};
+
+	/*
+		Chooses the scale the world is rendered at from the time spent on recent frames.
+		Rendering cost is assumed to grow with the number of pixels, so the scale moves
+		by the square root of the ratio between the target and the measured frame time.
+	*/
+	class DynamicResolution
+	{
+	public:
+		void setSettings(const DynamicResolutionSettings& settings);
+		const DynamicResolutionSettings& getSettings() const { return m_settings; }
+
+		// Feed the time spent on the last frame, returns true if the scale changed
+		bool update(float frameTime);
+		float getScale() const { return m_scale; }
+
+	private:
+		DynamicResolutionSettings m_settings;
+		float m_scale = 1.f;
+		float m_averageFrameTime = 0.f;
+		int m_framesSinceChange = 0;
+	};
+}
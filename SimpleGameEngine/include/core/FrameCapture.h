@@ -0,0 +1,121 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// "SGFC" read as a little endian integer, first bytes of the shared memory
+#define FRAME_CAPTURE_MAGIC 0x43464753
+#define FRAME_CAPTURE_VERSION 2
+
+namespace sg
+{
+	/*
+		Layout of the shared memory, in this order:
+		FrameCaptureHeader, then slotCount slots made of a FrameSlotHeader followed by the pixels.
+		Every slot starts on a 64 bytes boundary, slotSize includes the slot header.
+	*/
+	struct FrameCaptureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		// Bytes per row of pixels
+		uint32_t pitch;
+		// SDL_PixelFormatEnum value of the pixels, the 32 bits format the renderer draws in, e.g. ARGB8888 or RGB888
+		uint32_t pixelFormat;
+		uint32_t slotCount;
+		uint32_t slotSize;
+		// Number of frames written so far, frame n is in slot n % slotCount
+		std::atomic<uint64_t> writeIndex;
+		// Number of frames the consumer is done with, written by the consumer
+		std::atomic<uint64_t> readIndex;
+		// Frames not captured because every slot was still waiting for the consumer
+		std::atomic<uint64_t> droppedFrames;
+	};
+
+	struct FrameSlotHeader
+	{
+		// Odd while the slot is written, 2 * (frame index + 1) once frame index is complete
+		std::atomic<uint64_t> sequence;
+		// Nanoseconds since capture started, when the frame was presented
+		uint64_t timestamp;
+		// Number of frames presented by the window before this one since capture started
+		uint64_t frameNumber;
+	};
+
+	struct FrameCaptureSettings
+	{
+		// Number of preallocated frame buffers
+		unsigned int slotCount = 8;
+		// Capture one presented frame every frameInterval frames
+		unsigned int frameInterval = 1;
+		// When false, frames are dropped while the consumer is late instead of overwriting unread frames
+		bool overwrite = false;
+		// Name of the shared memory, shows in /proc/<pid>/fd
+		std::string name = "sge-frames";
+	};
+
+	struct FrameCaptureStatistics
+	{
+		uint64_t captured = 0;
+		uint64_t dropped = 0;
+	};
+
+	/*
+		Writes presented frames into a ring of preallocated buffers in shared memory so a local
+		encoder process can read them without any copy. On Linux the memory is an anonymous memfd:
+		the consumer opens /proc/<pid>/fd/<fd>, or inherits the descriptor, and maps it.
+		Other platforms keep the ring in process memory.
+
+		Frames are read from the renderer straight into their slot, in the format it draws in so SDL
+		doesn't convert them. With the software renderer this is a plain copy of the window surface,
+		about 1 ms per 1920x1080 frame. SDL2 has no asynchronous readback: accelerated renderers wait
+		for the GPU to finish the frame, on top of the copy.
+	*/
+	class FrameCapture
+	{
+	public:
+		FrameCapture() = default;
+		~FrameCapture() { stop(); }
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		// Allocate the ring for width x height frames of a 32 bits pixelFormat, the renderer's to avoid conversions.
+		// Returns false if shared memory can't be created
+		bool start(int width, int height, const FrameCaptureSettings& settings = FrameCaptureSettings(),
+			Uint32 pixelFormat = SDL_PIXELFORMAT_ARGB8888);
+		void stop();
+		bool isCapturing() const { return m_memory != nullptr; }
+
+		// Read the renderer's current target into the next slot, call it before presenting
+		void capture(SDL_Renderer* renderer);
+
+		// File descriptor of the shared memory, -1 if it isn't shared
+		int getFileDescriptor() const { return m_fd; }
+		size_t getSize() const { return m_size; }
+		FrameCaptureStatistics getStatistics() const;
+
+	private:
+		FrameCaptureHeader* header() const { return (FrameCaptureHeader*)m_memory; }
+		FrameSlotHeader* slot(uint64_t index) const;
+		uint8_t* slotPixels(uint64_t index) const { return (uint8_t*)slot(index) + m_slotHeaderSize; }
+
+		uint8_t* m_memory = nullptr;
+		size_t m_size = 0;
+		int m_fd = -1;
+		// Used instead of shared memory when it isn't available
+		std::vector<uint8_t> m_localMemory;
+
+		size_t m_headerSize = 0;
+		size_t m_slotHeaderSize = 0;
+		FrameCaptureSettings m_settings;
+		uint64_t m_frameNumber = 0;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
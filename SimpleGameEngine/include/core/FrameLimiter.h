@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Number of frames used to compute frame pacing statistics
+#define FRAME_PACING_WINDOW 120
+
+namespace sg
+{
+	// Achieved frame pacing over the last frames, durations are in seconds
+	struct FramePacing
+	{
+		float averageFrameTime = 0.f;
+		float minFrameTime = 0.f;
+		float maxFrameTime = 0.f;
+		// Standard deviation of frame times
+		float jitter = 0.f;
+		float averageFrameRate = 0.f;
+		// Frames that ended later than their deadline, only counted when a frame rate limit is set
+		unsigned int missedDeadlines = 0;
+	};
+
+	/*
+		Measures time between frames and optionally caps the frame rate.
+		Waiting sleeps until shortly before the deadline then spins the rest of the way,
+		the spinning margin adapts to how much the system oversleeps.
+	*/
+	class FrameLimiter
+	{
+	public:
+		FrameLimiter();
+
+		// Maximum number of frames per second, 0 disables the limit
+		void setTargetFrameRate(unsigned int frameRate);
+		unsigned int getTargetFrameRate() const { return m_targetFrameRate; }
+
+		// Wait for the end of the frame if a limit is set and record the frame time
+		void endFrame();
+		// Start timing the next frame from now without recording a frame time, when frames were skipped
+		void reset();
+
+		FramePacing getPacing() const;
+		// Duration in seconds of the last frame, including time spent waiting
+		float getLastFrameTime() const { return m_lastFrameTime; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		void waitUntil(Clock::time_point deadline);
+
+		unsigned int m_targetFrameRate = 0;
+		Clock::duration m_framePeriod = Clock::duration::zero();
+		Clock::time_point m_deadline;
+		Clock::time_point m_lastFrameEnd;
+		// Estimated oversleep of the system, the last part of the wait is spent spinning
+		Clock::duration m_spinMargin = std::chrono::milliseconds(1);
+
+		float m_lastFrameTime = 0.f;
+		std::vector<float> m_frameTimes;
+		size_t m_nextFrameTime = 0;
+		unsigned int m_missedDeadlines = 0;
+	};
+}
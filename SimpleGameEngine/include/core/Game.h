@@ -31,7 +31,19 @@ namespace sg
 
 		static std::vector<Object*>& getAllObjects();
 		static std::vector<Object*> getAllOrphanObjects();
+		// Appends orphan objects to the provided vector, reuse it to avoid allocating every call
+		static void getAllOrphanObjects(std::vector<Object*>& orphans);
 		static void dispatchUpdates();
+
+		// Keep the window from going idle next frame. Scripts changing things over time without
+		// drawables changing on their own call this every update while they need to run
+		static void requestTick() { tickRequested = true; }
+		static bool isTickRequested() { return tickRequested; }
+
+		// Every update simulates this many seconds instead of the time elapsed since the last one,
+		// 0 goes back to real time. Used to record and replay input, see InputRecorder
+		static void setFixedDelta(float seconds) { fixedDelta = seconds; }
+		static float getFixedDelta() { return fixedDelta; }
 	private:
 		Game() = delete;
 		Game(const Game&) = delete;
@@ -45,6 +57,8 @@ namespace sg
 	private:
 		static std::vector<Object*> objects;
 		static std::queue <Object*> destroyQueue;
+		static bool tickRequested;
+		static float fixedDelta;
 		//static Quadtree quadtree;
 	};
 }
@@ -43,6 +43,7 @@ namespace sg
 		Input(Input&&) = delete;
 
 		friend class Window;
+		friend class InputRecorder;
 
 		static std::vector<InputState> keys;
 		static std::vector<MouseButtonState> mouseButtons;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <SDL_events.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "core/vec2.h"
+
+// "SGIR" read as a little endian integer, first bytes of a recording
+#define INPUT_RECORDING_MAGIC 0x52494753
+#define INPUT_RECORDING_VERSION 1
+
+namespace sg
+{
+	/*
+		Records what Input receives every frame to a file and feeds it back frame by frame, so a play
+		session can be replayed exactly, headless and as fast as the machine can go. Updates simulate
+		a fixed delta while recording or replaying, scripts get the same input on the same frame
+		regardless of frame times.
+
+		Only changes of input are stored: key and mouse button presses and releases and mouse
+		movements. A recording is a header followed by one entry per frame:
+			header: uint32 magic, uint32 version, float delta in seconds, uint32 number of frames
+			frame: uint16 number of events, then the events
+			event: uint8 type, then a int32 keycode, a uint8 button or two floats for the mouse position
+		Values are written in the byte order of the machine, little endian on every supported platform.
+	*/
+	class InputRecorder
+	{
+	public:
+		// Record the input of every following frame. Returns false if the file can't be created
+		static bool startRecording(const std::string& path, float fixedDelta = 1.f / 60.f);
+		// Replace user input by a recording from the next frame on. Returns false if it can't be read
+		static bool startReplay(const std::string& path);
+		// Stop recording or replaying, a recording is complete once stopped
+		static void stop();
+
+		static bool isRecording() { return recording; }
+		static bool isReplaying() { return replaying; }
+		// Every frame of the replay has been played
+		static bool isReplayFinished() { return replaying && replayFrame >= replayFrames.size(); }
+		// Frames recorded or replayed so far
+		static uint32_t getFrame() { return frame; }
+
+	private:
+		InputRecorder() = delete;
+		InputRecorder(const InputRecorder&) = delete;
+		InputRecorder& operator=(const InputRecorder&) = delete;
+		InputRecorder(InputRecorder&&) = delete;
+
+		friend class Input;
+		friend class Window;
+
+		enum EventType : uint8_t { KeyDown, KeyUp, ButtonDown, ButtonUp, MouseMotion };
+
+		struct Event
+		{
+			EventType type;
+			SDL_Keycode key;
+			uint8_t button;
+			vec2 mouse;
+		};
+
+		// Called by Input when its state changes
+		static void record(const Event& event) { pendingEvents.push_back(event); }
+		// Called by the window once events of the frame are processed, before updates.
+		// Writes the recorded frame or applies the replayed one
+		static void processFrame();
+
+		static bool recording;
+		static bool replaying;
+		static uint32_t frame;
+
+		static std::ofstream file;
+		// Input changes of the frame being recorded
+		static std::vector<Event> pendingEvents;
+
+		// Events of every replayed frame, events of frame n start at replayFrames[n]
+		static std::vector<Event> replayEvents;
+		static std::vector<size_t> replayFrames;
+		static size_t replayFrame;
+	};
+}
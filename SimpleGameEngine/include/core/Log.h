@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define SG_LOG_LEVEL_TRACE 0
+#define SG_LOG_LEVEL_DEBUG 1
+#define SG_LOG_LEVEL_INFO 2
+#define SG_LOG_LEVEL_WARNING 3
+#define SG_LOG_LEVEL_ERROR 4
+#define SG_LOG_LEVEL_OFF 5
+
+// Records below this level are compiled out along with their arguments
+#ifndef SG_LOG_LEVEL
+#ifdef _DEBUG
+#define SG_LOG_LEVEL SG_LOG_LEVEL_DEBUG
+#else
+#define SG_LOG_LEVEL SG_LOG_LEVEL_INFO
+#endif
+#endif
+
+// Characters kept per record, longer messages are truncated
+#define LOG_MESSAGE_SIZE 240
+// Records a thread can write before the background thread drains them, later ones are dropped
+#define LOG_RECORDS_PER_THREAD 1024
+
+#if defined(__GNUC__)
+#define SG_LOG_PRINTF_FORMAT(formatIndex, firstArgument) __attribute__((format(printf, formatIndex, firstArgument)))
+#else
+#define SG_LOG_PRINTF_FORMAT(formatIndex, firstArgument)
+#endif
+
+// Log a message formatted with printf syntax, e.g. SG_LOG_WARNING("Failed to load %s", path.c_str())
+#if SG_LOG_LEVEL <= SG_LOG_LEVEL_TRACE
+#define SG_LOG_TRACE(...) ::sg::Log::write(::sg::LogLevel::Trace, __VA_ARGS__)
+#else
+#define SG_LOG_TRACE(...) ((void)0)
+#endif
+#if SG_LOG_LEVEL <= SG_LOG_LEVEL_DEBUG
+#define SG_LOG_DEBUG(...) ::sg::Log::write(::sg::LogLevel::Debug, __VA_ARGS__)
+#else
+#define SG_LOG_DEBUG(...) ((void)0)
+#endif
+#if SG_LOG_LEVEL <= SG_LOG_LEVEL_INFO
+#define SG_LOG_INFO(...) ::sg::Log::write(::sg::LogLevel::Info, __VA_ARGS__)
+#else
+#define SG_LOG_INFO(...) ((void)0)
+#endif
+#if SG_LOG_LEVEL <= SG_LOG_LEVEL_WARNING
+#define SG_LOG_WARNING(...) ::sg::Log::write(::sg::LogLevel::Warning, __VA_ARGS__)
+#else
+#define SG_LOG_WARNING(...) ((void)0)
+#endif
+#if SG_LOG_LEVEL <= SG_LOG_LEVEL_ERROR
+#define SG_LOG_ERROR(...) ::sg::Log::write(::sg::LogLevel::Error, __VA_ARGS__)
+#else
+#define SG_LOG_ERROR(...) ((void)0)
+#endif
+
+namespace sg
+{
+	enum class LogLevel
+	{
+		Trace = SG_LOG_LEVEL_TRACE,
+		Debug = SG_LOG_LEVEL_DEBUG,
+		Info = SG_LOG_LEVEL_INFO,
+		Warning = SG_LOG_LEVEL_WARNING,
+		Error = SG_LOG_LEVEL_ERROR
+	};
+
+	/*
+		Asynchronous logging. A record is formatted on the calling thread into that thread's ring buffer,
+		without allocating, and a background thread writes the records of every thread to a file or stderr.
+		The thread starts with the first record and sleeps until records are written, the first record
+		after it drains briefly takes a lock to wake it. Logging never waits for I/O: when a ring is full
+		its new records are dropped and counted. While the log isn't open, records are written to stderr directly.
+		The window opens the log, see WindowOptions::logPath.
+	*/
+	class Log
+	{
+	public:
+		// Append records to path, or write them to stderr when path is empty. The background thread starts
+		// when the first record is written. Returns false if the file can't be opened
+		static bool open(const std::string& path = "");
+		// Write every pending record and stop the background thread
+		static void close();
+		static bool isOpen();
+
+		// Records below this level are skipped at runtime, records below SG_LOG_LEVEL aren't even compiled
+		static void setLevel(LogLevel level);
+		static LogLevel getLevel();
+
+		// Write pending records now instead of waiting for the background thread
+		static void flush();
+		// Number of records lost because their thread's ring was full
+		static uint64_t getDroppedCount();
+
+		// Format a record with printf syntax. Use the SG_LOG_* macros so records can be compiled out
+		static void write(LogLevel level, const char* format, ...) SG_LOG_PRINTF_FORMAT(2, 3);
+
+	private:
+		Log() = delete;
+		Log(const Log&) = delete;
+		Log& operator=(const Log&) = delete;
+		Log(Log&&) = delete;
+	};
+}
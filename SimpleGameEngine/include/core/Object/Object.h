@@ -153,11 +153,11 @@ namespace sg
 			}
 		}
 
+		// Append matching components of this object and its children to the provided vector.
+		// Useful to reuse the same vector instead of allocating a new one every call
 		template <typename T>
-		std::vector<T*> getComponents() const
+		void getComponents(std::vector<T*>& components) const
 		{
-			std::vector<T*> components;
-			// Add all matching components of this object
 			for (Component* comp : m_components)
 			{
 				if (T* cast = dynamic_cast<T*>(comp))
@@ -166,13 +166,18 @@ namespace sg
 				}
 			}
 
-			// Insert all matching components of children as well
 			for (Object* child : m_children)
 			{
-				std::vector<T*> childComps = child->getComponents<T>();
-				components.insert(components.end(), childComps.begin(), childComps.end());
+				child->getComponents<T>(components);
 			}
+		}
 
+		template <typename T>
+		std::vector<T*> getComponents() const
+		{
+			// Children append to the same vector instead of returning their own
+			std::vector<T*> components;
+			getComponents<T>(components);
 			return components;
 		}
 
@@ -254,7 +259,8 @@ namespace sg
 		void setSize(const vec2& newSize) { m_data.size = newSize; }
 		bool isScreenPosition() const { return m_data.screenPosition; }
 		bool isVisible() const { return m_data.visible; }
-		void setVisibility(bool newVisibility) { m_data.visible = newVisibility; }
+		// Static tiles of the object are baked again when its visibility changes
+		void setVisibility(bool newVisibility);
 		bool shouldDrawDebug() const { return m_data.drawDebug; }
 	};
 }
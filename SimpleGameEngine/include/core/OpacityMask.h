@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <vector>
+
+// Width and height in pixels of the texture cells checked for transparency
+#define OPACITY_CELL_SIZE 8
+
+namespace sg
+{
+	/*
+		Coarse map of the opaque parts of an image, built once when a texture is loaded.
+		The image is split in cells flagged as translucent if any of their pixels isn't fully opaque.
+		A source rectangle is opaque when every cell it overlaps is opaque, which is exact for
+		sprite sheets and tilesets whose frames are aligned on the cell size.
+	*/
+	class OpacityMask
+	{
+	public:
+		explicit OpacityMask(SDL_Surface* surface);
+
+		// Returns true if every pixel of the source rectangle is fully opaque
+		bool isOpaque(const SDL_Rect& source) const;
+		bool isFullyOpaque() const { return m_fullyOpaque; }
+
+	private:
+		int m_width = 0;
+		int m_height = 0;
+		int m_cellsX = 0;
+		int m_cellsY = 0;
+		bool m_fullyOpaque = false;
+		// Summed area table of translucent cells, (m_cellsX + 1) * (m_cellsY + 1) elements
+		std::vector<unsigned int> m_translucentCells;
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Width and height in pixels of the screen tiles write counts are accumulated in
+#define OVERDRAW_TILE_SIZE 16
+// Number of bytes written or read per pixel, render targets are 32 bits per pixel
+#define OVERDRAW_BYTES_PER_PIXEL 4
+
+namespace sg
+{
+	/*
+		Diagnostic accumulating how many times screen pixels are written each frame.
+		Every drawable recorded adds its on-screen area to the tiles it overlaps, and its cost
+		to the statistics of its object name and texture path, accumulated over frames until reset.
+		Blended drawables read the pixels below on top of writing them, which doubles their fill cost.
+	*/
+	class OverdrawAnalyzer
+	{
+	public:
+		// Start a frame on a width x height screen
+		void beginFrame(int width, int height);
+		// Record a drawable writing the on-screen part of destination. Destination is in screen pixels,
+		// scale is the resolution the drawable is actually rasterized at
+		void record(const SDL_Rect& destination, bool blended, const std::string& objectName,
+			const std::string& texturePath, float scale = 1.f);
+
+		// Colored tiles over the screen, from blue for pixels written once to red for 5 times or more
+		void drawHeatmap(SDL_Renderer* renderer);
+
+		// Pixels written per screen pixel during the last frame
+		float getOverdraw() const;
+		// Write a summary of the frames recorded since the last reset followed by the most expensive
+		// drawables. Returns false if the file can't be written
+		bool writeReport(const std::string& path, size_t count) const;
+		// Forget every recorded frame
+		void reset();
+
+	private:
+		struct Entry
+		{
+			// Number of times the drawable was recorded
+			size_t draws = 0;
+			double pixels = 0.0;
+			double blendedBytes = 0.0;
+
+			// Pixels written plus pixels read for blending, in bytes
+			double fillBytes() const { return pixels * OVERDRAW_BYTES_PER_PIXEL + blendedBytes; }
+		};
+
+		int m_width = 0;
+		int m_height = 0;
+		int m_tilesX = 0;
+		int m_tilesY = 0;
+		// Pixels written in each tile this frame
+		std::vector<unsigned int> m_tilePixels;
+		double m_framePixels = 0.0;
+
+		size_t m_numFrames = 0;
+		double m_totalPixels = 0.0;
+		double m_totalBlendedBytes = 0.0;
+		// Keyed by object name and texture path
+		std::map<std::pair<std::string, std::string>, Entry> m_entries;
+
+		// Tile rectangles gathered per heatmap color
+		std::vector<SDL_Rect> m_heatRects[5];
+	};
+}
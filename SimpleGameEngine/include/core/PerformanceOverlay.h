@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <vector>
+
+#include "core/Cache.h"
+
+// Number of frames shown in the frame time graph
+#define OVERLAY_GRAPH_FRAMES 120
+// Frame time in seconds corresponding to the top of the graph
+#define OVERLAY_GRAPH_MAX_TIME 0.05f
+
+namespace sg
+{
+	// Time in seconds spent in each part of a frame
+	struct FrameTimings
+	{
+		float update = 0.f;
+		float draw = 0.f;
+		float present = 0.f;
+		// Whole frame, including time spent waiting for the frame limiter
+		float frame = 0.f;
+	};
+
+	struct PerformanceCounters
+	{
+		size_t objects = 0;
+		size_t drawables = 0;
+		unsigned int drawCalls = 0;
+		// Drawables and static chunks skipped because they were hidden
+		unsigned int culled = 0;
+		// Pixels written per screen pixel, 0 when overdraw analysis is off
+		float overdraw = 0.f;
+		// Scale the world is rendered at
+		float resolutionScale = 1.f;
+		CacheStatistics textureCache;
+		CacheStatistics animationCache;
+	};
+
+	/*
+		Overlay showing a rolling frame time graph, the split between update, draw and present,
+		and engine counters. Text uses a built-in pixel font so the overlay only needs a handful
+		of batched rectangle draw calls and doesn't depend on any font file.
+	*/
+	class PerformanceOverlay
+	{
+	public:
+		PerformanceOverlay();
+
+		void setVisible(bool visible) { m_visible = visible; }
+		bool isVisible() const { return m_visible; }
+
+		// Frames are recorded even when the overlay is hidden so the graph is filled when it shows up
+		void addFrame(const FrameTimings& timings);
+		void draw(SDL_Renderer* renderer, const PerformanceCounters& counters);
+
+	private:
+		enum Series { Update, Draw, Present, Other, NumSeries };
+
+		void buildGraph(int x, int y);
+		// Append the pixels of a line of text, returns the height of the line
+		int addText(int x, int y, const char* text);
+
+		bool m_visible = false;
+
+		std::vector<FrameTimings> m_frames;
+		size_t m_nextFrame = 0;
+
+		// Rectangles are gathered per color and drawn in a single call each
+		std::vector<SDL_Rect> m_bars[NumSeries];
+		std::vector<SDL_Rect> m_guides;
+		std::vector<SDL_Rect> m_textPixels;
+	};
+}
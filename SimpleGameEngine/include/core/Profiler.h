@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "core/AllocationTracker.h"
+
+// Scopes recorded per thread before the oldest ones are overwritten
+#define PROFILER_EVENTS_PER_THREAD 65536
+
+// Define SG_DISABLE_PROFILER to compile profile scopes out entirely
+#if defined(SG_DISABLE_PROFILER)
+#define SG_PROFILE_SCOPE(name)
+#else
+#define SG_PROFILE_CONCAT_INNER(a, b) a##b
+#define SG_PROFILE_CONCAT(a, b) SG_PROFILE_CONCAT_INNER(a, b)
+// Time the enclosing scope while the profiler is enabled. name must be a string literal
+#define SG_PROFILE_SCOPE(name) ::sg::ProfileScope SG_PROFILE_CONCAT(sgProfileScope, __LINE__)(name)
+#endif
+
+namespace sg
+{
+	/*
+		Records how long profiled scopes take, on any thread. Each thread writes its scopes to its own
+		ring buffer without locking, so a disabled profiler costs one atomic load per scope and an enabled
+		one two clock reads. Scopes nest naturally: they are written when they end, with their start time.
+		Recorded scopes are exported in Chrome's trace event format, opened by Perfetto or chrome://tracing.
+	*/
+	class Profiler
+	{
+	public:
+		// Start or stop recording scopes, already recorded scopes are kept
+		static void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+		static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+		// Name shown for the calling thread in traces
+		static void setThreadName(const std::string& name);
+
+		// Forget recorded scopes. Call it, as well as writeChromeTrace, while no other thread records scopes,
+		// e.g. between frames on the main thread
+		static void clear();
+
+		// Write recorded scopes as a JSON trace. Returns false if the file can't be written
+		static bool writeChromeTrace(const std::string& path);
+
+		// Nanoseconds on a monotonic clock
+		static uint64_t now();
+		static void record(const char* name, uint64_t start, uint64_t end);
+
+	private:
+		Profiler() = delete;
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		Profiler(Profiler&&) = delete;
+
+		static std::atomic<bool> enabled;
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name)
+			: m_name((Profiler::isEnabled()) ? name : nullptr), m_start((m_name) ? Profiler::now() : 0),
+			// Allocations are attributed to scopes whether the profiler is enabled or not. Scopes are entered in
+			// every build so the class is the same in code built with and without SG_TRACK_ALLOCATIONS
+			m_previousScope(AllocationTracker::enterScope(name))
+		{}
+
+		~ProfileScope()
+		{
+			if (m_name)
+			{
+				Profiler::record(m_name, m_start, Profiler::now());
+			}
+			AllocationTracker::leaveScope(m_previousScope);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_name;
+		uint64_t m_start;
+		const char* m_previousScope;
+	};
+}
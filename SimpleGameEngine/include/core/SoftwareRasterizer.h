@@ -0,0 +1,131 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+// Width and height in pixels of the screen tiles rasterized by a thread at once
+#define RASTER_TILE_SIZE 64
+
+namespace sg
+{
+	// CPU copy of a texture, premultiplied ARGB8888 pixels
+	struct SoftwareImage
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<Uint32> pixels;
+		// Every pixel has full alpha, the image can be copied without blending
+		bool opaque = false;
+		// Blend mode the pixels were converted for, SDL_BLENDMODE_NONE images have full alpha
+		SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+	};
+
+	/*
+		Engine-owned CPU rasterizer for texture copies, used instead of SDL's generic software renderer.
+		Copies are queued then rasterized per screen tile on several threads: opaque images are copied row
+		by row, others are alpha blended with SIMD instructions when available, and horizontal flips
+		reverse rows without going through per-pixel source lookups.
+
+		Only unmodulated copies blended with SDL_BLENDMODE_BLEND or SDL_BLENDMODE_NONE are rasterized.
+		Anything else, e.g. faded or tinted textures and additive blending, is drawn by SDL after calling
+		flush(), which presents queued copies first so drawing order is preserved. Unscaled frames only
+		rasterize and present the tiles copies were queued on since the last flush.
+
+		Images can also be composed on the CPU, e.g. chunks of static tiles, so textures drawn on by the
+		engine don't have to be read back from the renderer.
+	*/
+	class SoftwareRasterizer
+	{
+	public:
+		SoftwareRasterizer() = default;
+		~SoftwareRasterizer() { release(); }
+		SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+		SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+		// CPU copies of textures are only kept once this is enabled
+		static void setKeepingPixels(bool keep);
+		static bool isKeepingPixels() { return keepPixels; }
+		// Keep a copy of the surface a texture was created from
+		static void registerTexture(SDL_Texture* texture, SDL_Surface* surface);
+		// Read back the content of a render target texture, call it again after drawing on the texture
+		static void registerTargetTexture(SDL_Texture* texture);
+		// Copy a region of straight alpha ARGB8888 pixels written to a registered texture, pitch is in bytes
+		static void updateTexture(SDL_Texture* texture, const SDL_Rect& region, const Uint32* pixels, int pitch);
+		static void unregisterTexture(SDL_Texture* texture);
+		static const SoftwareImage* findImage(SDL_Texture* texture);
+
+		// Start composing the transparent width x height image of a texture, replacing its previous image
+		static SoftwareImage& beginImage(SDL_Texture* texture, int width, int height);
+		// Copy a texture on an image, blended like draw() does. Returns false if the texture can't be rasterized
+		static bool drawOnImage(SoftwareImage& image, SDL_Texture* texture, const SDL_Rect* source,
+			const SDL_Rect& destination, SDL_RendererFlip flip);
+		// Upload a composed image to its texture, which must be a texture SDL_UpdateTexture accepts
+		static void endImage(SDL_Texture* texture, SoftwareImage& image);
+
+		// Start a frame drawing on a width x height screen. With a scale lower than 1, copies are rasterized
+		// at a lower resolution and upscaled when presented
+		void begin(SDL_Renderer* renderer, int width, int height, float scale = 1.f);
+		// Queue a texture copy. Returns false if the texture can't be rasterized, it must then be drawn with SDL.
+		// The texture's blend mode, color and alpha modulation are checked on every copy
+		bool draw(SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect& destination, SDL_RendererFlip flip);
+		// Rasterize queued copies and draw them on the renderer's current target
+		void flush();
+		// Release the target texture, must be called before the renderer is destroyed
+		void release();
+
+	private:
+		struct Blit
+		{
+			const SoftwareImage* image;
+			SDL_Rect source;
+			// In rasterized pixels, may extend outside of the screen
+			SDL_Rect destination;
+			SDL_RendererFlip flip;
+		};
+
+		// Pixels being written, pixels points to the pixel at (x, y) and pitch is in bytes
+		struct Target
+		{
+			Uint32* pixels;
+			int pitch;
+			int x;
+			int y;
+
+			Uint32* row(int rowX, int rowY) const { return (Uint32*)((Uint8*)pixels + (size_t)(rowY - y) * pitch) + (rowX - x); }
+		};
+
+		// Fill the image and source of a copy, returns false if the texture can't be rasterized
+		static bool prepareBlit(SDL_Texture* texture, const SDL_Rect* source, SDL_RendererFlip flip, Blit& blit);
+		void rasterizeTile(size_t tile);
+		// clip is at most RASTER_TILE_SIZE pixels wide
+		static void blitRows(const Blit& blit, const SDL_Rect& clip, const Target& output);
+
+		SDL_Renderer* m_renderer = nullptr;
+		SDL_Texture* m_target = nullptr;
+		int m_screenWidth = 0;
+		int m_screenHeight = 0;
+		// Size of the rasterized area, smaller than the screen when scaled down
+		int m_width = 0;
+		int m_height = 0;
+		float m_scale = 1.f;
+		// The first layer of a frame covers the whole screen, later ones are blended over SDL draws
+		bool m_opaqueLayer = true;
+
+		std::vector<Blit> m_blits;
+		int m_tilesX = 0;
+		int m_tilesY = 0;
+		// Indices of the blits overlapping each tile, in drawing order
+		std::vector<std::vector<unsigned int>> m_tileBlits;
+		// Tiles queued blits overlap, in tiles, rasterized and presented by the next flush
+		SDL_Rect m_dirtyTiles{ 0, 0, 0, 0 };
+
+		// Locked target pixels while rasterizing
+		Target m_locked{ nullptr, 0, 0, 0 };
+
+		static bool keepPixels;
+		static std::unordered_map<SDL_Texture*, std::unique_ptr<SoftwareImage>> images;
+	};
+}
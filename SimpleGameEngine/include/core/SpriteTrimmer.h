@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/Texture.h"
+
+// Transparent pixels kept around trimmed frames in the cooked texture so filtering doesn't bleed between frames
+#define TRIMMED_FRAME_PADDING 1
+
+namespace sg
+{
+	struct TrimmedFrame
+	{
+		// Rectangle of the trimmed pixels in the cooked texture
+		SDL_Rect source;
+		// x and y: position of the trimmed pixels in the original frame, w and h: size of the original frame
+		SDL_Rect trim;
+	};
+
+	/*
+		Cooks sprite sheets whose frames have transparent margins. Every frame is trimmed to the
+		bounding box of its visible pixels, and trimmed frames are packed in a new, smaller texture.
+		Drawing the trimmed frame at its offset gives the same result as drawing the original frame,
+		without blending the transparent pixels around it.
+	*/
+	class SpriteTrimmer
+	{
+	public:
+		// Cook frames of the image at imagePath into a texture cached under cacheKey. trimmedFrames receives
+		// one element per frame, in the same order. Frames without visible pixels are trimmed to an empty rectangle.
+		// Throws a TextureException if the image can't be loaded
+		static std::unique_ptr<Texture> cook(const std::string& imagePath, const std::string& cacheKey,
+			const std::vector<SDL_Rect>& frames, std::vector<TrimmedFrame>& trimmedFrames);
+
+	private:
+		SpriteTrimmer() = delete;
+		SpriteTrimmer(const SpriteTrimmer&) = delete;
+		SpriteTrimmer& operator=(const SpriteTrimmer&) = delete;
+	};
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+#include "core/Texture.h"
+#include "core/SoftwareRasterizer.h"
+#include "core/CoverageGrid.h"
+#include "core/OverdrawAnalyzer.h"
+
+// Width and height in pixels of a baked chunk texture
+#define STATIC_CHUNK_SIZE 512
+
+namespace sg
+{
+	class TilesetComponent;
+
+	/*
+		Bakes tiles flagged as static into fixed-size chunk textures.
+		Instead of being drawn one by one every frame, static tiles are rendered once into the chunks
+		they overlap and only visible chunks are drawn. A chunk is baked again when one of its tiles
+		changes index, is shown, hidden or removed.
+		Static tiles never move: their position, size and zIndex are read when they are placed, at the
+		beginning of the frame after their creation, and later changes are ignored. Use a regular tile
+		for anything that moves.
+	*/
+	class StaticTileLayer
+	{
+	public:
+		// Register a static tile. Tiles are placed in chunks at the beginning of the next frame
+		static void add(TilesetComponent* tile);
+		// Unregister a static tile and re-bake the chunks it was drawn in
+		static void remove(TilesetComponent* tile);
+		// Re-bake the chunks this tile is drawn in, call this after changing the tile
+		static void markDirty(const TilesetComponent* tile);
+		// Re-bake every chunk, used when the renderer loses the content of its target textures
+		static void markAllDirty();
+
+	private:
+		StaticTileLayer() = delete;
+		StaticTileLayer(const StaticTileLayer&) = delete;
+		StaticTileLayer& operator=(const StaticTileLayer&) = delete;
+		StaticTileLayer(StaticTileLayer&&) = delete;
+
+		struct Chunk
+		{
+			std::unique_ptr<Texture> texture = nullptr;
+			std::vector<TilesetComponent*> tiles;
+			// Opaque parts of the baked texture relative to the chunk's upper left corner
+			std::vector<SDL_Rect> opaqueRects;
+			bool dirty = true;
+		};
+
+		struct VisibleChunk
+		{
+			Chunk* chunk;
+			// On-screen position of the top left corner before rounding, zoomed
+			vec2 origin;
+			// On-screen rectangle
+			SDL_Rect destination;
+			// Hidden behind opaque drawables this frame
+			bool occluded;
+		};
+
+		// Every chunk of a layer share the same zIndex
+		struct Layer
+		{
+			std::unordered_map<uint64_t, Chunk> chunks;
+			// Chunks overlapping the camera this frame along with their on-screen rectangle
+			std::vector<VisibleChunk> visibleChunks;
+		};
+
+		// Which layer and chunks a placed tile is drawn in
+		struct Placement
+		{
+			int zIndex = 0;
+			std::vector<uint64_t> chunkKeys;
+		};
+
+		friend class Window;
+		// Place pending tiles, find visible chunks and bake the dirty ones.
+		// Returns true if at least one visible chunk was baked
+		static bool beginFrame();
+		// Restart drawing layers from the lowest zIndex
+		static void startDrawing() { nextLayer = layers.begin(); }
+		// Draw visible chunks of every layer with a zIndex lower or equal to the provided one
+		// that haven't been drawn yet this frame. Chunks are queued on the rasterizer if one is provided
+		static void drawUpTo(int zIndex, SoftwareRasterizer* rasterizer = nullptr);
+		// Draw visible chunks of every layer that haven't been drawn yet this frame
+		static void drawRemaining(SoftwareRasterizer* rasterizer = nullptr);
+		// Restart culling layers from the highest zIndex
+		static void startCulling() { nextCulledLayer = layers.rbegin(); }
+		// Visit visible chunks of layers drawn above components with the provided zIndex that haven't been
+		// visited yet, front to back. Chunks hidden by the coverage are skipped when drawing, opaque parts
+		// of the others are added to it
+		static void cullAbove(int zIndex, CoverageGrid& coverage);
+		// Visit visible chunks of every layer that haven't been visited yet
+		static void cullRemaining(CoverageGrid& coverage);
+		// Record the chunks drawn this frame
+		static void recordOverdraw(OverdrawAnalyzer& analyzer, float scale);
+		// Release every chunk texture, must be called before the renderer is destroyed
+		static void quit();
+		// Number of chunks drawn since the beginning of the frame
+		static unsigned int getNumDrawCalls() { return numDrawCalls; }
+		// Number of chunks skipped this frame because they were hidden
+		static unsigned int getNumCulled() { return numCulled; }
+
+		static uint64_t makeKey(int chunkX, int chunkY);
+		static void place(TilesetComponent* tile);
+		static SDL_Rect getChunkDestination(const TilesetComponent* tile, int chunkX, int chunkY);
+		static void bake(Chunk& chunk, int chunkX, int chunkY);
+		// Compose the chunk with the software rasterizer, returns false if a tile can't be rasterized
+		static bool bakeOnCpu(Chunk& chunk, int chunkX, int chunkY);
+		static void drawLayer(Layer& layer, SoftwareRasterizer* rasterizer);
+		static void cullLayer(Layer& layer, CoverageGrid& coverage);
+		// Merge adjacent rectangles of the same height, then of the same width
+		static void mergeRects(std::vector<SDL_Rect>& rects);
+
+		static std::map<int, Layer> layers;
+		static std::unordered_map<const TilesetComponent*, Placement> placements;
+		static std::vector<TilesetComponent*> pendingTiles;
+		static std::map<int, Layer>::iterator nextLayer;
+		static std::map<int, Layer>::reverse_iterator nextCulledLayer;
+		static unsigned int numDrawCalls;
+		static unsigned int numCulled;
+	};
+}
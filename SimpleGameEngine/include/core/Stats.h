@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/Cache.h"
+
+// Number of frame times kept, the longest window percentiles can be computed over
+#define STATS_FRAME_HISTORY 1200
+// Frames longer than this many times the median of the last STATS_STUTTER_WINDOW frames are stutters
+#define STATS_STUTTER_RATIO 2.f
+#define STATS_STUTTER_WINDOW 60
+
+namespace sg
+{
+	// Frame times in seconds over a window of frames
+	struct FrameTimePercentiles
+	{
+		// Number of frames the percentiles were computed over, fewer than requested at startup
+		size_t frames = 0;
+		float p50 = 0.f;
+		float p95 = 0.f;
+		float p99 = 0.f;
+		float max = 0.f;
+	};
+
+	// Engine counters of the last drawn frame, totals are counted since the window was created
+	struct EngineStats
+	{
+		uint64_t frame = 0;
+		// Duration of the last frame in seconds, including time spent waiting for the frame limiter
+		float frameTime = 0.f;
+		size_t objects = 0;
+		size_t components = 0;
+		size_t drawables = 0;
+		unsigned int drawCalls = 0;
+		// Draw calls using another texture than the draw call before them
+		unsigned int textureSwitches = 0;
+		// Drawables and static chunks skipped because they were hidden
+		unsigned int culled = 0;
+		int soundsPlaying = 0;
+		// Heap allocations of the frame, only counted when built with SG_TRACK_ALLOCATIONS
+		uint64_t allocations = 0;
+		uint64_t allocatedBytes = 0;
+		CacheStatistics textureCache;
+		CacheStatistics animationCache;
+		// Frames longer than the frame budget
+		uint64_t totalHitches = 0;
+		// Frames much longer than the frames before them, see STATS_STUTTER_RATIO
+		uint64_t totalStutters = 0;
+		// Decoded images and sounds and parsed files
+		uint64_t totalBytesLoaded = 0;
+	};
+
+	/*
+		Always-on registry of engine statistics, updated by the window once per drawn frame. Scripts read
+		the latest counters and frame time percentiles, and can publish their own named counters. Everything
+		can be appended periodically to a file, one JSON object per line, for dashboards to ingest.
+		Updating costs a few counter copies and one write in a ring of frame times per frame,
+		percentiles are only sorted when asked for.
+	*/
+	class Stats
+	{
+	public:
+		static const EngineStats& get() { return current; }
+
+		// Percentiles of the last frames, at most STATS_FRAME_HISTORY
+		static FrameTimePercentiles getFrameTimes(size_t frames = STATS_FRAME_HISTORY);
+
+		// Frames taking longer than budget seconds count as hitches, 1/60 by default
+		static void setFrameBudget(float seconds) { frameBudget = seconds; }
+		static float getFrameBudget() { return frameBudget; }
+		// Hitches among the last frames, at most STATS_FRAME_HISTORY
+		static size_t getRecentHitches(size_t frames = STATS_FRAME_HISTORY);
+
+		// Named counters published by the game, dumped along with engine counters
+		static void setCounter(const std::string& name, double value) { counters[name] = value; }
+		static void addToCounter(const std::string& name, double amount) { counters[name] += amount; }
+		static double getCounter(const std::string& name);
+
+		// Called when a resource is loaded, from any thread
+		static void addBytesLoaded(uint64_t bytes) { bytesLoaded.fetch_add(bytes, std::memory_order_relaxed); }
+
+		// Append a line of JSON to path every interval seconds of frame time, an empty path stops.
+		// Returns false if the file can't be opened
+		static bool setDumpFile(const std::string& path, float intervalSeconds = 10.f);
+		// Append the current statistics to the dump file now
+		static void dump();
+
+	private:
+		Stats() = delete;
+		Stats(const Stats&) = delete;
+		Stats& operator=(const Stats&) = delete;
+		Stats(Stats&&) = delete;
+
+		friend class Window;
+		// Record a drawn frame. Counters measured by the window are passed in stats, the rest is filled here
+		static void endFrame(const EngineStats& stats);
+
+		static EngineStats current;
+		static float frameBudget;
+		// Ring of frame times, frame n at n % STATS_FRAME_HISTORY
+		static std::vector<float> frameTimes;
+		// Reused to sort frame times
+		static std::vector<float> sortedFrameTimes;
+		static std::map<std::string, double> counters;
+		static std::atomic<uint64_t> bytesLoaded;
+		static double sessionTime;
+
+		static std::ofstream dumpFile;
+		static float dumpInterval;
+		static float timeSinceDump;
+		static uint64_t framesSinceDump;
+		static uint64_t hitchesAtDump;
+		static uint64_t stuttersAtDump;
+	};
+}
@@ -4,10 +4,17 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "core/Cache.h"
+#include "core/OpacityMask.h"
+#include "core/TextureLevels.h"
 #include "core/vec2.h"
 
+// Above this number of modified regions, streaming textures upload their bounding rectangle instead
+#define MAX_DIRTY_PIXEL_REGIONS 8
+
 namespace sg
 {
 	class TextureException : public std::exception
@@ -24,26 +31,76 @@ namespace sg
 	public:
 		Texture(const std::string& path, bool useCache = true);
 		Texture(SDL_Surface* surface);
-		Texture(int width, int height);
+		// Create a texture from a surface generated at runtime and add it to the cache under cacheKey,
+		// other textures then use it by passing the key as path. The surface is freed
+		Texture(SDL_Surface* surface, const std::string& cacheKey);
+		// Target textures are drawn on with renderOnTexture, streaming textures are written on the CPU with lockPixels
+		Texture(int width, int height, SDL_TextureAccess access = SDL_TEXTUREACCESS_TARGET);
 		~Texture();
 
 		void startDrawingOnTexture();
 		void renderOnTexture(const Texture& texture, const vec2 &position = { 0.f, 0.f });
+		// Render a portion of a texture, source and destination rectangles are in pixels
+		void renderOnTexture(const Texture& texture, const SDL_Rect& source, const SDL_Rect& destination, SDL_RendererFlip flip = SDL_FLIP_NONE);
+		// Fill the whole texture with transparent pixels
+		void clear();
 		void stopDrawingOnTexture();
+
+		// Streaming textures keep a CPU copy of their pixels, ARGB8888 with straight alpha, initially transparent.
+		// Returns a pointer to the top left pixel of region, or of the whole texture if it's null, and marks it
+		// as modified. Rows are getPixelPitch() pixels apart. Returns nullptr for other textures, and if region
+		// is empty or not entirely inside the texture
+		Uint32* lockPixels(const SDL_Rect* region = nullptr);
+		void unlockPixels() { m_pixelsLocked = false; }
+		int getPixelPitch() const { return m_width; }
+		// Send regions modified since the last upload to the renderer, only once pixels are unlocked.
+		// Returns true if something was uploaded
+		bool uploadPixels();
 		SDL_Texture* get() const { return (m_texture) ? m_texture : m_cachedTexture->get(); }
+		int getWidth() const { return m_width; }
+		int getHeight() const { return m_height; }
+		// Path of the image the texture was loaded from, empty for other textures
+		const std::string& getPath() const { return m_path; }
+		// Returns true if every pixel drawn from the source rectangle, or the whole texture if it's null,
+		// fully covers what's below. Render target textures are never considered opaque
+		bool isOpaque(const SDL_Rect* source = nullptr) const;
+		// Half resolution levels of textures loaded from images, null for other textures
+		const TextureLevels* getLevels() const { return m_levels.get(); }
+
+		static CacheStatistics getCacheStatistics() { return cachedTextures.getStatistics(); }
+		static bool isCached(const std::string& key) { return cachedTextures.contains(key); }
 	private:
 		// m_cachedTexture is non_null if we are using a texture from the cache
 		std::unique_ptr<CacheRef<std::string, SDL_Texture*>> m_cachedTexture = nullptr;
 		// m_texture is non-null if we are not using the cache
 		SDL_Texture* m_texture = nullptr;
 
+		std::string m_path;
+
+		// Size is queried once when the texture is created
+		int m_width = 0;
+		int m_height = 0;
+
+		// Built when the texture is loaded from an image, shared by textures from the cache
+		std::shared_ptr<const OpacityMask> m_opacity = nullptr;
+		std::shared_ptr<const TextureLevels> m_levels = nullptr;
+
 		bool isTargetTexture = false;
+		// Streaming textures only
+		std::vector<Uint32> m_pixels;
+		std::vector<SDL_Rect> m_dirtyPixels;
+		bool m_pixelsLocked = false;
 		bool initializedTextureDrawing = false;
+		// Render target that was active when startDrawingOnTexture() was called
+		SDL_Texture* m_previousTarget = nullptr;
 
 		void makeTextureFromCache(const std::string& path);
 		void makeTexture(const std::string& path);
+		void querySize();
 
 		static Cache<std::string, SDL_Texture*> cachedTextures;
+		static std::unordered_map<SDL_Texture*, std::shared_ptr<const OpacityMask>> cachedOpacities;
+		static std::unordered_map<SDL_Texture*, std::shared_ptr<const TextureLevels>> cachedLevels;
 	};
 	
 }
\ No newline at end of file
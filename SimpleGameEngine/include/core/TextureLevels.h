@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL_render.h>
+
+#include <vector>
+
+// Maximum number of half resolution levels generated below a texture
+#define TEXTURE_MAX_LEVELS 4
+// Levels stop before their width or height gets below this size in pixels
+#define TEXTURE_LEVEL_MIN_SIZE 16
+
+namespace sg
+{
+	/*
+		Half resolution copies of an image, built once when a texture is loaded. Level n is the image
+		downscaled n times by averaging blocks of 2x2 pixels, colors weighted by alpha so transparent
+		pixels don't darken edges. Drawing a sprite much smaller than its source reads from the level
+		closest to its on-screen size instead of sampling the full resolution texture.
+	*/
+	class TextureLevels
+	{
+	public:
+		// No level is generated for images smaller than twice TEXTURE_LEVEL_MIN_SIZE or if generation is disabled
+		TextureLevels(SDL_Renderer* renderer, SDL_Surface* surface);
+		~TextureLevels();
+		TextureLevels(const TextureLevels&) = delete;
+		TextureLevels& operator=(const TextureLevels&) = delete;
+
+		size_t getCount() const { return m_levels.size(); }
+		// Level 1 is half the size of the image, returns nullptr for level 0
+		SDL_Texture* get(int level) const { return (level > 0) ? m_levels[(size_t)level - 1] : nullptr; }
+
+		// Returns the smallest level still at least as large as destination. source is the rectangle of the
+		// image being drawn, or null for the whole image, and is converted to the returned level.
+		// A part of an image only uses levels it's aligned to and padded for, see setPadding
+		int select(SDL_Rect* source, int width, int height, const SDL_Rect& destination) const;
+
+		// Levels are drawn with the color, alpha, blend and scale modes set on the full resolution texture
+		static void copyModulation(SDL_Texture* from, SDL_Texture* to);
+
+		// Disabled by default, only textures loaded afterwards are affected
+		static void setGenerating(bool generate) { generating = generate; }
+		static bool isGenerating() { return generating; }
+
+		// Pixels of empty or repeated border around every sprite of atlases. Levels average blocks of pixels
+		// and are filtered when drawn, a sprite of an atlas only uses level n if its rectangle is a multiple
+		// of 2^n pixels and is padded with at least 2^n pixels so its neighbours don't bleed into it
+		static void setPadding(int pixels) { padding = pixels; }
+		static int getPadding() { return padding; }
+
+	private:
+		std::vector<SDL_Texture*> m_levels;
+
+		static bool generating;
+		static int padding;
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/Profiler.h"
+
+/*
+	USDT probes of the "sge" provider, for perf, bpftrace and SystemTap on Linux. Each probe compiles
+	to a single nop instruction plus a note in the binary naming it, tools patch the nop when attaching
+	so probes can be used on a production build without rebuilding it:
+
+		bpftrace -l 'usdt:./game:sge:*'
+		bpftrace -e 'usdt:./game:sge:texture_load { @ms = hist(arg1 / 1000000); }'
+
+	Probes are compiled in when <sys/sdt.h> is available (systemtap-sdt-dev or systemtap-sdt-devel),
+	define SG_DISABLE_TRACEPOINTS to compile them out. Arguments are evaluated only when compiled in.
+
+		frame_begin(frame)                         Window::processEvents starts frame number frame
+		frame_end(frame, frameTimeNs, drawCalls)   Window::draw presented it, idle frames have no end
+		object_spawn(object, name)                 Object pointer and name
+		object_destroy(object, name)
+		texture_load(path, durationNs, bytes)      Image decoded into a texture
+		sound_load(path, durationNs, bytes)        Music or sound loaded, bytes is 0 for music
+		parse_load(path, durationNs, bytes)        Parser read a .sgo, .sgworld or .sganim file
+		texture_cache_hit(key), texture_cache_miss(key)
+		animation_cache_hit(path), animation_cache_miss(path)
+*/
+
+#if !defined(SG_DISABLE_TRACEPOINTS) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SG_TRACEPOINTS_ENABLED
+#endif
+#endif
+
+#if defined(SG_TRACEPOINTS_ENABLED)
+#define SG_TRACE1(name, a) STAP_PROBE1(sge, name, a)
+#define SG_TRACE2(name, a, b) STAP_PROBE2(sge, name, a, b)
+#define SG_TRACE3(name, a, b, c) STAP_PROBE3(sge, name, a, b, c)
+// Nanoseconds used to measure probe durations, skipped when probes are compiled out
+#define SG_TRACE_NOW() ::sg::Profiler::now()
+#else
+// Arguments are referenced but not evaluated
+#define SG_TRACE1(name, a) ((void)sizeof(a))
+#define SG_TRACE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define SG_TRACE3(name, a, b, c) ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+#define SG_TRACE_NOW() ((uint64_t)0)
+#endif
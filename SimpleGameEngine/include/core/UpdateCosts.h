@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Number of frames rolling averages and percentiles are computed over
+#define UPDATE_COST_HISTORY 300
+
+namespace sg
+{
+	// Update cost of every script or component of one type, times in milliseconds
+	struct UpdateCostSummary
+	{
+		std::string name;
+		// Per frame over the last UPDATE_COST_HISTORY frames
+		double average = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+		double callsPerFrame = 0.0;
+		// Since tracking started
+		double total = 0.0;
+		uint64_t totalCalls = 0;
+	};
+
+	/*
+		Attributes the time spent in ScriptComponent::update and Updatable::update to the dynamic type
+		of the script or component, named from RTTI. Frame totals per type are kept over the last frames
+		to find which types make frames slow, not only which are expensive on average.
+		Tracking costs two clock reads per update and is disabled by default.
+	*/
+	class UpdateCosts
+	{
+	public:
+		static void setEnabled(bool enable) { enabled = enable; }
+		static bool isEnabled() { return enabled; }
+
+		// Called by Game::dispatchUpdates around the updates of a frame
+		static void beginFrame();
+		static void endFrame();
+		// Add an update of the given type that started at start and just ended
+		static void record(const std::type_info& type, std::chrono::steady_clock::time_point start);
+
+		// The count types with the highest average cost per frame, most expensive first
+		static std::vector<UpdateCostSummary> getTop(size_t count);
+		// Write getTop(count) to a file. Returns false if the file can't be written
+		static bool writeReport(const std::string& path, size_t count = 20);
+		// Forget every measure
+		static void reset();
+
+	private:
+		UpdateCosts() = delete;
+		UpdateCosts(const UpdateCosts&) = delete;
+		UpdateCosts& operator=(const UpdateCosts&) = delete;
+		UpdateCosts(UpdateCosts&&) = delete;
+
+		struct Entry
+		{
+			std::string name;
+			double frameSeconds = 0.0;
+			unsigned int frameCalls = 0;
+			// Ring of per frame costs and calls, frame n at n % UPDATE_COST_HISTORY
+			std::vector<float> history;
+			std::vector<unsigned int> historyCalls;
+			double totalSeconds = 0.0;
+			uint64_t totalCalls = 0;
+		};
+
+		static bool enabled;
+		static std::unordered_map<std::type_index, size_t> indices;
+		static std::vector<Entry> entries;
+		// Entry of the last recorded type, consecutive updates are often of the same type
+		static std::type_index lastType;
+		static size_t lastIndex;
+		static uint64_t numFrames;
+	};
+}
@@ -9,8 +9,25 @@
 #include <vector>
 #include <exception>
 #include <string>
+#include <memory>
 
 #include "Camera.h"
+#include "Texture.h"
+#include "DirtyRegions.h"
+#include "DrawCommand.h"
+#include "FrameLimiter.h"
+#include "PerformanceOverlay.h"
+#include "DynamicResolution.h"
+#include "SoftwareRasterizer.h"
+#include "CoverageGrid.h"
+#include "OverdrawAnalyzer.h"
+#include "FrameCapture.h"
+#include "Profiler.h"
+#include "UpdateCosts.h"
+#include "InputRecorder.h"
+#include "Stats.h"
+#include "AllocationTracker.h"
+#include "Log.h"
 
 namespace sg
 {
@@ -23,15 +40,79 @@ namespace sg
 		std::string m_message;
 	};
 
+	struct WindowOptions
+	{
+		// Wait for the display's vertical refresh when presenting a frame
+		bool vsync = true;
+		// Maximum number of frames per second, 0 means uncapped
+		unsigned int frameRateLimit = 0;
+		// Use SDL's software renderer instead of an accelerated one
+		bool softwareRenderer = false;
+		// Use SDL's dummy video and audio drivers, nothing is shown or heard. Implies softwareRenderer.
+		// Along with vsync off and an input replay, runs a recorded session as fast as possible
+		bool headless = false;
+		// Fall back to the software renderer if no accelerated renderer can be created
+		bool softwareFallback = true;
+		// Draw sprites and tiles with the engine's CPU rasterizer when using the software renderer
+		bool softwareRasterizer = true;
+		// Skip drawables and static tiles hidden behind opaque drawables, see Window::setOcclusionCulling
+		bool occlusionCulling = false;
+		// Generate half resolution levels of loaded images, drawn instead of the image when it's shrunk on screen
+		bool textureLevels = false;
+		// Border in pixels around sprites of atlases, parts of images only use levels they're padded for.
+		// See TextureLevels::setPadding
+		int textureLevelPadding = 0;
+		// Wait for events instead of redrawing identical frames, see Window::setIdleRendering
+		bool idleRendering = false;
+		// Longest time in milliseconds spent waiting for events when idle
+		unsigned int idleTimeout = 100;
+		// Key showing or hiding the performance overlay, SDLK_UNKNOWN to disable
+		SDL_Keycode performanceOverlayKey = SDLK_F3;
+		// Key turning overdraw analysis on or off, SDLK_UNKNOWN to disable
+		SDL_Keycode overdrawKey = SDLK_UNKNOWN;
+		// Report written when overdraw analysis is turned off with overdrawKey, empty to disable
+		std::string overdrawReportPath;
+		// Key starting or stopping the profiler, SDLK_UNKNOWN to disable. See Profiler
+		SDL_Keycode profilerKey = SDLK_UNKNOWN;
+		// Chrome trace written when the profiler is stopped with profilerKey, empty to disable
+		std::string profilerTracePath;
+		// Measure the update cost of every script and component type, see UpdateCosts
+		bool trackUpdateCosts = false;
+		// Report of the most expensive types written when the window is destroyed, empty to disable
+		std::string updateCostReportPath = "update_costs.txt";
+		// Record input of every frame to this file until the window is destroyed, empty to disable. See InputRecorder
+		std::string inputRecordPath;
+		// Seconds simulated by every update while recording
+		float inputRecordDelta = 1.f / 60.f;
+		// Replay input recorded in this file instead of the user's, empty to disable.
+		// processEvents() returns false once every recorded frame has been played
+		std::string inputReplayPath;
+		// Frames longer than this many seconds count as hitches in Stats
+		float frameBudget = 1.f / 60.f;
+		// Append engine statistics to this file every statsDumpInterval seconds, empty to disable. See Stats
+		std::string statsDumpPath;
+		float statsDumpInterval = 10.f;
+		// Report of the call sites allocating the most written when the window is destroyed, empty to disable.
+		// Only written when the engine is built with SG_TRACK_ALLOCATIONS, see AllocationTracker
+		std::string allocationReportPath = "allocations.txt";
+		// Throw a WindowException when a frame allocates once this many frames were drawn, 0 to disable.
+		// Requires SG_TRACK_ALLOCATIONS. Keeps the steady state of a game or benchmark free of allocations
+		unsigned int allocationFreeAfterFrames = 0;
+		// Append log records to this file, or write them to stderr when empty. Not used if the log was
+		// already opened before the window was created. See Log
+		std::string logPath;
+	};
+
 	class Object;
 	class Window
 	{
 	public:
-		Window(const char* title, unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+		Window(const char* title, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+			const WindowOptions& options = WindowOptions());
 		~Window();
 
 		// Processes events and updates engine components. Returns false when a exit event is triggered
-		bool processEvents() const;
+		bool processEvents();
 
 		// Set the logical size for this window's renderer. The logical size is used to
 		// keep proportions when resizing window
@@ -44,10 +125,87 @@ namespace sg
 
 		void draw();
 
+		// Turn vsync on or off, returns false if the renderer doesn't support it
+		bool setVSync(bool enabled);
+		bool isVSyncEnabled() const { return m_vsync; }
+
+		// Cap the number of frames per second, 0 removes the limit.
+		// Turn vsync off as well to run uncapped
+		void setFrameRateLimit(unsigned int frameRate);
+		unsigned int getFrameRateLimit() const { return m_frameLimiter.getTargetFrameRate(); }
+
+		bool isSoftwareRenderer() const { return m_softwareRenderer; }
+
+		// Only available with the software renderer when WindowOptions::softwareRasterizer was set,
+		// used when the world is drawn on screen directly (not in dirty rect mode)
+		void setSoftwareRasterizer(bool enabled) { m_rasterizerEnabled = enabled && SoftwareRasterizer::isKeepingPixels(); }
+		bool isSoftwareRasterizerEnabled() const { return m_rasterizerEnabled; }
+
+		// When enabled, frames identical to the previous one are neither drawn nor presented and
+		// processEvents() then blocks until an event arrives or the idle timeout expires, so the game uses
+		// almost no CPU while nothing happens. The window doesn't go idle while a visible component
+		// is animating or a script called Game::requestTick() during the last update
+		void setIdleRendering(bool enabled);
+		bool isIdleRenderingEnabled() const { return m_idleRendering; }
+		void setIdleTimeout(unsigned int milliseconds) { m_idleTimeout = milliseconds; }
+		// Returns true if the last frame was skipped because nothing changed
+		bool isIdle() const { return m_idle; }
+
+		// Drawables are visited front to back to find the ones entirely hidden behind opaque textures,
+		// which are then not drawn. Textures are checked for transparency when loaded
+		void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+		bool isOcclusionCullingEnabled() const { return m_occlusionCulling; }
+
+		// Render the world in an off-screen target at a lower scale, upscaled when drawn on screen.
+		// The scale adapts within the provided bounds to reach the target frame time, vsync waits
+		// count as frame time so turn vsync off for the scale to adapt. Drawables of screen-position
+		// objects and objects on LAYER_UI stay at native resolution and are drawn above the world
+		void enableDynamicResolution(const DynamicResolutionSettings& settings = DynamicResolutionSettings());
+		void disableDynamicResolution();
+		bool isDynamicResolutionEnabled() const { return m_dynamicResolutionEnabled; }
+		// Scale the world is currently rendered at, 1 when dynamic resolution is disabled
+		float getResolutionScale() const { return (m_dynamicResolutionEnabled) ? m_dynamicResolution.getScale() : 1.f; }
+
+		// Show frame times and engine counters over the game, available in every build configuration
+		void setPerformanceOverlayVisible(bool visible) { m_performanceOverlay.setVisible(visible); }
+		bool isPerformanceOverlayVisible() const { return m_performanceOverlay.isVisible(); }
+
+		// Show how many times each part of the screen is written per frame with a heatmap over the game,
+		// and gather the fill cost of drawables by object name and texture path. Each frame is measured
+		// as if it was fully redrawn, including in dirty rect mode. Turning it on starts a new report
+		void setOverdrawAnalysis(bool enabled);
+		bool isOverdrawAnalysisEnabled() const { return m_overdrawAnalysis; }
+		// Write the frames analyzed so far and the count most expensive drawables to a file.
+		// Returns false if the file can't be written
+		bool writeOverdrawReport(const std::string& path, size_t count = 20) const { return m_overdraw.writeReport(path, count); }
+
+		// Copy every presented frame, or one every settings.frameInterval frames, into a ring of shared
+		// memory buffers read by another process. Frames keep the renderer's output size at the time
+		// capture starts. Returns false if the shared memory can't be created
+		bool startFrameCapture(const FrameCaptureSettings& settings = FrameCaptureSettings());
+		void stopFrameCapture() { m_frameCapture.stop(); }
+		// Gives access to the shared memory file descriptor and capture statistics
+		const FrameCapture& getFrameCapture() const { return m_frameCapture; }
+
+		// In dirty rect mode only screen regions where drawables changed are redrawn on top of a
+		// persistent back buffer. Useful for mostly static screens like menus or turn based boards
+		void setDirtyRectMode(bool enabled);
+		bool isDirtyRectModeEnabled() const { return m_dirtyRectMode; }
+
+		// When enabled, drawables of screen-position objects and objects on LAYER_UI are rendered in
+		// their own cached texture, drawn again only when one of them changes, and composited over the world.
+		// The user interface is then always drawn above the world regardless of zIndex
+		void setUILayerCaching(bool enabled);
+		bool isUILayerCachingEnabled() const { return m_uiLayerCaching; }
+
 		static SDL_Renderer* getRenderer() { return instance->m_renderer; }
 		static Camera* getCamera() { return instance->m_camera; }
 		static const vec2& getCameraTopLeft() { return instance->m_cameraTopLeft; }
+		// Zoom of the camera used this frame, always greater than zero
+		static float getCameraZoom() { return instance->m_cameraZoom; }
 		static const vec2& getWindowSize() { return instance->m_windowSize; }
+		// Frame times measured over the last frames
+		static FramePacing getFramePacing() { return instance->m_frameLimiter.getPacing(); }
 
 	private:
 		Window(const Window&) = delete;
@@ -56,18 +214,124 @@ namespace sg
 		static Window* instance;
 
 		void updateTopLeftCameraPosition();
-		void drawTexture(const Object* object, class DrawableComponent* component);
-		void drawTexturePortion(const Object* object, class DrawableComponent* component);
+		void submit(const DrawCommand& command);
+		// Collect visible drawable components of every object
+		void gatherDrawables();
+		// Returns true if draw commands or the camera differ from the ones of the last drawn frame
+		bool sceneChanged();
+		// Flag world draw commands and static chunks hidden behind opaque drawables
+		void cullOccludedDrawables();
+		// Submit every draw command, or only the ones overlapping region if it's not null
+		void drawScene(const SDL_Rect* region = nullptr);
+		void drawDirtyRegions(bool redrawAll);
+		void drawUserInterfaceLayer();
+		void drawScaledWorld();
+		void drawRasterizedWorld();
+		// Draw user interface commands directly on screen
+		void drawUserInterface();
+		// Returns true if the command should be drawn with the rest of the world
+		bool isWorldCommand(const DrawCommand& command) const
+		{
+			return !((m_uiLayerCaching || m_dynamicResolutionEnabled) && command.userInterface);
+		}
+		// Record what was drawn this frame and draw the heatmap
+		void analyzeOverdraw();
 		void drawDebugs();
-		vec2 positionCamRelative(const vec2& position) const { return position - m_cameraTopLeft; }
-		std::vector<std::tuple<Object*, class DrawableComponent*>> getAllDrawableObjects();
+		void drawPerformanceOverlay();
+		// End the frame of the allocation tracker, throws if a frame allocated in steady state
+		void endAllocationFrame();
+		vec2 positionCamRelative(const vec2& position) const { return (position - m_cameraTopLeft) * m_cameraZoom; }
 
 	private:
 		SDL_Window* m_window = nullptr;
 		SDL_Renderer* m_renderer = nullptr;
 		vec2 m_windowSize;
 
+		bool m_vsync = true;
+		bool m_softwareRenderer = false;
+		FrameLimiter m_frameLimiter;
+
+		SDL_Keycode m_performanceOverlayKey = SDLK_UNKNOWN;
+		PerformanceOverlay m_performanceOverlay;
+		FrameTimings m_frameTimings;
+		unsigned int m_drawCalls = 0;
+		unsigned int m_textureSwitches = 0;
+		// Texture of the last submitted draw command
+		SDL_Texture* m_lastTexture = nullptr;
+
+		SDL_Keycode m_overdrawKey = SDLK_UNKNOWN;
+		std::string m_overdrawReportPath;
+		bool m_overdrawAnalysis = false;
+		OverdrawAnalyzer m_overdraw;
+
+		SDL_Keycode m_profilerKey = SDLK_UNKNOWN;
+		std::string m_profilerTracePath;
+		std::string m_updateCostReportPath;
+		std::string m_allocationReportPath;
+		unsigned int m_allocationFreeAfterFrames = 0;
+		bool m_quitAfterReplay = false;
+		// The window opened the log and closes it when destroyed
+		bool m_closeLog = false;
+
+		// Reused every frame by drawDebugs
+		std::vector<class BoxComponent*> m_debugBoxes;
+		std::vector<SDL_Rect> m_debugRects;
+
 		Camera* m_camera;
 		vec2 m_cameraTopLeft;
+		float m_cameraZoom = 1.f;
+
+		std::vector<class DrawableComponent*> m_drawables;
+		// Reused every frame by gatherDrawables
+		std::vector<Object*> m_orphans;
+		std::vector<class DrawableComponent*> m_objectDrawables;
+		DrawCommandBuffer m_drawCommands;
+		// A gathered drawable is animating this frame
+		bool m_animating = false;
+
+		bool m_idleRendering = false;
+		unsigned int m_idleTimeout = 100;
+		bool m_idle = false;
+		// Frames were skipped since the last drawn frame, its timings include the idle time
+		bool m_skippedFrames = false;
+		// Set by window events, the next frame is drawn even if nothing changed
+		bool m_forceRedraw = true;
+		// Delay between two skipped frames when the window can't wait for events
+		Uint32 m_refreshInterval = 16;
+		// Draw commands and camera of the last drawn frame
+		std::vector<DrawCommand> m_previousCommands;
+		vec2 m_previousCameraTopLeft{ 0.f, 0.f };
+		float m_previousCameraZoom = 1.f;
+
+		bool m_dirtyRectMode = false;
+		DirtyRegions m_dirtyRegions;
+		std::unique_ptr<Texture> m_backBuffer = nullptr;
+		int m_backBufferWidth = 0;
+		int m_backBufferHeight = 0;
+		// Camera the back buffer was drawn with, static tiles aren't tracked and move along with it
+		vec2 m_backBufferCameraTopLeft{ 0.f, 0.f };
+		float m_backBufferCameraZoom = 1.f;
+
+		bool m_uiLayerCaching = false;
+		bool m_uiLayerDirty = true;
+		std::unique_ptr<Texture> m_uiLayer = nullptr;
+		// User interface commands the cached texture was rendered with
+		std::vector<DrawCommand> m_uiCommands;
+
+		bool m_dynamicResolutionEnabled = false;
+		DynamicResolution m_dynamicResolution;
+		// Off-screen target the world is rendered in, only its top left part is used below full scale
+		std::unique_ptr<Texture> m_worldBuffer = nullptr;
+
+		bool m_rasterizerEnabled = false;
+		SoftwareRasterizer m_rasterizer;
+		// Non-null while the world is drawn by the rasterizer
+		SoftwareRasterizer* m_activeRasterizer = nullptr;
+
+		FrameCapture m_frameCapture;
+
+		bool m_occlusionCulling = false;
+		CoverageGrid m_coverage;
+		unsigned int m_numCulled = 0;
 	};
 }
\ No newline at end of file
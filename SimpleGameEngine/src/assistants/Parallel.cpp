@@ -0,0 +1,154 @@
+#include "assistants/Parallel.h"
+#include "core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sg
+{
+	namespace
+	{
+		// Worker threads are started on first use and live until the program exits
+		class WorkerPool
+		{
+		public:
+			WorkerPool()
+			{
+				unsigned int hardwareThreads = std::thread::hardware_concurrency();
+				unsigned int numWorkers = (hardwareThreads > 1) ? hardwareThreads - 1 : 0;
+
+				for (unsigned int i = 0; i < numWorkers; ++i)
+				{
+					m_workers.emplace_back([this, i]()
+						{
+							Profiler::setThreadName("Worker " + std::to_string(i + 1));
+							workerLoop();
+						});
+				}
+			}
+
+			~WorkerPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_quit = true;
+				}
+				m_wakeWorkers.notify_all();
+
+				for (std::thread& worker : m_workers)
+				{
+					worker.join();
+				}
+			}
+
+			unsigned int getNumThreads() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+			void run(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& job)
+			{
+				// Only one range is processed at a time
+				std::lock_guard<std::mutex> runLock(m_runMutex);
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_job = &job;
+					m_count = count;
+					m_batchSize = batchSize;
+					m_nextBatch = 0;
+					m_activeWorkers = static_cast<unsigned int>(m_workers.size());
+					++m_generation;
+				}
+				m_wakeWorkers.notify_all();
+
+				processBatches();
+
+				// Wait for workers to finish their last batch
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_workersDone.wait(lock, [this]() { return m_activeWorkers == 0; });
+				m_job = nullptr;
+			}
+
+		private:
+			void processBatches()
+			{
+				size_t begin;
+				while ((begin = m_nextBatch.fetch_add(m_batchSize)) < m_count)
+				{
+					SG_PROFILE_SCOPE("Parallel batch");
+					(*m_job)(begin, std::min(begin + m_batchSize, m_count));
+				}
+			}
+
+			void workerLoop()
+			{
+				unsigned long long seenGeneration = 0;
+
+				while (true)
+				{
+					{
+						std::unique_lock<std::mutex> lock(m_mutex);
+						m_wakeWorkers.wait(lock, [&]() { return m_quit || m_generation != seenGeneration; });
+
+						if (m_quit) return;
+						seenGeneration = m_generation;
+					}
+
+					processBatches();
+
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						--m_activeWorkers;
+					}
+					m_workersDone.notify_one();
+				}
+			}
+
+			std::vector<std::thread> m_workers;
+			std::mutex m_runMutex;
+			std::mutex m_mutex;
+			std::condition_variable m_wakeWorkers;
+			std::condition_variable m_workersDone;
+
+			const std::function<void(size_t, size_t)>* m_job = nullptr;
+			size_t m_count = 0;
+			size_t m_batchSize = 0;
+			std::atomic<size_t> m_nextBatch{ 0 };
+			unsigned int m_activeWorkers = 0;
+			unsigned long long m_generation = 0;
+			bool m_quit = false;
+		};
+
+		WorkerPool& getPool()
+		{
+			static WorkerPool pool;
+			return pool;
+		}
+	}
+
+	void Parallel::forRange(size_t count, size_t minBatchSize, const std::function<void(size_t, size_t)>& job)
+	{
+		if (count == 0) return;
+
+		minBatchSize = std::max<size_t>(minBatchSize, 1);
+		WorkerPool& pool = getPool();
+
+		// Not worth waking up workers for a single batch
+		if (count <= minBatchSize || pool.getNumThreads() == 1)
+		{
+			job(0, count);
+			return;
+		}
+
+		// Aim for a few batches per thread so faster threads can pick up more work
+		size_t batchSize = std::max(minBatchSize, count / (pool.getNumThreads() * 4));
+		pool.run(count, batchSize, job);
+	}
+
+	unsigned int Parallel::getNumThreads()
+	{
+		return getPool().getNumThreads();
+	}
+}
@@ -6,9 +6,43 @@
 #include "core/Window.h"
 #include "core/Object/Object.h"
 #include "core/Parser.h"
+#include "core/Tracepoints.h"
+
+#include <algorithm>
 
 namespace sg
 {
+	namespace
+	{
+		// Rectangles of the frames of an animation in the sprite sheet
+		std::vector<SDL_Rect> computeFrames(const Animation& anim)
+		{
+			std::vector<SDL_Rect> frames;
+			SDL_Rect frame{ anim.startX, anim.startY, anim.frameWidth, anim.frameHeight };
+			for (int i = 0; i < anim.numFrames; ++i)
+			{
+				frames.push_back(frame);
+
+				switch (anim.progression)
+				{
+				case Progression::LeftToRight: frame.x += anim.frameWidth + anim.horizontalFrameSpacing; break;
+				case Progression::RightToLeft: frame.x -= anim.frameWidth + anim.horizontalFrameSpacing; break;
+				case Progression::TopToBottom: frame.y += anim.frameHeight + anim.verticalFrameSpacing; break;
+				case Progression::BottomToTop: frame.y -= anim.frameHeight + anim.verticalFrameSpacing; break;
+				default: break;
+				}
+			}
+
+			return frames;
+		}
+
+		// Cache key of the cooked sprite sheet of an animation file
+		std::string trimmedTextureKey(const std::string& filePath)
+		{
+			return filePath + "#trimmed";
+		}
+	}
+
 	AnimatedTextureComponent::AnimationCache AnimatedTextureComponent::animCache;
 	std::unordered_map<std::string, std::string> AnimatedTextureComponent::texturePaths;
 
@@ -16,15 +50,29 @@ namespace sg
 	{
 		// Look for a texture path that matches this animation file and
 		// initialize the texture
+		// Retrieve cache reference
+		animations = std::make_unique<AnimatedTextureComponent::AnimationCacheRef>(cacheRef);
+
 		auto kvp = texturePaths.find(filePath);
 		if (kvp != texturePaths.end())
 		{
-			initializeTexture(Resources::pathTo(kvp->second));
+			// Trimmed animations use the cooked sprite sheet, cooked again if no component uses it anymore
+			bool trimmed = std::any_of(animations->get().begin(), animations->get().end(),
+				[](const std::pair<const std::string, Animation>& anim) { return !anim.second.trimmedFrames.empty(); });
+			if (trimmed && Texture::isCached(trimmedTextureKey(filePath)))
+			{
+				m_texture = std::make_unique<Texture>(trimmedTextureKey(filePath));
+			}
+			else if (trimmed)
+			{
+				cookTrimmedFrames(filePath, kvp->second, animations->get());
+			}
+			else
+			{
+				initializeTexture(Resources::pathTo(kvp->second));
+			}
 		}
 
-		// Retrieve cache reference
-		animations = std::make_unique<AnimatedTextureComponent::AnimationCacheRef>(cacheRef);
-
 		// Look through animations and check if one should auto-play
 		for (std::pair<std::string, Animation> anim : animations->get())
 		{
@@ -40,13 +88,19 @@ namespace sg
 	{
 		Parser parser(filePath);
 
-		// Set the texture to use (it's either loaded or retrieved in the texture cache)
-		initializeTexture(Resources::pathTo(parser.getMainBlockName()));
 		// Add the path of the texture to the list of texture paths
 		texturePaths.insert(std::make_pair(filePath, parser.getMainBlockName()));
 
 		const Block& anims = parser.getMainBlock();
 
+		// Sprite sheets with the trim specifier are cooked once every animation is known
+		bool trim = anims.has("trim");
+		if (!trim)
+		{
+			// Set the texture to use (it's either loaded or retrieved in the texture cache)
+			initializeTexture(Resources::pathTo(parser.getMainBlockName()));
+		}
+
 		// Fill the cache with an empty map and retrieve the reference
 		animations = std::make_unique<AnimatedTextureComponent::AnimationCacheRef>
 			(
@@ -59,6 +113,7 @@ namespace sg
 			);
 
 		// Fill the map we previously created with data in the file
+		std::map<std::string, Animation> parsedAnims;
 		Animation animData;
 		for (const Block& anim : anims.subBlocks)
 		{
@@ -80,7 +135,41 @@ namespace sg
 				defaultAnimName = anim.name;
 			}
 
-			addAnimation(anim.name, animData);
+			parsedAnims[anim.name] = animData;
+		}
+
+		if (trim)
+		{
+			cookTrimmedFrames(filePath, parser.getMainBlockName(), parsedAnims);
+		}
+
+		// Animations are added once complete, the default one starts playing right away
+		for (const std::pair<const std::string, Animation>& anim : parsedAnims)
+		{
+			addAnimation(anim.first, anim.second);
+		}
+	}
+
+	void AnimatedTextureComponent::cookTrimmedFrames(const std::string& filePath, const std::string& imagePath,
+		std::map<std::string, Animation>& anims)
+	{
+		// Frames of every animation are cooked in a single sprite sheet
+		std::vector<SDL_Rect> frames;
+		for (const std::pair<const std::string, Animation>& anim : anims)
+		{
+			std::vector<SDL_Rect> animFrames = computeFrames(anim.second);
+			frames.insert(frames.end(), animFrames.begin(), animFrames.end());
+		}
+
+		std::vector<TrimmedFrame> trimmedFrames;
+		m_texture = SpriteTrimmer::cook(Resources::pathTo(imagePath), trimmedTextureKey(filePath), frames, trimmedFrames);
+
+		size_t first = 0;
+		for (std::pair<const std::string, Animation>& anim : anims)
+		{
+			size_t numFrames = (size_t)std::max(anim.second.numFrames, 0);
+			anim.second.trimmedFrames.assign(trimmedFrames.begin() + first, trimmedFrames.begin() + first + numFrames);
+			first += numFrames;
 		}
 	}
 
@@ -89,10 +178,12 @@ namespace sg
 		auto found = animCache.find(filePath);
 		if (found.second)
 		{
+			SG_TRACE1(animation_cache_hit, filePath.c_str());
 			loadAnimationFromCache(filePath, found.first);
 		}
 		else
 		{
+			SG_TRACE1(animation_cache_miss, filePath.c_str());
 			parseAnimationsAndCache(filePath);
 		}
 	}
@@ -152,6 +243,7 @@ namespace sg
 
 		m_srcrect.w = currentAnim->frameWidth;
 		m_srcrect.h = currentAnim->frameHeight;
+		m_trim = { 0, 0, 0, 0 };
 		resetAnimation();
 
 		// Using the framerate, calculate how much time needs to elapse to
@@ -181,6 +273,17 @@ namespace sg
 		currentFrame = 0;
 		m_srcrect.x = currentAnim->startX;
 		m_srcrect.y = currentAnim->startY;
+		applyTrimmedFrame();
+	}
+
+	void AnimatedTextureComponent::applyTrimmedFrame()
+	{
+		if (currentFrame < (int)currentAnim->trimmedFrames.size())
+		{
+			const TrimmedFrame& frame = currentAnim->trimmedFrames[currentFrame];
+			m_srcrect = frame.source;
+			m_trim = frame.trim;
+		}
 	}
 
 	void AnimatedTextureComponent::nextFrame()
@@ -189,6 +292,10 @@ namespace sg
 		{
 			resetAnimation();
 		}
+		else if (!currentAnim->trimmedFrames.empty())
+		{
+			applyTrimmedFrame();
+		}
 		else
 		{
 			// Offset source rectangle's location based on progression 
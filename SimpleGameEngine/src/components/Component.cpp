@@ -17,5 +17,7 @@ namespace sg
 		return m_message.c_str();
 	}
 
-	Component::~Component() {}
+	size_t Component::count = 0;
+
+	Component::~Component() { --count; }
 }
@@ -10,6 +10,8 @@ namespace sg
         else if (str == "TextComponent") value = TextComponent;
         else if (str == "TextureComponent") value = TextureComponent;
         else if (str == "TilesetComponent") value = TilesetComponent;
+        else if (str == "ParticleSystemComponent") value = ParticleSystemComponent;
+        else if (str == "PixelBufferComponent") value = PixelBufferComponent;
         else value = def.value;
     }
 
@@ -23,7 +25,27 @@ namespace sg
         zIndex = data.getInt("z-index");
         drawDebug = data.has("draw-debug");
         centerOrigin = data.has("center-origin");
+        isStatic = data.has("static");
         margin = data.getInt("margin");
         spacing = data.getInt("spacing");
+
+        if (type == ComponentTypes(ComponentTypes::ParticleSystemComponent))
+        {
+            particles = ParticleEmitterData(data);
+        }
+    }
+
+    ParticleEmitterData::ParticleEmitterData(const Block& data)
+    {
+        maxParticles = data.getInt("max-particles", maxParticles);
+        rate = data.getFloat("rate", rate);
+        burst = data.getInt("burst", burst);
+        burstInterval = data.getFloat("burst-interval", burstInterval);
+        lifetime = data.getVec2("lifetime", lifetime);
+        speed = data.getVec2("speed", speed);
+        angle = data.getVec2("angle", angle);
+        gravity = data.getVec2("gravity", gravity);
+        particleSize = data.getVec2("particle-size", particleSize);
+        fadeOut = data.has("fade-out");
     }
 }
\ No newline at end of file
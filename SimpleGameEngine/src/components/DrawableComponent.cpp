@@ -40,4 +40,43 @@ namespace sg
 
 		return bounds;
 	}
+
+	SDL_Rect DrawableComponent::getDrawRect() const
+	{
+		SDL_Rect rect{ 0, 0, 0, 0 };
+		const Object& object = getObject();
+
+		if (drawFullTexture())
+		{
+			rect.w = m_texture->getWidth();
+			rect.h = m_texture->getHeight();
+		}
+		// Trimmed sprites cover their whole frame
+		else if (isTrimmed())
+		{
+			rect.w = m_trim.w;
+			rect.h = m_trim.h;
+		}
+		else
+		{
+			rect.w = m_srcrect.w;
+			rect.h = m_srcrect.h;
+		}
+
+		rect.w *= (int)object.getSize().x;
+		rect.h *= (int)object.getSize().y;
+
+		// determine upper left corner location of the component
+		vec2 position = object.getPosition();
+		if (m_centerOrigin)
+		{
+			position.x -= (rect.w / 2);
+			position.y -= (rect.h / 2);
+		}
+
+		rect.x = (int)position.x;
+		rect.y = (int)position.y;
+
+		return rect;
+	}
 }
\ No newline at end of file
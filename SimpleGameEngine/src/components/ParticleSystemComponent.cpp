@@ -0,0 +1,322 @@
+#include "components/ParticleSystemComponent.h"
+#include "assistants/Parallel.h"
+#include "assistants/Resources.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SG_USE_SSE2
+#endif
+
+namespace sg
+{
+	namespace
+	{
+		// Emitters get different but reproducible random sequences
+		unsigned int nextSeed = 1;
+	}
+
+	ParticleSystemComponent::ParticleSystemComponent(Object* obj, const ComponentInitializationData& data) :
+		DrawableComponent(obj, data), settings(data.particles), m_random(nextSeed++)
+	{
+		if (!data.path.empty())
+		{
+			initializeTexture(Resources::pathTo(data.path));
+		}
+
+		reserve((size_t)std::max(settings.maxParticles, 0));
+	}
+
+	void ParticleSystemComponent::reserve(size_t capacity)
+	{
+		if (capacity <= m_positionX.size()) return;
+
+		m_positionX.resize(capacity);
+		m_positionY.resize(capacity);
+		m_velocityX.resize(capacity);
+		m_velocityY.resize(capacity);
+		m_age.resize(capacity);
+		m_lifetime.resize(capacity);
+	}
+
+	void ParticleSystemComponent::emit(int count)
+	{
+		size_t maxParticles = (size_t)std::max(settings.maxParticles, 0);
+		reserve(maxParticles);
+
+		size_t numEmitted = std::min((size_t)std::max(count, 0), maxParticles - std::min(m_count, maxParticles));
+		if (numEmitted == 0) return;
+
+		const float degreesToRadians = 3.14159265f / 180.f;
+		std::uniform_real_distribution<float> lifetime(settings.lifetime.x, std::max(settings.lifetime.x, settings.lifetime.y));
+		std::uniform_real_distribution<float> speed(settings.speed.x, std::max(settings.speed.x, settings.speed.y));
+		std::uniform_real_distribution<float> angle(settings.angle.x * degreesToRadians,
+			std::max(settings.angle.x, settings.angle.y) * degreesToRadians);
+
+		vec2 origin = getObject().getPosition();
+		for (size_t i = m_count; i < m_count + numEmitted; ++i)
+		{
+			float particleAngle = angle(m_random);
+			float particleSpeed = speed(m_random);
+
+			m_positionX[i] = origin.x;
+			m_positionY[i] = origin.y;
+			m_velocityX[i] = std::cos(particleAngle) * particleSpeed;
+			m_velocityY[i] = std::sin(particleAngle) * particleSpeed;
+			m_age[i] = 0.f;
+			// Particles with no lifetime would never be seen
+			m_lifetime[i] = std::max(lifetime(m_random), 0.001f);
+		}
+
+		m_count += numEmitted;
+	}
+
+	void ParticleSystemComponent::integrate(float deltaSeconds)
+	{
+		float gravityX = settings.gravity.x * deltaSeconds;
+		float gravityY = settings.gravity.y * deltaSeconds;
+		float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+		size_t i = 0;
+
+		if (m_count > 0)
+		{
+			minX = maxX = m_positionX[0];
+			minY = maxY = m_positionY[0];
+		}
+
+#if defined(__AVX__)
+		if (m_count >= 8)
+		{
+			const __m256 delta = _mm256_set1_ps(deltaSeconds);
+			const __m256 accelerationX = _mm256_set1_ps(gravityX);
+			const __m256 accelerationY = _mm256_set1_ps(gravityY);
+			__m256 lowX = _mm256_set1_ps(minX), lowY = _mm256_set1_ps(minY);
+			__m256 highX = _mm256_set1_ps(maxX), highY = _mm256_set1_ps(maxY);
+
+			for (; i + 8 <= m_count; i += 8)
+			{
+				__m256 velocityX = _mm256_add_ps(_mm256_loadu_ps(&m_velocityX[i]), accelerationX);
+				__m256 velocityY = _mm256_add_ps(_mm256_loadu_ps(&m_velocityY[i]), accelerationY);
+				__m256 positionX = _mm256_add_ps(_mm256_loadu_ps(&m_positionX[i]), _mm256_mul_ps(velocityX, delta));
+				__m256 positionY = _mm256_add_ps(_mm256_loadu_ps(&m_positionY[i]), _mm256_mul_ps(velocityY, delta));
+
+				_mm256_storeu_ps(&m_velocityX[i], velocityX);
+				_mm256_storeu_ps(&m_velocityY[i], velocityY);
+				_mm256_storeu_ps(&m_positionX[i], positionX);
+				_mm256_storeu_ps(&m_positionY[i], positionY);
+				_mm256_storeu_ps(&m_age[i], _mm256_add_ps(_mm256_loadu_ps(&m_age[i]), delta));
+
+				lowX = _mm256_min_ps(lowX, positionX);
+				lowY = _mm256_min_ps(lowY, positionY);
+				highX = _mm256_max_ps(highX, positionX);
+				highY = _mm256_max_ps(highY, positionY);
+			}
+
+			alignas(32) float lanes[4][8];
+			_mm256_store_ps(lanes[0], lowX);
+			_mm256_store_ps(lanes[1], lowY);
+			_mm256_store_ps(lanes[2], highX);
+			_mm256_store_ps(lanes[3], highY);
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				minX = std::min(minX, lanes[0][lane]);
+				minY = std::min(minY, lanes[1][lane]);
+				maxX = std::max(maxX, lanes[2][lane]);
+				maxY = std::max(maxY, lanes[3][lane]);
+			}
+		}
+#elif defined(SG_USE_SSE2)
+		if (m_count >= 4)
+		{
+			const __m128 delta = _mm_set1_ps(deltaSeconds);
+			const __m128 accelerationX = _mm_set1_ps(gravityX);
+			const __m128 accelerationY = _mm_set1_ps(gravityY);
+			__m128 lowX = _mm_set1_ps(minX), lowY = _mm_set1_ps(minY);
+			__m128 highX = _mm_set1_ps(maxX), highY = _mm_set1_ps(maxY);
+
+			for (; i + 4 <= m_count; i += 4)
+			{
+				__m128 velocityX = _mm_add_ps(_mm_loadu_ps(&m_velocityX[i]), accelerationX);
+				__m128 velocityY = _mm_add_ps(_mm_loadu_ps(&m_velocityY[i]), accelerationY);
+				__m128 positionX = _mm_add_ps(_mm_loadu_ps(&m_positionX[i]), _mm_mul_ps(velocityX, delta));
+				__m128 positionY = _mm_add_ps(_mm_loadu_ps(&m_positionY[i]), _mm_mul_ps(velocityY, delta));
+
+				_mm_storeu_ps(&m_velocityX[i], velocityX);
+				_mm_storeu_ps(&m_velocityY[i], velocityY);
+				_mm_storeu_ps(&m_positionX[i], positionX);
+				_mm_storeu_ps(&m_positionY[i], positionY);
+				_mm_storeu_ps(&m_age[i], _mm_add_ps(_mm_loadu_ps(&m_age[i]), delta));
+
+				lowX = _mm_min_ps(lowX, positionX);
+				lowY = _mm_min_ps(lowY, positionY);
+				highX = _mm_max_ps(highX, positionX);
+				highY = _mm_max_ps(highY, positionY);
+			}
+
+			alignas(16) float lanes[4][4];
+			_mm_store_ps(lanes[0], lowX);
+			_mm_store_ps(lanes[1], lowY);
+			_mm_store_ps(lanes[2], highX);
+			_mm_store_ps(lanes[3], highY);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				minX = std::min(minX, lanes[0][lane]);
+				minY = std::min(minY, lanes[1][lane]);
+				maxX = std::max(maxX, lanes[2][lane]);
+				maxY = std::max(maxY, lanes[3][lane]);
+			}
+		}
+#endif
+
+		// Remaining particles, or every particle when SIMD isn't available
+		for (; i < m_count; ++i)
+		{
+			m_velocityX[i] += gravityX;
+			m_velocityY[i] += gravityY;
+			m_positionX[i] += m_velocityX[i] * deltaSeconds;
+			m_positionY[i] += m_velocityY[i] * deltaSeconds;
+			m_age[i] += deltaSeconds;
+
+			minX = std::min(minX, m_positionX[i]);
+			minY = std::min(minY, m_positionY[i]);
+			maxX = std::max(maxX, m_positionX[i]);
+			maxY = std::max(maxY, m_positionY[i]);
+		}
+
+		m_bounds = { minX, minY, maxX - minX, maxY - minY };
+	}
+
+	void ParticleSystemComponent::removeDeadParticles()
+	{
+		size_t i = 0;
+		while (i < m_count)
+		{
+			if (m_age[i] < m_lifetime[i])
+			{
+				++i;
+				continue;
+			}
+
+			// Order doesn't matter, move the last particle in place of the dead one
+			--m_count;
+			m_positionX[i] = m_positionX[m_count];
+			m_positionY[i] = m_positionY[m_count];
+			m_velocityX[i] = m_velocityX[m_count];
+			m_velocityY[i] = m_velocityY[m_count];
+			m_age[i] = m_age[m_count];
+			m_lifetime[i] = m_lifetime[m_count];
+		}
+	}
+
+	void ParticleSystemComponent::update(float deltaSeconds)
+	{
+		// Bounds computed by integrate() are meaningless without particles
+		bool hadParticles = m_count > 0;
+		integrate(deltaSeconds);
+		removeDeadParticles();
+
+		if (emitting)
+		{
+			// First burst happens when the emitter starts
+			if (!m_started)
+			{
+				m_started = true;
+				emit(settings.burst);
+			}
+			else if (settings.burstInterval > 0.f)
+			{
+				m_burstTimer += deltaSeconds;
+				if (m_burstTimer >= settings.burstInterval)
+				{
+					m_burstTimer -= settings.burstInterval;
+					emit(settings.burst);
+				}
+			}
+
+			// Keep the fractional part so low rates still emit over several frames
+			m_emissionDebt += settings.rate * deltaSeconds;
+			int numEmitted = (int)m_emissionDebt;
+			m_emissionDebt -= (float)numEmitted;
+			emit(numEmitted);
+		}
+
+		// New particles are at the emitter's position, and particles are drawn centered on their position
+		vec2 origin = getObject().getPosition();
+		float minX = origin.x, minY = origin.y, maxX = origin.x, maxY = origin.y;
+		if (hadParticles)
+		{
+			minX = std::min(minX, m_bounds.x);
+			minY = std::min(minY, m_bounds.y);
+			maxX = std::max(maxX, m_bounds.x + m_bounds.w);
+			maxY = std::max(maxY, m_bounds.y + m_bounds.h);
+		}
+		float margin = std::max(settings.particleSize.x, settings.particleSize.y) * 0.5f;
+		m_bounds = { minX - margin, minY - margin, maxX - minX + margin * 2.f, maxY - minY + margin * 2.f };
+	}
+
+	void ParticleSystemComponent::buildVertices(size_t begin, size_t end, const vec2& offset)
+	{
+		float startSize = settings.particleSize.x;
+		float sizeChange = settings.particleSize.y - settings.particleSize.x;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			float progress = std::min(m_age[i] / m_lifetime[i], 1.f);
+			float halfSize = (startSize + sizeChange * progress) * 0.5f;
+			Uint8 alpha = (settings.fadeOut) ? (Uint8)((1.f - progress) * 255.f) : 255;
+
+			float x = m_positionX[i] - offset.x;
+			float y = m_positionY[i] - offset.y;
+			SDL_Color color{ 255, 255, 255, alpha };
+
+			SDL_Vertex* vertex = &m_vertices[i * 4];
+			vertex[0] = { { x - halfSize, y - halfSize }, color, { 0.f, 0.f } };
+			vertex[1] = { { x + halfSize, y - halfSize }, color, { 1.f, 0.f } };
+			vertex[2] = { { x + halfSize, y + halfSize }, color, { 1.f, 1.f } };
+			vertex[3] = { { x - halfSize, y + halfSize }, color, { 0.f, 1.f } };
+		}
+	}
+
+	void ParticleSystemComponent::customDraw(SDL_Renderer* renderer, const vec2& offset)
+	{
+		if (m_count == 0) return;
+
+		// Indices are the same for every frame, they are only extended when there are more particles
+		size_t numIndices = m_indices.size();
+		if (numIndices < m_count * 6)
+		{
+			m_indices.resize(m_count * 6);
+			for (size_t quad = numIndices / 6; quad < m_count; ++quad)
+			{
+				int first = (int)quad * 4;
+				int* index = &m_indices[quad * 6];
+				index[0] = first; index[1] = first + 1; index[2] = first + 2;
+				index[3] = first; index[4] = first + 2; index[5] = first + 3;
+			}
+		}
+
+		m_vertices.resize(m_count * 4);
+		auto job = [this, &offset](size_t begin, size_t end) { buildVertices(begin, end, offset); };
+		if (m_count >= PARALLEL_PARTICLES_THRESHOLD)
+		{
+			Parallel::forRange(m_count, PARTICLES_BATCH_SIZE, job);
+		}
+		else
+		{
+			job(0, m_count);
+		}
+
+		SDL_Texture* texture = (m_texture) ? m_texture->get() : nullptr;
+		if (texture == nullptr)
+		{
+			// Plain squares are blended with the renderer's draw blend mode
+			SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		}
+
+		SDL_RenderGeometry(renderer, texture, m_vertices.data(), (int)m_vertices.size(), m_indices.data(), (int)m_count * 6);
+	}
+}
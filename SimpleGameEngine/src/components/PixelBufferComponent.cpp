@@ -0,0 +1,44 @@
+#include "components/PixelBufferComponent.h"
+
+#include <algorithm>
+
+namespace sg
+{
+	PixelBufferComponent::PixelBufferComponent(Object* obj, const ComponentInitializationData& data)
+		: PixelBufferComponent(obj, (int)data.size.x, (int)data.size.y)
+	{
+		zIndex = data.zIndex;
+		m_centerOrigin = data.centerOrigin;
+	}
+
+	PixelBufferComponent::PixelBufferComponent(Object* obj, int width, int height)
+		: DrawableComponent(obj, ComponentInitializationData())
+	{
+		if (width <= 0 || height <= 0)
+		{
+			throw ComponentException("Pixel buffer size must be positive");
+		}
+
+		m_texture = std::make_unique<Texture>(width, height, SDL_TEXTUREACCESS_STREAMING);
+	}
+
+	void PixelBufferComponent::fill(Uint32 color, const SDL_Rect* region)
+	{
+		SDL_Rect bounds{ 0, 0, getWidth(), getHeight() };
+		SDL_Rect filled = bounds;
+		if (region && !SDL_IntersectRect(region, &bounds, &filled)) return;
+
+		Uint32* pixels = lockPixels(&filled);
+		for (int y = 0; y < filled.h; ++y)
+		{
+			Uint32* row = pixels + (size_t)y * getPitch();
+			std::fill(row, row + filled.w, color);
+		}
+		unlockPixels();
+	}
+
+	void PixelBufferComponent::preDrawOperations()
+	{
+		m_uploaded = m_texture->uploadPixels();
+	}
+}
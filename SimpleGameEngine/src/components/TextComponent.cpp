@@ -24,14 +24,16 @@ namespace sg
 
 	void TextComponent::preDrawOperations()
 	{
-		if (m_texture)
+		// Only render the text again when it changed
+		if (m_texture && text == renderedText && ptSize == renderedPtSize)
 		{
-			SDL_DestroyTexture(m_texture->get());
-			m_texture = nullptr;
+			return;
 		}
 
 		SDL_Surface* surface = TTF_RenderText_Solid(m_font, text.c_str(), { 255, 255, 255, 255 });
 		m_texture = std::make_unique<Texture>(surface);
+		renderedText = text;
+		renderedPtSize = ptSize;
 	}
 
 	void TextComponent::setFontSize(int newPtSize)
@@ -1,5 +1,6 @@
 #include "components/TilesetComponent.h"
 #include "assistants/Resources.h"
+#include "core/StaticTileLayer.h"
 #include <iostream>
 
 namespace sg
@@ -22,6 +23,21 @@ namespace sg
 		numTilesHeight = height / (int)m_srcrect.h;
 		
 		setIndex(0);
+
+		// Static tiles are baked in chunks instead of being drawn individually
+		if (data.isStatic)
+		{
+			m_static = true;
+			StaticTileLayer::add(this);
+		}
+	}
+
+	TilesetComponent::~TilesetComponent()
+	{
+		if (m_static)
+		{
+			StaticTileLayer::remove(this);
+		}
 	}
 
 	void TilesetComponent::setIndex(int newIndex)
@@ -31,5 +47,10 @@ namespace sg
 		int tileY = tileIndex / numTilesWidth;
 		m_srcrect.x = margin + m_srcrect.w * tileX + spacing * tileX;
 		m_srcrect.y = margin + m_srcrect.h * tileY + spacing * tileY;
+
+		if (m_static)
+		{
+			StaticTileLayer::markDirty(this);
+		}
 	}
 }
\ No newline at end of file
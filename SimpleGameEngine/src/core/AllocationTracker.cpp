@@ -0,0 +1,402 @@
+#include "core/AllocationTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+#if defined(SG_TRACK_ALLOCATIONS) && (defined(__linux__) || defined(__APPLE__))
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#define SG_SYMBOLIZE_CALL_SITES
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <malloc.h>
+#define SG_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define SG_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace sg
+{
+	AllocationCounts AllocationTracker::lastFrame;
+	AllocationCounts AllocationTracker::frameStart;
+	uint64_t AllocationTracker::frame = 0;
+
+	namespace
+	{
+		std::atomic<uint64_t> totalAllocations{ 0 };
+		std::atomic<uint64_t> totalBytes{ 0 };
+		thread_local const char* currentScope = nullptr;
+		// Set while an allocation is attributed, allocations made meanwhile are only counted
+		thread_local bool recording = false;
+
+		struct CallSite
+		{
+			const char* scope;
+			void* address;
+			AllocationCounts total;
+			// Counts of the frame frameIndex, reset when the site allocates in a later frame
+			AllocationCounts frame;
+			uint64_t frameIndex;
+			bool used;
+		};
+
+		// Fixed size since recording an allocation can't allocate. Threads rarely allocate at the same
+		// time so a spin lock is enough
+		CallSite sites[ALLOCATION_TRACKER_SITES];
+		CallSite unknownSite{ "", nullptr, {}, {}, 0, true };
+		std::atomic_flag sitesLock = ATOMIC_FLAG_INIT;
+
+		void lockSites()
+		{
+			while (sitesLock.test_and_set(std::memory_order_acquire)) {}
+		}
+
+		void unlockSites()
+		{
+			sitesLock.clear(std::memory_order_release);
+		}
+
+		// Open addressing, the table is never emptied
+		CallSite& findSite(const char* scope, void* address)
+		{
+			size_t hash = ((size_t)address >> 4) ^ ((size_t)scope * 31);
+			for (size_t probe = 0; probe < ALLOCATION_TRACKER_SITES; ++probe)
+			{
+				CallSite& site = sites[(hash + probe) % ALLOCATION_TRACKER_SITES];
+				if (!site.used)
+				{
+					site.used = true;
+					site.scope = scope;
+					site.address = address;
+					return site;
+				}
+				if (site.scope == scope && site.address == address)
+				{
+					return site;
+				}
+			}
+
+			return unknownSite;
+		}
+
+#if defined(SG_SYMBOLIZE_CALL_SITES)
+		struct ClassifiedAddress
+		{
+			void* address;
+			bool standardLibrary;
+		};
+
+		// Looking up symbols is slow, addresses are classified once. Guarded by the sites lock
+		ClassifiedAddress classifiedAddresses[ALLOCATION_TRACKER_SITES];
+
+		bool hasPrefix(const char* text, const char* prefix)
+		{
+			return std::strncmp(text, prefix, std::strlen(prefix)) == 0;
+		}
+
+		// Returns true if address is code of the standard library or of a std template instantiated by
+		// the caller. Executables only export their symbols when linked with -rdynamic
+		bool isStandardLibrary(void* address)
+		{
+			Dl_info info;
+			if (dladdr(address, &info) == 0) return false;
+
+			if (info.dli_fname && (std::strstr(info.dli_fname, "libstdc++") || std::strstr(info.dli_fname, "libc++")))
+			{
+				return true;
+			}
+			if (info.dli_sname == nullptr) return false;
+
+			const char* name = info.dli_sname;
+			// Mach-O symbols start with an extra underscore
+			if (name[0] == '_' && name[1] == '_' && name[2] == 'Z') ++name;
+			return hasPrefix(name, "_ZNSt") || hasPrefix(name, "_ZNKSt") || hasPrefix(name, "_ZSt") ||
+				hasPrefix(name, "_ZN9__gnu_cxx") || hasPrefix(name, "_ZNK9__gnu_cxx");
+		}
+
+		// Caller holds the sites lock
+		bool isStandardLibraryCached(void* address)
+		{
+			size_t hash = (size_t)address >> 4;
+			for (size_t probe = 0; probe < ALLOCATION_TRACKER_SITES; ++probe)
+			{
+				ClassifiedAddress& classified = classifiedAddresses[(hash + probe) % ALLOCATION_TRACKER_SITES];
+				if (classified.address == address)
+				{
+					return classified.standardLibrary;
+				}
+				if (classified.address == nullptr)
+				{
+					classified.address = address;
+					classified.standardLibrary = isStandardLibrary(address);
+					return classified.standardLibrary;
+				}
+			}
+
+			return isStandardLibrary(address);
+		}
+
+		// First frame calling operator new, directly or through the standard library. Caller holds the sites lock
+		void* findCallSite(void* returnAddress)
+		{
+			if (!isStandardLibraryCached(returnAddress)) return returnAddress;
+
+			void* frames[ALLOCATION_TRACKER_FRAMES + 4];
+			int count = backtrace(frames, ALLOCATION_TRACKER_FRAMES + 4);
+
+			// Frames before operator new's caller are the tracker's own
+			int first = 0;
+			while (first < count && frames[first] != returnAddress) ++first;
+
+			for (int i = first + 1; i < count; ++i)
+			{
+				if (!isStandardLibraryCached(frames[i])) return frames[i];
+			}
+			return returnAddress;
+		}
+
+		// The first backtrace loads the unwinder, which allocates
+		struct LoadUnwinder
+		{
+			LoadUnwinder()
+			{
+				void* frame;
+				backtrace(&frame, 1);
+			}
+		} loadUnwinder;
+#endif
+
+		// Name of the function containing address, the address itself when it can't be resolved
+		std::vector<std::string> describeSites(const std::vector<CallSite>& calls)
+		{
+			std::vector<std::string> descriptions(calls.size());
+#if defined(SG_SYMBOLIZE_CALL_SITES)
+			std::vector<void*> addresses;
+			for (const CallSite& site : calls)
+			{
+				addresses.push_back(site.address);
+			}
+
+			// Executables only export their symbols when linked with -rdynamic
+			char** symbols = (addresses.empty()) ? nullptr : backtrace_symbols(addresses.data(), (int)addresses.size());
+			for (size_t i = 0; symbols && i < calls.size(); ++i)
+			{
+				descriptions[i] = symbols[i];
+			}
+			std::free(symbols);
+#endif
+			for (size_t i = 0; i < calls.size(); ++i)
+			{
+				if (calls[i].address == nullptr)
+				{
+					descriptions[i] = "other call sites, table full";
+				}
+				else if (descriptions[i].empty())
+				{
+					char address[32];
+					std::snprintf(address, sizeof(address), "%p", calls[i].address);
+					descriptions[i] = address;
+				}
+			}
+			return descriptions;
+		}
+
+		void writeSites(std::ofstream& file, std::vector<CallSite>& calls, bool lastFrame, size_t count)
+		{
+			auto counts = [lastFrame](const CallSite& site) -> const AllocationCounts&
+			{
+				return (lastFrame) ? site.frame : site.total;
+			};
+
+			std::sort(calls.begin(), calls.end(), [&counts](const CallSite& a, const CallSite& b)
+			{
+				return counts(a).allocations > counts(b).allocations;
+			});
+			calls.resize(std::min(calls.size(), count));
+
+			std::vector<std::string> descriptions = describeSites(calls);
+			file << std::setw(12) << "allocations" << std::setw(14) << "bytes" << "  scope | call site\n";
+			for (size_t i = 0; i < calls.size(); ++i)
+			{
+				const char* scope = (calls[i].scope) ? calls[i].scope : "(no scope)";
+				file << std::setw(12) << counts(calls[i]).allocations << std::setw(14) << counts(calls[i]).bytes
+					<< "  " << scope << " | " << descriptions[i] << "\n";
+			}
+		}
+	}
+
+	bool AllocationTracker::isAvailable()
+	{
+#if defined(SG_TRACK_ALLOCATIONS)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	AllocationCounts AllocationTracker::getTotal()
+	{
+		return { totalAllocations.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed) };
+	}
+
+	const char* AllocationTracker::enterScope(const char* name)
+	{
+		const char* previous = currentScope;
+		currentScope = name;
+		return previous;
+	}
+
+	void AllocationTracker::leaveScope(const char* previous)
+	{
+		currentScope = previous;
+	}
+
+	void AllocationTracker::record(size_t bytes, void* returnAddress)
+	{
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		// The sites lock is held while attributing, an allocation made meanwhile would wait for it forever
+		if (recording) return;
+		recording = true;
+
+		lockSites();
+#if defined(SG_SYMBOLIZE_CALL_SITES)
+		void* callSite = findCallSite(returnAddress);
+#else
+		void* callSite = returnAddress;
+#endif
+		CallSite& site = findSite(currentScope, callSite);
+		if (site.frameIndex != frame)
+		{
+			site.frame = {};
+			site.frameIndex = frame;
+		}
+		++site.frame.allocations;
+		site.frame.bytes += bytes;
+		++site.total.allocations;
+		site.total.bytes += bytes;
+		unlockSites();
+
+		recording = false;
+	}
+
+	void AllocationTracker::endFrame()
+	{
+		AllocationCounts total = getTotal();
+		lastFrame = { total.allocations - frameStart.allocations, total.bytes - frameStart.bytes };
+		frameStart = total;
+
+		lockSites();
+		++frame;
+		unlockSites();
+	}
+
+	bool AllocationTracker::writeReport(const std::string& path, size_t count)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		// Sites are copied without allocating while the lock is held, recording would wait for it
+		std::vector<CallSite> allSites, frameSites;
+		allSites.reserve(ALLOCATION_TRACKER_SITES + 1);
+		frameSites.reserve(ALLOCATION_TRACKER_SITES + 1);
+		lockSites();
+		for (const CallSite& site : sites)
+		{
+			if (!site.used) continue;
+			allSites.push_back(site);
+			if (frame > 0 && site.frameIndex == frame - 1)
+			{
+				frameSites.push_back(site);
+			}
+		}
+		if (unknownSite.total.allocations > 0)
+		{
+			allSites.push_back(unknownSite);
+		}
+		unlockSites();
+
+		AllocationCounts total = getTotal();
+		file << "Allocation report: " << frame << " frames, " << total.allocations << " allocations, "
+			<< total.bytes << " bytes\n\n";
+		file << "Last frame: " << lastFrame.allocations << " allocations, " << lastFrame.bytes << " bytes\n";
+		writeSites(file, frameSites, true, count);
+		file << "\nSince the program started:\n";
+		writeSites(file, allSites, false, count);
+
+		return file.good();
+	}
+}
+
+#if defined(SG_TRACK_ALLOCATIONS)
+namespace
+{
+	void* allocate(size_t size, void* callSite)
+	{
+		sg::AllocationTracker::record(size, callSite);
+
+		if (void* memory = std::malloc((size > 0) ? size : 1))
+		{
+			return memory;
+		}
+		throw std::bad_alloc();
+	}
+
+	// Types aligned beyond what malloc guarantees use these
+	void* allocateAligned(size_t size, std::align_val_t alignment, void* callSite)
+	{
+		sg::AllocationTracker::record(size, callSite);
+
+#if defined(_MSC_VER)
+		if (void* memory = _aligned_malloc((size > 0) ? size : 1, (size_t)alignment))
+		{
+			return memory;
+		}
+#else
+		void* memory = nullptr;
+		if (posix_memalign(&memory, (size_t)alignment, (size > 0) ? size : 1) == 0)
+		{
+			return memory;
+		}
+#endif
+		throw std::bad_alloc();
+	}
+
+	void freeAligned(void* memory)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+}
+
+// Every allocation of the program goes through these, the return address is the code calling new
+void* operator new(size_t size) { return allocate(size, SG_RETURN_ADDRESS()); }
+void* operator new[](size_t size) { return allocate(size, SG_RETURN_ADDRESS()); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment, SG_RETURN_ADDRESS()); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment, SG_RETURN_ADDRESS()); }
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+#endif
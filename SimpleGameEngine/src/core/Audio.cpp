@@ -1,5 +1,8 @@
 #include "core/Audio.h"
 
+#include "core/Profiler.h"
+#include "core/Stats.h"
+#include "core/Tracepoints.h"
 #include "assistants/Resources.h"
 
 namespace sg
@@ -60,11 +63,17 @@ namespace sg
 
 	void Audio::playMusic(const std::string& path, int volume)
 	{
-		playingMusic = Mix_LoadMUS(sg::Resources::pathTo(path).c_str());
+		uint64_t loadStart = SG_TRACE_NOW();
+		{
+			SG_PROFILE_SCOPE("Audio load");
+			playingMusic = Mix_LoadMUS(sg::Resources::pathTo(path).c_str());
+		}
 		if (!playingMusic)
 		{
 			throw AudioException("Failed to load music");
 		}
+		// Music is streamed, its size isn't known
+		SG_TRACE3(sound_load, path.c_str(), SG_TRACE_NOW() - loadStart, (uint64_t)0);
 
 		Mix_VolumeMusic(volume);
 		if (Mix_PlayMusic(playingMusic, -1) == -1)
@@ -100,13 +109,22 @@ namespace sg
 		else
 		{
 			std::string pathToResource = sg::Resources::pathTo(path);
-			Mix_Chunk* sample = Mix_LoadWAV(pathToResource.c_str());
+			Mix_Chunk* sample = nullptr;
+			uint64_t loadStart = SG_TRACE_NOW();
+			{
+				SG_PROFILE_SCOPE("Audio load");
+				sample = Mix_LoadWAV(pathToResource.c_str());
+			}
+
 			if (sample == nullptr)
 			{
 				throw AudioException("Failed to load .wav file");
 			}
+			Stats::addBytesLoaded(sample->alen);
+			SG_TRACE3(sound_load, path.c_str(), SG_TRACE_NOW() - loadStart, (uint64_t)sample->alen);
 
-			savedSounds[pathToResource] = sample;
+			// Saved under the path it's looked up with
+			savedSounds[path] = sample;
 
 			playSoundIntern(sample, volume);
 		}
@@ -114,13 +132,21 @@ namespace sg
 
 	void Audio::playSound(const std::string& path, int volume)
 	{
-		Mix_Chunk* sample = Mix_LoadWAV(sg::Resources::pathTo(path).c_str());
+		Mix_Chunk* sample = nullptr;
+		uint64_t loadStart = SG_TRACE_NOW();
+		{
+			SG_PROFILE_SCOPE("Audio load");
+			sample = Mix_LoadWAV(sg::Resources::pathTo(path).c_str());
+		}
+
 		if (sample == nullptr)
 		{
 			throw AudioException("Failed to load .wav file");
 		}
 		else
 		{
+			Stats::addBytesLoaded(sample->alen);
+			SG_TRACE3(sound_load, path.c_str(), SG_TRACE_NOW() - loadStart, (uint64_t)sample->alen);
 			playSoundIntern(sample, volume, true);
 		}
 	}
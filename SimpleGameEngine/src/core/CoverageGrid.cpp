@@ -0,0 +1,95 @@
+#include "core/CoverageGrid.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace sg
+{
+	namespace
+	{
+		// Bits [begin, end) of a word, end is at most 64
+		uint64_t rangeMask(int begin, int end)
+		{
+			uint64_t upper = (end >= 64) ? ~0ULL : ((1ULL << end) - 1);
+			return upper & ~((1ULL << begin) - 1);
+		}
+	}
+
+	void CoverageGrid::reset(int width, int height)
+	{
+		m_width = std::max(width, 0);
+		m_height = std::max(height, 0);
+		m_cellsX = (m_width + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+		m_cellsY = (m_height + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+		m_wordsPerRow = ((size_t)m_cellsX + 63) / 64;
+		m_numCovered = 0;
+
+		// Keeps its capacity from one frame to another
+		m_cells.assign(m_wordsPerRow * m_cellsY, 0);
+	}
+
+	bool CoverageGrid::clip(const SDL_Rect& rect, SDL_Rect& clipped) const
+	{
+		int left = std::max(rect.x, 0);
+		int top = std::max(rect.y, 0);
+		int right = std::min(rect.x + rect.w, m_width);
+		int bottom = std::min(rect.y + rect.h, m_height);
+
+		if (right <= left || bottom <= top) return false;
+
+		clipped = { left, top, right - left, bottom - top };
+		return true;
+	}
+
+	bool CoverageGrid::isCovered(const SDL_Rect& rect) const
+	{
+		SDL_Rect clipped;
+		if (!clip(rect, clipped)) return false;
+
+		// Every cell the rectangle touches must be covered
+		int firstX = clipped.x / COVERAGE_CELL_SIZE;
+		int endX = (clipped.x + clipped.w - 1) / COVERAGE_CELL_SIZE + 1;
+		int firstY = clipped.y / COVERAGE_CELL_SIZE;
+		int endY = (clipped.y + clipped.h - 1) / COVERAGE_CELL_SIZE + 1;
+
+		for (int cellY = firstY; cellY < endY; ++cellY)
+		{
+			const uint64_t* row = &m_cells[(size_t)cellY * m_wordsPerRow];
+			for (int word = firstX / 64; word * 64 < endX; ++word)
+			{
+				uint64_t mask = rangeMask(std::max(firstX - word * 64, 0), std::min(endX - word * 64, 64));
+				if ((row[word] & mask) != mask) return false;
+			}
+		}
+
+		return true;
+	}
+
+	void CoverageGrid::cover(const SDL_Rect& rect)
+	{
+		SDL_Rect clipped;
+		if (!clip(rect, clipped)) return;
+
+		// Only cells entirely inside the rectangle are covered. Cells on the right and bottom
+		// edges of the screen are partly outside of it and only need their on-screen part covered
+		int right = clipped.x + clipped.w;
+		int bottom = clipped.y + clipped.h;
+		int firstX = (clipped.x + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+		int endX = (right == m_width) ? m_cellsX : right / COVERAGE_CELL_SIZE;
+		int firstY = (clipped.y + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+		int endY = (bottom == m_height) ? m_cellsY : bottom / COVERAGE_CELL_SIZE;
+
+		if (endX <= firstX || endY <= firstY) return;
+
+		for (int cellY = firstY; cellY < endY; ++cellY)
+		{
+			uint64_t* row = &m_cells[(size_t)cellY * m_wordsPerRow];
+			for (int word = firstX / 64; word * 64 < endX; ++word)
+			{
+				uint64_t mask = rangeMask(std::max(firstX - word * 64, 0), std::min(endX - word * 64, 64));
+				m_numCovered += std::bitset<64>(mask & ~row[word]).count();
+				row[word] |= mask;
+			}
+		}
+	}
+}
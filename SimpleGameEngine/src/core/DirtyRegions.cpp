@@ -0,0 +1,158 @@
+#include "core/DirtyRegions.h"
+
+#include <utility>
+
+namespace sg
+{
+	void DirtyRegions::track(const DrawCommand& command)
+	{
+		auto found = m_tracked.find(command.component);
+
+		if (found == m_tracked.end())
+		{
+			// The drawable appeared this frame
+			addRegion(command.destination);
+			m_tracked[command.component] = { command, m_frame };
+			return;
+		}
+
+		TrackedState& tracked = found->second;
+		if (tracked.command != command)
+		{
+			// Redraw both where it was and where it is now
+			addRegion(tracked.command.destination);
+			addRegion(command.destination);
+			tracked.command = command;
+		}
+
+		tracked.lastFrameSeen = m_frame;
+	}
+
+	const std::vector<SDL_Rect>& DirtyRegions::endFrame(const SDL_Rect& screen)
+	{
+		// Drawables that weren't tracked this frame disappeared
+		for (auto it = m_tracked.begin(); it != m_tracked.end();)
+		{
+			if (it->second.lastFrameSeen != m_frame)
+			{
+				addRegion(it->second.command.destination);
+				it = m_tracked.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		++m_frame;
+
+		if (m_invalidated)
+		{
+			m_invalidated = false;
+			m_regions.clear();
+			m_regions.push_back(screen);
+		}
+		else
+		{
+			mergeRegions(screen);
+		}
+
+		m_pending.clear();
+		return m_regions;
+	}
+
+	void DirtyRegions::clear()
+	{
+		m_tracked.clear();
+		m_pending.clear();
+		m_regions.clear();
+		m_invalidated = true;
+	}
+
+	void DirtyRegions::addRegion(const SDL_Rect& region)
+	{
+		if (region.w > 0 && region.h > 0)
+		{
+			m_pending.push_back(region);
+		}
+	}
+
+	void DirtyRegions::mergeRegions(const SDL_Rect& screen)
+	{
+		// Clip regions to the screen and drop the ones outside of it.
+		// Merged in place, the vector keeps its capacity from one frame to another
+		std::vector<SDL_Rect>& clipped = m_regions;
+		clipped.clear();
+		for (const SDL_Rect& region : m_pending)
+		{
+			SDL_Rect visible;
+			if (SDL_IntersectRect(&region, &screen, &visible))
+			{
+				clipped.push_back(visible);
+			}
+		}
+
+		if (clipped.empty()) return;
+
+		// Merging is quadratic at best, with many moving drawables their bounds are redrawn instead
+		if (clipped.size() > MAX_PENDING_DIRTY_REGIONS)
+		{
+			SDL_Rect bounds = clipped[0];
+			for (const SDL_Rect& region : clipped)
+			{
+				SDL_UnionRect(&bounds, &region, &bounds);
+			}
+
+			clipped.clear();
+			bool fullRedraw = (long long)bounds.w * bounds.h > (long long)(DIRTY_FULL_REDRAW_RATIO * screen.w * screen.h);
+			clipped.push_back((fullRedraw) ? screen : bounds);
+			return;
+		}
+
+		// Union overlapping regions until none of them overlap
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (size_t i = 0; i < clipped.size() && !merged; ++i)
+			{
+				for (size_t j = i + 1; j < clipped.size(); ++j)
+				{
+					if (SDL_HasIntersection(&clipped[i], &clipped[j]))
+					{
+						SDL_UnionRect(&clipped[i], &clipped[j], &clipped[i]);
+						clipped.erase(clipped.begin() + j);
+						merged = true;
+						break;
+					}
+				}
+			}
+		}
+
+		// Too many small regions cost more than one bigger region
+		long long area = 0;
+		for (const SDL_Rect& region : clipped)
+		{
+			area += (long long)region.w * region.h;
+		}
+
+		if (clipped.size() > MAX_DIRTY_REGIONS)
+		{
+			SDL_Rect bounds = clipped[0];
+			for (const SDL_Rect& region : clipped)
+			{
+				SDL_UnionRect(&bounds, &region, &bounds);
+			}
+
+			clipped.clear();
+			clipped.push_back(bounds);
+			area = (long long)bounds.w * bounds.h;
+		}
+
+		if (area > (long long)(DIRTY_FULL_REDRAW_RATIO * screen.w * screen.h))
+		{
+			clipped.clear();
+			clipped.push_back(screen);
+		}
+	}
+}
@@ -0,0 +1,307 @@
+#include "core/DrawCommand.h"
+#include "core/Object/Object.h"
+#include "core/Profiler.h"
+
+#include "core/Cpu.h"
+#include "components/DrawableComponent.h"
+#include "assistants/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SG_USE_SSE2
+#endif
+
+namespace sg
+{
+	void DrawCommandBuffer::prepare(const std::vector<DrawableComponent*>& drawables, const vec2& cameraTopLeft, float zoom)
+	{
+		SG_PROFILE_SCOPE("Prepare draw commands");
+
+		// Pre-draw operations may create textures, they must run on this thread
+		{
+			SG_PROFILE_SCOPE("Pre-draw operations");
+			for (DrawableComponent* component : drawables)
+			{
+				component->preDrawOperations();
+			}
+		}
+
+		size_t count = drawables.size();
+		m_drawables = &drawables;
+
+		// Buffers keep their capacity from one frame to another
+		m_commands.resize(count);
+		m_positionX.resize(count);
+		m_positionY.resize(count);
+		m_width.resize(count);
+		m_height.resize(count);
+		m_scaleX.resize(count);
+		m_scaleY.resize(count);
+		m_center.resize(count);
+		m_offsetX.resize(count);
+		m_offsetY.resize(count);
+		m_zoom.resize(count);
+
+		auto job = [this, &cameraTopLeft, zoom](size_t begin, size_t end)
+		{
+			fetch(begin, end, cameraTopLeft, zoom);
+			computeDestinations(begin, end);
+			selectLevels(begin, end);
+		};
+
+		if (count >= PARALLEL_PREPARATION_THRESHOLD)
+		{
+			Parallel::forRange(count, PREPARATION_BATCH_SIZE, job);
+		}
+		else
+		{
+			job(0, count);
+		}
+
+		m_drawables = nullptr;
+
+		// Sort draw commands according to their zIndex, keeping gathering order otherwise
+		SG_PROFILE_SCOPE("Sort draw commands");
+		sortByZIndex();
+	}
+
+	void DrawCommandBuffer::sortByZIndex()
+	{
+		auto before = [](const DrawCommand& a, const DrawCommand& b) -> bool
+		{
+			return a.zIndex < b.zIndex;
+		};
+
+		// Common when every drawable shares a few zIndex and was created in order
+		if (std::is_sorted(m_commands.begin(), m_commands.end(), before)) return;
+
+		// Bottom-up merge sort, stable like std::stable_sort which allocates its buffer every call
+		size_t count = m_commands.size();
+		m_sortBuffer.resize(count);
+		std::vector<DrawCommand>* from = &m_commands;
+		std::vector<DrawCommand>* to = &m_sortBuffer;
+		for (size_t width = 1; width < count; width *= 2)
+		{
+			for (size_t begin = 0; begin < count; begin += 2 * width)
+			{
+				size_t middle = std::min(begin + width, count);
+				size_t end = std::min(begin + 2 * width, count);
+				std::merge(from->begin() + begin, from->begin() + middle, from->begin() + middle, from->begin() + end,
+					to->begin() + begin, before);
+			}
+			std::swap(from, to);
+		}
+
+		if (from != &m_commands)
+		{
+			m_commands.swap(m_sortBuffer);
+		}
+	}
+
+	void DrawCommandBuffer::fetch(size_t begin, size_t end, const vec2& cameraTopLeft, float zoom)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			DrawableComponent* component = (*m_drawables)[i];
+			const Object& object = component->getObject();
+			DrawCommand& command = m_commands[i];
+
+			Texture* texture = component->getTexture();
+			command.texture = (texture) ? texture->get() : nullptr;
+			command.component = component;
+			command.source = component->getSourceRect();
+			command.flip = component->getFlipValue();
+			command.zIndex = component->zIndex;
+			command.level = 0;
+			command.fullTexture = component->drawFullTexture();
+			command.customDraw = component->hasCustomDraw();
+			command.occluded = false;
+			command.pixelsUpdated = component->hasUpdatedPixels();
+
+			vec2 position = object.getPosition();
+			vec2 size = object.getSize();
+
+			if (command.customDraw)
+			{
+				// The destination is the area covered by the component, already in world coordinates
+				SDL_FRect bounds = component->getCustomDrawBounds();
+				position = { bounds.x, bounds.y };
+				size = { 1.f, 1.f };
+				m_width[i] = bounds.w;
+				m_height[i] = bounds.h;
+			}
+			else if (command.fullTexture)
+			{
+				m_width[i] = (texture) ? (float)texture->getWidth() : 0.f;
+				m_height[i] = (texture) ? (float)texture->getHeight() : 0.f;
+			}
+			else
+			{
+				m_width[i] = (float)command.source.w;
+				m_height[i] = (float)command.source.h;
+			}
+
+			// Sizes are used as whole multipliers
+			m_scaleX[i] = (float)(int)size.x;
+			m_scaleY[i] = (float)(int)size.y;
+			m_center[i] = (component->centerOrigin() && !command.customDraw) ? 1.f : 0.f;
+
+			if (!command.customDraw && !command.fullTexture && component->isTrimmed())
+			{
+				// Centering uses the whole frame, then the visible part is moved to its place in the frame,
+				// mirrored when flipped. Offsets are whole pixels so trimmed sprites land on the same pixels
+				// as untrimmed ones once rounded
+				const SDL_Rect& trim = component->getTrim();
+				int offsetX = (command.flip & SDL_FLIP_HORIZONTAL) ? trim.w - trim.x - command.source.w : trim.x;
+				int offsetY = (command.flip & SDL_FLIP_VERTICAL) ? trim.h - trim.y - command.source.h : trim.y;
+
+				position.x += offsetX * m_scaleX[i] - m_center[i] * (float)(int)(trim.w * m_scaleX[i] * 0.5f);
+				position.y += offsetY * m_scaleY[i] - m_center[i] * (float)(int)(trim.h * m_scaleY[i] * 0.5f);
+				m_center[i] = 0.f;
+			}
+
+			m_positionX[i] = position.x;
+			m_positionY[i] = position.y;
+
+			// Screen-position objects are not offset by camera translation nor zoomed
+			bool screenPosition = object.isScreenPosition();
+			command.userInterface = screenPosition || object.matchLayers(LAYER_UI);
+			m_offsetX[i] = screenPosition ? 0.f : cameraTopLeft.x;
+			m_offsetY[i] = screenPosition ? 0.f : cameraTopLeft.y;
+			m_zoom[i] = screenPosition ? 1.f : zoom;
+		}
+	}
+
+#if defined(SG_USE_AVX)
+	SG_TARGET_AVX size_t DrawCommandBuffer::computeDestinationsAvx(size_t begin, size_t end)
+	{
+		size_t i = begin;
+		// Destination rectangles of a batch of drawables, written back to the commands
+		alignas(32) int x[8], y[8], right[8], bottom[8];
+
+		const __m256 half = _mm256_set1_ps(0.5f);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 width = _mm256_mul_ps(_mm256_loadu_ps(&m_width[i]), _mm256_loadu_ps(&m_scaleX[i]));
+			__m256 height = _mm256_mul_ps(_mm256_loadu_ps(&m_height[i]), _mm256_loadu_ps(&m_scaleY[i]));
+
+			// Truncating half of the size matches integer division
+			__m256 halfWidth = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(width, half)));
+			__m256 halfHeight = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(height, half)));
+
+			__m256 center = _mm256_loadu_ps(&m_center[i]);
+			__m256 left = _mm256_sub_ps(_mm256_loadu_ps(&m_positionX[i]), _mm256_mul_ps(center, halfWidth));
+			__m256 top = _mm256_sub_ps(_mm256_loadu_ps(&m_positionY[i]), _mm256_mul_ps(center, halfHeight));
+
+			left = _mm256_sub_ps(left, _mm256_loadu_ps(&m_offsetX[i]));
+			top = _mm256_sub_ps(top, _mm256_loadu_ps(&m_offsetY[i]));
+
+			// Both edges are rounded down so zoomed neighbours don't leave gaps between them
+			__m256 zoom = _mm256_loadu_ps(&m_zoom[i]);
+			_mm256_store_si256((__m256i*)x, _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(left, zoom))));
+			_mm256_store_si256((__m256i*)y, _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(top, zoom))));
+			_mm256_store_si256((__m256i*)right, _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_add_ps(left, width), zoom))));
+			_mm256_store_si256((__m256i*)bottom, _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_add_ps(top, height), zoom))));
+
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				m_commands[i + lane].destination = { x[lane], y[lane], right[lane] - x[lane], bottom[lane] - y[lane] };
+			}
+		}
+		return i;
+	}
+#endif
+
+	void DrawCommandBuffer::computeDestinations(size_t begin, size_t end)
+	{
+		size_t i = begin;
+
+#if defined(SG_USE_AVX)
+		if (Cpu::hasAvx())
+		{
+			i = computeDestinationsAvx(begin, end);
+		}
+#endif
+#if defined(SG_USE_SSE2)
+		// Destination rectangles of a batch of drawables, written back to the commands
+		alignas(16) int x[4], y[4], right[4], bottom[4];
+
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 one = _mm_set1_ps(1.f);
+		// SSE2 has no floor, truncate then step back where truncation rounded up
+		auto roundDown = [&one](__m128 value) -> __m128
+		{
+			__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), one));
+		};
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 width = _mm_mul_ps(_mm_loadu_ps(&m_width[i]), _mm_loadu_ps(&m_scaleX[i]));
+			__m128 height = _mm_mul_ps(_mm_loadu_ps(&m_height[i]), _mm_loadu_ps(&m_scaleY[i]));
+
+			// Truncating half of the size matches integer division
+			__m128 halfWidth = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(width, half)));
+			__m128 halfHeight = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(height, half)));
+
+			__m128 center = _mm_loadu_ps(&m_center[i]);
+			__m128 left = _mm_sub_ps(_mm_loadu_ps(&m_positionX[i]), _mm_mul_ps(center, halfWidth));
+			__m128 top = _mm_sub_ps(_mm_loadu_ps(&m_positionY[i]), _mm_mul_ps(center, halfHeight));
+
+			left = _mm_sub_ps(left, _mm_loadu_ps(&m_offsetX[i]));
+			top = _mm_sub_ps(top, _mm_loadu_ps(&m_offsetY[i]));
+
+			// Both edges are rounded down so zoomed neighbours don't leave gaps between them
+			__m128 zoom = _mm_loadu_ps(&m_zoom[i]);
+			_mm_store_si128((__m128i*)x, _mm_cvttps_epi32(roundDown(_mm_mul_ps(left, zoom))));
+			_mm_store_si128((__m128i*)y, _mm_cvttps_epi32(roundDown(_mm_mul_ps(top, zoom))));
+			_mm_store_si128((__m128i*)right, _mm_cvttps_epi32(roundDown(_mm_mul_ps(_mm_add_ps(left, width), zoom))));
+			_mm_store_si128((__m128i*)bottom, _mm_cvttps_epi32(roundDown(_mm_mul_ps(_mm_add_ps(top, height), zoom))));
+
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				m_commands[i + lane].destination = { x[lane], y[lane], right[lane] - x[lane], bottom[lane] - y[lane] };
+			}
+		}
+#endif
+
+		// Remaining drawables, or every drawable when SIMD isn't available
+		for (; i < end; ++i)
+		{
+			float width = m_width[i] * m_scaleX[i];
+			float height = m_height[i] * m_scaleY[i];
+
+			float left = m_positionX[i] - m_center[i] * (float)(int)(width * 0.5f) - m_offsetX[i];
+			float top = m_positionY[i] - m_center[i] * (float)(int)(height * 0.5f) - m_offsetY[i];
+
+			SDL_Rect& destination = m_commands[i].destination;
+			destination.x = (int)std::floor(left * m_zoom[i]);
+			destination.y = (int)std::floor(top * m_zoom[i]);
+			destination.w = (int)std::floor((left + width) * m_zoom[i]) - destination.x;
+			destination.h = (int)std::floor((top + height) * m_zoom[i]) - destination.y;
+		}
+	}
+
+	void DrawCommandBuffer::selectLevels(size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			DrawCommand& command = m_commands[i];
+			if (command.customDraw || command.texture == nullptr) continue;
+
+			const Texture* texture = command.component->getTexture();
+			const TextureLevels* levels = texture->getLevels();
+			if (levels == nullptr || levels->getCount() == 0) continue;
+
+			command.level = levels->select((command.fullTexture) ? nullptr : &(command.source),
+				texture->getWidth(), texture->getHeight(), command.destination);
+			if (command.level > 0)
+			{
+				command.texture = levels->get(command.level);
+			}
+		}
+	}
+}
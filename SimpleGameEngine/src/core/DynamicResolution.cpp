@@ -0,0 +1,48 @@
+#include "core/DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sg
+{
+	void DynamicResolution::setSettings(const DynamicResolutionSettings& settings)
+	{
+		m_settings = settings;
+		m_settings.minScale = std::clamp(m_settings.minScale, DYNAMIC_RESOLUTION_STEP, 1.f);
+		m_settings.maxScale = std::clamp(m_settings.maxScale, m_settings.minScale, 1.f);
+
+		m_scale = m_settings.maxScale;
+		m_averageFrameTime = 0.f;
+		m_framesSinceChange = 0;
+	}
+
+	bool DynamicResolution::update(float frameTime)
+	{
+		// Smooth frame times so a single hitch doesn't drop the resolution
+		m_averageFrameTime = (m_averageFrameTime > 0.f) ? m_averageFrameTime * 0.9f + frameTime * 0.1f : frameTime;
+
+		if (++m_framesSinceChange < DYNAMIC_RESOLUTION_COOLDOWN || m_averageFrameTime <= 0.f) return false;
+
+		float factor = std::sqrt(m_settings.targetFrameTime / m_averageFrameTime);
+		float scale = m_scale;
+
+		if (m_averageFrameTime > m_settings.targetFrameTime)
+		{
+			scale *= std::max(factor, 0.85f);
+		}
+		// Leave some headroom before going back up to avoid oscillating around the target
+		else if (m_averageFrameTime < m_settings.targetFrameTime * 0.8f)
+		{
+			scale *= std::min(factor, 1.05f);
+		}
+
+		scale = std::round(scale / DYNAMIC_RESOLUTION_STEP) * DYNAMIC_RESOLUTION_STEP;
+		scale = std::clamp(scale, m_settings.minScale, m_settings.maxScale);
+
+		if (scale == m_scale) return false;
+
+		m_scale = scale;
+		m_framesSinceChange = 0;
+		return true;
+	}
+}
@@ -0,0 +1,185 @@
+#include "core/FrameCapture.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sg
+{
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared frame counters must be lock free");
+
+	namespace
+	{
+		size_t alignToCacheLine(size_t size)
+		{
+			return (size + 63) & ~(size_t)63;
+		}
+	}
+
+	bool FrameCapture::start(int width, int height, const FrameCaptureSettings& settings, Uint32 pixelFormat)
+	{
+		stop();
+
+		if (width <= 0 || height <= 0 || settings.slotCount == 0 || SDL_BYTESPERPIXEL(pixelFormat) != 4)
+		{
+			return false;
+		}
+
+		m_settings = settings;
+		m_settings.frameInterval = std::max(m_settings.frameInterval, 1u);
+
+		size_t pitch = (size_t)width * 4;
+		m_headerSize = alignToCacheLine(sizeof(FrameCaptureHeader));
+		m_slotHeaderSize = alignToCacheLine(sizeof(FrameSlotHeader));
+		size_t slotSize = m_slotHeaderSize + alignToCacheLine(pitch * height);
+		m_size = m_headerSize + slotSize * m_settings.slotCount;
+
+#if defined(__linux__)
+		// The descriptor is inherited by child processes so an encoder can be spawned with it
+		m_fd = memfd_create(m_settings.name.c_str(), 0);
+		if (m_fd < 0)
+		{
+			return false;
+		}
+
+		void* memory = MAP_FAILED;
+		if (ftruncate(m_fd, (off_t)m_size) == 0)
+		{
+			memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		}
+
+		if (memory == MAP_FAILED)
+		{
+			close(m_fd);
+			m_fd = -1;
+			m_size = 0;
+			return false;
+		}
+		m_memory = (uint8_t*)memory;
+
+		// Touch every page now so capturing a frame never faults
+		std::memset(m_memory, 0, m_size);
+#else
+		m_localMemory.assign(m_size, 0);
+		m_memory = m_localMemory.data();
+#endif
+
+		FrameCaptureHeader* info = new (m_memory) FrameCaptureHeader;
+		info->magic = FRAME_CAPTURE_MAGIC;
+		info->version = FRAME_CAPTURE_VERSION;
+		info->width = (uint32_t)width;
+		info->height = (uint32_t)height;
+		info->pitch = (uint32_t)pitch;
+		info->pixelFormat = pixelFormat;
+		info->slotCount = m_settings.slotCount;
+		info->slotSize = (uint32_t)slotSize;
+		info->writeIndex.store(0, std::memory_order_relaxed);
+		info->readIndex.store(0, std::memory_order_relaxed);
+		info->droppedFrames.store(0, std::memory_order_relaxed);
+
+		for (uint64_t i = 0; i < m_settings.slotCount; ++i)
+		{
+			FrameSlotHeader* frame = new (slot(i)) FrameSlotHeader;
+			frame->sequence.store(0, std::memory_order_relaxed);
+			frame->timestamp = 0;
+			frame->frameNumber = 0;
+		}
+
+		// Consumers may start reading as soon as the header is published
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_frameNumber = 0;
+		m_start = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	void FrameCapture::stop()
+	{
+#if defined(__linux__)
+		if (m_memory)
+		{
+			munmap(m_memory, m_size);
+		}
+		if (m_fd >= 0)
+		{
+			close(m_fd);
+		}
+#endif
+
+		m_memory = nullptr;
+		m_localMemory.clear();
+		m_localMemory.shrink_to_fit();
+		m_size = 0;
+		m_fd = -1;
+	}
+
+	FrameSlotHeader* FrameCapture::slot(uint64_t index) const
+	{
+		return (FrameSlotHeader*)(m_memory + m_headerSize + (index % m_settings.slotCount) * header()->slotSize);
+	}
+
+	void FrameCapture::capture(SDL_Renderer* renderer)
+	{
+		if (m_memory == nullptr) return;
+
+		uint64_t frameNumber = m_frameNumber++;
+		if (frameNumber % m_settings.frameInterval != 0) return;
+
+		FrameCaptureHeader* info = header();
+
+		// Frames of another size don't fit in the slots
+		int width = 0, height = 0;
+		SDL_GetRendererOutputSize(renderer, &width, &height);
+		if ((uint32_t)width != info->width || (uint32_t)height != info->height)
+		{
+			info->droppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// Only this thread writes frames, the consumer only moves readIndex forward
+		uint64_t index = info->writeIndex.load(std::memory_order_relaxed);
+		if (!m_settings.overwrite && index - info->readIndex.load(std::memory_order_acquire) >= info->slotCount)
+		{
+			info->droppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// An odd sequence tells consumers the slot is being written
+		FrameSlotHeader* frame = slot(index);
+		frame->sequence.store(2 * index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		frame->timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - m_start).count();
+		frame->frameNumber = frameNumber;
+
+		if (SDL_RenderReadPixels(renderer, nullptr, info->pixelFormat, slotPixels(index), (int)info->pitch) != 0)
+		{
+			// The slot doesn't hold a complete frame anymore
+			frame->sequence.store(0, std::memory_order_release);
+			info->droppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		frame->sequence.store(2 * (index + 1), std::memory_order_release);
+		info->writeIndex.store(index + 1, std::memory_order_release);
+	}
+
+	FrameCaptureStatistics FrameCapture::getStatistics() const
+	{
+		FrameCaptureStatistics statistics;
+		if (m_memory)
+		{
+			statistics.captured = header()->writeIndex.load(std::memory_order_relaxed);
+			statistics.dropped = header()->droppedFrames.load(std::memory_order_relaxed);
+		}
+		return statistics;
+	}
+}
@@ -0,0 +1,122 @@
+#include "core/FrameLimiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace sg
+{
+	FrameLimiter::FrameLimiter() :
+		m_deadline(Clock::now()), m_lastFrameEnd(Clock::now())
+	{
+		m_frameTimes.reserve(FRAME_PACING_WINDOW);
+	}
+
+	void FrameLimiter::setTargetFrameRate(unsigned int frameRate)
+	{
+		m_targetFrameRate = frameRate;
+		m_framePeriod = (frameRate > 0)
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate))
+			: Clock::duration::zero();
+		m_deadline = Clock::now() + m_framePeriod;
+		m_missedDeadlines = 0;
+	}
+
+	void FrameLimiter::waitUntil(Clock::time_point deadline)
+	{
+		// Sleep most of the time, the scheduler usually wakes us up late
+		Clock::time_point sleepEnd = deadline - m_spinMargin;
+		Clock::time_point now = Clock::now();
+		if (sleepEnd > now)
+		{
+			std::this_thread::sleep_until(sleepEnd);
+
+			// Adapt the margin to the observed oversleep, keeping it within reasonable bounds
+			Clock::duration oversleep = Clock::now() - sleepEnd;
+			Clock::duration target = std::clamp<Clock::duration>(oversleep * 2,
+				std::chrono::microseconds(200), std::chrono::milliseconds(4));
+			m_spinMargin = (m_spinMargin * 7 + target) / 8;
+		}
+
+		// Spin the remaining time for precision
+		while (Clock::now() < deadline)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void FrameLimiter::endFrame()
+	{
+		if (m_targetFrameRate > 0)
+		{
+			Clock::time_point now = Clock::now();
+			if (now > m_deadline)
+			{
+				++m_missedDeadlines;
+				// Don't try to catch up after a hitch, the next frame gets a full period
+				m_deadline = now + m_framePeriod;
+			}
+			else
+			{
+				waitUntil(m_deadline);
+				m_deadline += m_framePeriod;
+			}
+		}
+
+		Clock::time_point frameEnd = Clock::now();
+		float frameTime = std::chrono::duration<float>(frameEnd - m_lastFrameEnd).count();
+		m_lastFrameEnd = frameEnd;
+		m_lastFrameTime = frameTime;
+
+		// Keep the last frame times in a circular buffer
+		if (m_frameTimes.size() < FRAME_PACING_WINDOW)
+		{
+			m_frameTimes.push_back(frameTime);
+		}
+		else
+		{
+			m_frameTimes[m_nextFrameTime] = frameTime;
+		}
+		m_nextFrameTime = (m_nextFrameTime + 1) % FRAME_PACING_WINDOW;
+	}
+
+	void FrameLimiter::reset()
+	{
+		m_lastFrameEnd = Clock::now();
+		m_deadline = m_lastFrameEnd + m_framePeriod;
+	}
+
+	FramePacing FrameLimiter::getPacing() const
+	{
+		FramePacing pacing;
+		pacing.missedDeadlines = m_missedDeadlines;
+
+		if (m_frameTimes.empty())
+		{
+			return pacing;
+		}
+
+		float sum = 0.f;
+		pacing.minFrameTime = m_frameTimes[0];
+		pacing.maxFrameTime = m_frameTimes[0];
+		for (float frameTime : m_frameTimes)
+		{
+			sum += frameTime;
+			pacing.minFrameTime = std::min(pacing.minFrameTime, frameTime);
+			pacing.maxFrameTime = std::max(pacing.maxFrameTime, frameTime);
+		}
+
+		pacing.averageFrameTime = sum / m_frameTimes.size();
+		pacing.averageFrameRate = (pacing.averageFrameTime > 0.f) ? 1.f / pacing.averageFrameTime : 0.f;
+
+		float variance = 0.f;
+		for (float frameTime : m_frameTimes)
+		{
+			float difference = frameTime - pacing.averageFrameTime;
+			variance += difference * difference;
+		}
+		pacing.jitter = std::sqrt(variance / m_frameTimes.size());
+
+		return pacing;
+	}
+}
@@ -1,9 +1,13 @@
 #include <sstream>
 #include <chrono>
 #include <iostream>
+#include <unordered_set>
 
 #include "core/Game.h"
 #include "core/Parser.h"
+#include "core/Profiler.h"
+#include "core/Tracepoints.h"
+#include "core/UpdateCosts.h"
 #include "core/Object/ObjectBlueprint.h"
 #include "components/Component.h"
 
@@ -11,6 +15,8 @@ namespace sg
 {
 	std::vector<Object*> Game::objects;
 	std::queue<Object*> Game::destroyQueue;
+	bool Game::tickRequested = false;
+	float Game::fixedDelta = 0.f;
 
 	//Quadtree Game::quadtree;
 
@@ -37,6 +43,7 @@ namespace sg
 	Object& Game::prepareObject(Object* obj)
 	{
 		objects.push_back(obj);
+		SG_TRACE2(object_spawn, obj, obj->getName().c_str());
 
 		//quadtree.insert(obj);
 
@@ -96,6 +103,12 @@ namespace sg
 	std::vector<Object*> Game::getAllOrphanObjects()
 	{
 		std::vector<Object*> orphans;
+		getAllOrphanObjects(orphans);
+		return orphans;
+	}
+
+	void Game::getAllOrphanObjects(std::vector<Object*>& orphans)
+	{
 		for (Object* object : objects)
 		{
 			if (object->isOrphan())
@@ -103,18 +116,27 @@ namespace sg
 				orphans.push_back(object);
 			}
 		}
-
-		return orphans;
 	}
 
 	void Game::dispatchUpdates()
 	{
+		SG_PROFILE_SCOPE("Game::dispatchUpdates");
+
 		static auto lastFramePoint = std::chrono::steady_clock::now();
 		
 		auto thisFramePoint = std::chrono::steady_clock::now();
 
 		std::chrono::duration<double> duration = thisFramePoint - lastFramePoint;
-		float delta = static_cast<float>(duration.count());
+		float delta = (fixedDelta > 0.f) ? fixedDelta : static_cast<float>(duration.count());
+
+		// Requests made during these updates apply to the next frame
+		tickRequested = false;
+
+		bool trackCosts = UpdateCosts::isEnabled();
+		if (trackCosts)
+		{
+			UpdateCosts::beginFrame();
+		}
 		
 		// We don't use iterator here because an update might instanciate
 		// a new object
@@ -123,32 +145,48 @@ namespace sg
 			objects[i]->updateScripts(delta);
 		}
 
+		if (trackCosts)
+		{
+			UpdateCosts::endFrame();
+		}
+
 		// Destroy objects
-		processDestruction();
+		{
+			SG_PROFILE_SCOPE("Game::processDestruction");
+			processDestruction();
+		}
 
 		lastFramePoint = std::chrono::steady_clock::now();
 	}
 
 	void Game::processDestruction()
 	{
+		if (destroyQueue.empty()) return;
+
+		// An object can be queued more than once, e.g. along with its parent
+		std::unordered_set<Object*> destroyed;
 		while (!destroyQueue.empty())
 		{
-			Object* obj = destroyQueue.front();
+			destroyed.insert(destroyQueue.front());
+			destroyQueue.pop();
+		}
 
-			for (auto it = objects.begin(); it < objects.end(); ++it)
+		// Objects are removed in a single pass so destroying a large scene isn't quadratic
+		size_t kept = 0;
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			Object* obj = objects[i];
+			if (destroyed.count(obj))
 			{
-				if (*it == obj)
-				{
-					//quadtree.remove(*it);
-
-					Object* ptr = *it;
-					objects.erase(it);
-					delete ptr;
-					break;
-				}
+				//quadtree.remove(obj);
+				SG_TRACE2(object_destroy, obj, obj->getName().c_str());
+				delete obj;
+			}
+			else
+			{
+				objects[kept++] = obj;
 			}
-
-			destroyQueue.pop();
 		}
+		objects.resize(kept);
 	}
 }
@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "core/Input.h"
+#include "core/InputRecorder.h"
 
 namespace sg
 {
@@ -85,6 +86,11 @@ namespace sg
 		{
 			auto& state = *it;
 			state.frameReleased = state.numFramesPressed;
+
+			if (InputRecorder::isRecording())
+			{
+				InputRecorder::record({ InputRecorder::KeyUp, key, 0, { 0.f, 0.f } });
+			}
 		}
 	}
 
@@ -96,6 +102,11 @@ namespace sg
 			Input::InputState state;
 			state.keycode = key;
 			keys.push_back(state);
+
+			if (InputRecorder::isRecording())
+			{
+				InputRecorder::record({ InputRecorder::KeyDown, key, 0, { 0.f, 0.f } });
+			}
 		}
 	}
 
@@ -142,6 +153,11 @@ namespace sg
 		{
 			auto& state = *it;
 			state.frameReleased = state.numFramesPressed;
+
+			if (InputRecorder::isRecording())
+			{
+				InputRecorder::record({ InputRecorder::ButtonUp, SDLK_UNKNOWN, buttonIndex, { 0.f, 0.f } });
+			}
 		}
 	}
 
@@ -153,6 +169,11 @@ namespace sg
 			Input::MouseButtonState state;
 			state.button = buttonIndex;
 			mouseButtons.push_back(state);
+
+			if (InputRecorder::isRecording())
+			{
+				InputRecorder::record({ InputRecorder::ButtonDown, SDLK_UNKNOWN, buttonIndex, { 0.f, 0.f } });
+			}
 		}
 	}
 
@@ -238,7 +259,7 @@ namespace sg
 		}
 		else
 		{
-			return getMouseScreenPosition() + Window::getCameraTopLeft();
+			return getMouseScreenPosition() * (1.f / Window::getCameraZoom()) + Window::getCameraTopLeft();
 		}
 	}
 
@@ -262,5 +283,10 @@ namespace sg
 			mousePosition.x = (float)motion.x;
 			mousePosition.y = (float)motion.y;
 		}
+
+		if (InputRecorder::isRecording())
+		{
+			InputRecorder::record({ InputRecorder::MouseMotion, SDLK_UNKNOWN, 0, mousePosition });
+		}
 	}
 }
@@ -0,0 +1,195 @@
+#include "core/InputRecorder.h"
+#include "core/Input.h"
+#include "core/Game.h"
+
+namespace sg
+{
+	bool InputRecorder::recording = false;
+	bool InputRecorder::replaying = false;
+	uint32_t InputRecorder::frame = 0;
+	std::ofstream InputRecorder::file;
+	std::vector<InputRecorder::Event> InputRecorder::pendingEvents;
+	std::vector<InputRecorder::Event> InputRecorder::replayEvents;
+	std::vector<size_t> InputRecorder::replayFrames;
+	size_t InputRecorder::replayFrame = 0;
+
+	namespace
+	{
+		// Offset of the number of frames in the header
+		const std::streamoff frameCountOffset = 12;
+
+		template <typename T>
+		void write(std::ofstream& out, const T& value)
+		{
+			out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template <typename T>
+		bool read(std::ifstream& in, T& value)
+		{
+			return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+		}
+	}
+
+	bool InputRecorder::startRecording(const std::string& path, float fixedDelta)
+	{
+		stop();
+
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		// The number of frames is written when recording stops
+		write<uint32_t>(file, INPUT_RECORDING_MAGIC);
+		write<uint32_t>(file, INPUT_RECORDING_VERSION);
+		write<float>(file, fixedDelta);
+		write<uint32_t>(file, 0);
+
+		recording = true;
+		frame = 0;
+		pendingEvents.clear();
+		Game::setFixedDelta(fixedDelta);
+		return true;
+	}
+
+	bool InputRecorder::startReplay(const std::string& path)
+	{
+		stop();
+
+		std::ifstream in(path, std::ios::binary);
+		uint32_t magic = 0, version = 0, numFrames = 0;
+		float fixedDelta = 0.f;
+		if (!read(in, magic) || !read(in, version) || !read(in, fixedDelta) || !read(in, numFrames) ||
+			magic != INPUT_RECORDING_MAGIC || version != INPUT_RECORDING_VERSION)
+		{
+			return false;
+		}
+
+		replayEvents.clear();
+		replayFrames.clear();
+		replayFrames.reserve(numFrames);
+
+		// Frames are read until the end of the file, the header count is missing if recording never stopped
+		uint16_t numEvents = 0;
+		bool valid = true;
+		while (valid && read(in, numEvents))
+		{
+			replayFrames.push_back(replayEvents.size());
+			for (uint16_t i = 0; valid && i < numEvents; ++i)
+			{
+				Event event{ KeyDown, SDLK_UNKNOWN, 0, { 0.f, 0.f } };
+				uint8_t type = 0;
+				valid = read(in, type);
+				event.type = (EventType)type;
+
+				switch (event.type)
+				{
+				case KeyDown:
+				case KeyUp:
+					valid = valid && read(in, event.key);
+					break;
+				case ButtonDown:
+				case ButtonUp:
+					valid = valid && read(in, event.button);
+					break;
+				case MouseMotion:
+					valid = valid && read(in, event.mouse.x) && read(in, event.mouse.y);
+					break;
+				default:
+					valid = false;
+					break;
+				}
+
+				replayEvents.push_back(event);
+			}
+
+			// A truncated or corrupted frame is dropped along with everything after it
+			if (!valid)
+			{
+				replayEvents.resize(replayFrames.back());
+				replayFrames.pop_back();
+			}
+		}
+
+		replaying = true;
+		frame = 0;
+		replayFrame = 0;
+		Game::setFixedDelta(fixedDelta);
+		return true;
+	}
+
+	void InputRecorder::stop()
+	{
+		// Updates go back to real time
+		if (recording || replaying)
+		{
+			Game::setFixedDelta(0.f);
+		}
+
+		if (recording)
+		{
+			file.seekp(frameCountOffset);
+			write<uint32_t>(file, frame);
+			file.close();
+			recording = false;
+		}
+
+		if (replaying)
+		{
+			replayEvents.clear();
+			replayFrames.clear();
+			replaying = false;
+		}
+	}
+
+	void InputRecorder::processFrame()
+	{
+		if (recording)
+		{
+			write<uint16_t>(file, (uint16_t)pendingEvents.size());
+			for (const Event& event : pendingEvents)
+			{
+				write<uint8_t>(file, event.type);
+				switch (event.type)
+				{
+				case KeyDown:
+				case KeyUp:
+					write(file, event.key);
+					break;
+				case ButtonDown:
+				case ButtonUp:
+					write(file, event.button);
+					break;
+				case MouseMotion:
+					write(file, event.mouse.x);
+					write(file, event.mouse.y);
+					break;
+				}
+			}
+
+			pendingEvents.clear();
+			++frame;
+		}
+		else if (replaying && !isReplayFinished())
+		{
+			size_t end = (replayFrame + 1 < replayFrames.size()) ? replayFrames[replayFrame + 1] : replayEvents.size();
+			for (size_t i = replayFrames[replayFrame]; i < end; ++i)
+			{
+				const Event& event = replayEvents[i];
+				switch (event.type)
+				{
+				case KeyDown: Input::addKey(event.key); break;
+				case KeyUp: Input::removeKey(event.key); break;
+				case ButtonDown: Input::addButton(event.button); break;
+				case ButtonUp: Input::removeButton(event.button); break;
+				case MouseMotion: Input::mousePosition = event.mouse; break;
+				}
+			}
+
+			++replayFrame;
+			++frame;
+		}
+	}
+}
@@ -0,0 +1,345 @@
+#include "core/Log.h"
+#include "core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sg
+{
+	namespace
+	{
+		struct LogRecord
+		{
+			uint64_t time;
+			unsigned int thread;
+			LogLevel level;
+			char message[LOG_MESSAGE_SIZE];
+		};
+
+		// Written by the thread owning it only, read by whoever holds drainMutex
+		struct ThreadRing
+		{
+			LogRecord records[LOG_RECORDS_PER_THREAD];
+			// Record n is at n % LOG_RECORDS_PER_THREAD, written records are below head and drained ones below tail
+			std::atomic<uint64_t> head{ 0 };
+			std::atomic<uint64_t> tail{ 0 };
+			// Released when its thread exits, the next thread starting to log takes it over
+			bool owned = true;
+		};
+
+		// Rings outlive their thread so records of finished threads are still written, and are reused so
+		// there are never more rings than threads logging at the same time
+		std::mutex ringsMutex;
+		std::vector<std::unique_ptr<ThreadRing>> rings;
+
+		struct RingOwner
+		{
+			ThreadRing* ring = nullptr;
+
+			~RingOwner()
+			{
+				if (ring == nullptr) return;
+
+				std::lock_guard<std::mutex> lock(ringsMutex);
+				ring->owned = false;
+				ring = nullptr;
+			}
+		};
+		thread_local RingOwner threadRing;
+
+		std::atomic<unsigned int> nextThreadId(1);
+
+		std::atomic<bool> running(false);
+		std::atomic<int> minimumLevel((int)LogLevel::Trace);
+		std::atomic<uint64_t> dropped(0);
+		uint64_t droppedReported = 0;
+		uint64_t startTime = Profiler::now();
+
+		// Only one thread drains at a time, the background one or one calling flush
+		std::mutex drainMutex;
+		std::FILE* output = nullptr;
+		std::vector<LogRecord> batch;
+
+		// Started by the first record written after the log is opened, so a log nothing writes to costs no thread
+		std::thread drainThread;
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		bool stopping = false;
+		// Set by the first record written since the background thread last drained, only that record wakes it
+		std::atomic<bool> drainPending(false);
+
+		// A joinable thread can't be destroyed, stop it if the log is still open when the program exits
+		struct CloseAtExit
+		{
+			~CloseAtExit() { Log::close(); }
+		} closeAtExit;
+
+		// Number shown for the calling thread, in order of first record
+		unsigned int getThreadId()
+		{
+			thread_local unsigned int id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+			return id;
+		}
+
+		ThreadRing& getThreadRing()
+		{
+			if (threadRing.ring == nullptr)
+			{
+				std::lock_guard<std::mutex> lock(ringsMutex);
+
+				// Records the previous thread left are drained as usual, the ring only has one writer at a time.
+				// The emptiest ring is taken, unless short-lived threads already filled more than half of it
+				ThreadRing* reused = nullptr;
+				uint64_t reusedPending = LOG_RECORDS_PER_THREAD / 2;
+				for (auto& ring : rings)
+				{
+					if (ring->owned) continue;
+
+					uint64_t pending = ring->head.load(std::memory_order_relaxed) - ring->tail.load(std::memory_order_acquire);
+					if (pending <= reusedPending)
+					{
+						reused = ring.get();
+						reusedPending = pending;
+					}
+				}
+
+				if (reused == nullptr)
+				{
+					rings.push_back(std::make_unique<ThreadRing>());
+					reused = rings.back().get();
+				}
+				reused->owned = true;
+				threadRing.ring = reused;
+			}
+
+			return *threadRing.ring;
+		}
+
+		const char* levelName(LogLevel level)
+		{
+			switch (level)
+			{
+			case LogLevel::Trace: return "Trace";
+			case LogLevel::Debug: return "Debug";
+			case LogLevel::Info: return "Info";
+			case LogLevel::Warning: return "Warning";
+			case LogLevel::Error: return "Error";
+			}
+			return "";
+		}
+
+		void writeRecord(std::FILE* file, const LogRecord& record)
+		{
+			double seconds = (double)(record.time - startTime) / 1e9;
+			std::fprintf(file, "[%10.4f] [%s] [Thread %u] %s\n", seconds, levelName(record.level), record.thread, record.message);
+		}
+
+		// Caller holds drainMutex
+		void drain()
+		{
+			batch.clear();
+			{
+				std::lock_guard<std::mutex> lock(ringsMutex);
+				for (auto& ring : rings)
+				{
+					uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+					uint64_t head = ring->head.load(std::memory_order_acquire);
+					for (; tail < head; ++tail)
+					{
+						batch.push_back(ring->records[tail % LOG_RECORDS_PER_THREAD]);
+					}
+					ring->tail.store(tail, std::memory_order_release);
+				}
+			}
+
+			// Records of different threads are written in the order they were logged
+			std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b)
+			{
+				return a.time < b.time;
+			});
+
+			for (const LogRecord& record : batch)
+			{
+				writeRecord(output, record);
+			}
+
+			uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+			if (droppedNow != droppedReported)
+			{
+				std::fprintf(output, "[Log] %llu records dropped, rings were full\n", (unsigned long long)(droppedNow - droppedReported));
+				droppedReported = droppedNow;
+			}
+
+			if (!batch.empty())
+			{
+				std::fflush(output);
+			}
+		}
+
+		void drainLoop()
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			while (true)
+			{
+				// Sleeps as long as nothing is logged, remaining records are drained by close
+				wake.wait(lock, [] { return stopping || drainPending.load(std::memory_order_acquire); });
+				if (stopping) break;
+
+				// Cleared before draining, records written meanwhile wake the thread again
+				drainPending.store(false, std::memory_order_release);
+
+				// Writers waking the thread don't wait for I/O
+				lock.unlock();
+				{
+					std::lock_guard<std::mutex> drainLock(drainMutex);
+					drain();
+				}
+				lock.lock();
+			}
+		}
+
+		// Wake the background thread, starting it if it isn't running yet
+		void wakeDrainThread()
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			if (stopping) return;
+
+			if (!drainThread.joinable())
+			{
+				drainThread = std::thread(drainLoop);
+			}
+			wake.notify_one();
+		}
+	}
+
+	bool Log::open(const std::string& path)
+	{
+		close();
+
+		std::FILE* file = (path.empty()) ? stderr : std::fopen(path.c_str(), "a");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(drainMutex);
+			output = file;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = false;
+		}
+		drainPending.store(false, std::memory_order_relaxed);
+		running.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void Log::close()
+	{
+		if (!running.exchange(false)) return;
+
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		if (drainThread.joinable())
+		{
+			drainThread.join();
+		}
+
+		// Records written while the thread stopped
+		std::lock_guard<std::mutex> lock(drainMutex);
+		drain();
+		if (output != stderr)
+		{
+			std::fclose(output);
+		}
+		output = nullptr;
+	}
+
+	bool Log::isOpen()
+	{
+		return running.load(std::memory_order_acquire);
+	}
+
+	void Log::setLevel(LogLevel level)
+	{
+		minimumLevel.store((int)level, std::memory_order_relaxed);
+	}
+
+	LogLevel Log::getLevel()
+	{
+		return (LogLevel)minimumLevel.load(std::memory_order_relaxed);
+	}
+
+	void Log::flush()
+	{
+		std::lock_guard<std::mutex> lock(drainMutex);
+		if (output)
+		{
+			drain();
+		}
+	}
+
+	uint64_t Log::getDroppedCount()
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	void Log::write(LogLevel level, const char* format, ...)
+	{
+		if ((int)level < minimumLevel.load(std::memory_order_relaxed)) return;
+
+		va_list arguments;
+		va_start(arguments, format);
+
+		// Nothing drains the rings, startup and shutdown messages aren't in hot paths
+		if (!running.load(std::memory_order_acquire))
+		{
+			LogRecord record;
+			record.time = Profiler::now();
+			record.thread = getThreadId();
+			record.level = level;
+			std::vsnprintf(record.message, LOG_MESSAGE_SIZE, format, arguments);
+			va_end(arguments);
+			writeRecord(stderr, record);
+			return;
+		}
+
+		ThreadRing& ring = getThreadRing();
+		uint64_t head = ring.head.load(std::memory_order_relaxed);
+		if (head - ring.tail.load(std::memory_order_acquire) >= LOG_RECORDS_PER_THREAD)
+		{
+			// The thread is already woken by the records filling the ring
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			va_end(arguments);
+			return;
+		}
+
+		// Formatted in place, the record is published once complete
+		LogRecord& record = ring.records[head % LOG_RECORDS_PER_THREAD];
+		record.time = Profiler::now();
+		record.thread = getThreadId();
+		record.level = level;
+		std::vsnprintf(record.message, LOG_MESSAGE_SIZE, format, arguments);
+		va_end(arguments);
+
+		ring.head.store(head + 1, std::memory_order_release);
+
+		// Records written until the background thread drains only publish theirs
+		if (!drainPending.exchange(true, std::memory_order_acq_rel))
+		{
+			wakeDrainThread();
+		}
+	}
+}
@@ -3,7 +3,10 @@
 
 #include "core/Object/Object.h"
 #include "core/Parser.h"
+#include "core/Profiler.h"
+#include "core/UpdateCosts.h"
 #include "core/Object/ObjectBlueprint.h"
+#include "core/StaticTileLayer.h"
 
 #include "components/ComponentInitializationData.h"
 #include "components/Updatable.h"
@@ -12,6 +15,8 @@
 #include "components/TextComponent.h"
 #include "components/TextureComponent.h"
 #include "components/TilesetComponent.h"
+#include "components/ParticleSystemComponent.h"
+#include "components/PixelBufferComponent.h"
 #include "components/ScriptComponent.h"
 
 namespace sg
@@ -51,6 +56,12 @@ namespace sg
 		case ComponentTypes::TextureComponent:
 			addComponent<class TextureComponent>(data);
 			break;
+		case ComponentTypes::ParticleSystemComponent:
+			addComponent<class ParticleSystemComponent>(data);
+			break;
+		case ComponentTypes::PixelBufferComponent:
+			addComponent<class PixelBufferComponent>(data);
+			break;
 		case ComponentTypes::TilesetComponent:
 			addComponent<class TilesetComponent>(data);
 		default:
@@ -171,13 +182,43 @@ namespace sg
 		}
 	}
 
+	void Object::setVisibility(bool newVisibility)
+	{
+		if (m_data.visible == newVisibility) return;
+		m_data.visible = newVisibility;
+
+		// Hidden static tiles are left out of their chunks when baking
+		for (Component* comp : m_components)
+		{
+			TilesetComponent* tile = dynamic_cast<TilesetComponent*>(comp);
+			if (tile && tile->isStatic())
+			{
+				StaticTileLayer::markDirty(tile);
+			}
+		}
+	}
+
 	void Object::updateScripts(float deltaSeconds)
 	{
+		SG_PROFILE_SCOPE("Object::updateScripts");
+
+		// Costs are attributed to the dynamic type of each script and component
+		bool trackCosts = UpdateCosts::isEnabled();
+
 		for (auto comp : m_components)
 		{
 			if (sg::Updatable* updatable = dynamic_cast<sg::Updatable*>(comp))
 			{
-				updatable->update(deltaSeconds);
+				if (trackCosts)
+				{
+					auto start = std::chrono::steady_clock::now();
+					updatable->update(deltaSeconds);
+					UpdateCosts::record(typeid(*comp), start);
+				}
+				else
+				{
+					updatable->update(deltaSeconds);
+				}
 			}
 		}
 
@@ -193,7 +234,16 @@ namespace sg
 
 			if (script->canUpdate)
 			{
-				script->update(deltaSeconds);
+				if (trackCosts)
+				{
+					auto start = std::chrono::steady_clock::now();
+					script->update(deltaSeconds);
+					UpdateCosts::record(typeid(*script), start);
+				}
+				else
+				{
+					script->update(deltaSeconds);
+				}
 			}
 		}
 	}
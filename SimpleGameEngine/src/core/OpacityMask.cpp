@@ -0,0 +1,99 @@
+#include "core/OpacityMask.h"
+
+#include <SDL.h>
+
+namespace sg
+{
+	OpacityMask::OpacityMask(SDL_Surface* surface)
+		: m_width(surface->w), m_height(surface->h)
+	{
+		// Surfaces without alpha channel nor color key are opaque everywhere
+		Uint32 colorKey;
+		bool keyed = SDL_GetColorKey(surface, &colorKey) == 0;
+		if (surface->format->Amask == 0 && !keyed)
+		{
+			m_fullyOpaque = true;
+			return;
+		}
+
+		// Color keyed pixels become transparent when converted to a format with alpha.
+		// If the conversion fails the image is considered translucent everywhere
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (converted == nullptr)
+		{
+			return;
+		}
+
+		m_cellsX = (m_width + OPACITY_CELL_SIZE - 1) / OPACITY_CELL_SIZE;
+		m_cellsY = (m_height + OPACITY_CELL_SIZE - 1) / OPACITY_CELL_SIZE;
+		std::vector<unsigned char> translucent((size_t)m_cellsX * m_cellsY, 0);
+
+		SDL_LockSurface(converted);
+		for (int y = 0; y < m_height; ++y)
+		{
+			const Uint32* row = (const Uint32*)((const Uint8*)converted->pixels + (size_t)y * converted->pitch);
+			unsigned char* cells = &translucent[(size_t)(y / OPACITY_CELL_SIZE) * m_cellsX];
+
+			for (int cellX = 0; cellX < m_cellsX; ++cellX)
+			{
+				int begin = cellX * OPACITY_CELL_SIZE;
+				int end = (begin + OPACITY_CELL_SIZE < m_width) ? begin + OPACITY_CELL_SIZE : m_width;
+
+				// Alpha is the highest byte, all of them are 0xFF only if every pixel is opaque
+				Uint32 alpha = 0xFF000000;
+				for (int x = begin; x < end; ++x)
+				{
+					alpha &= row[x];
+				}
+				if ((alpha & 0xFF000000) != 0xFF000000)
+				{
+					cells[cellX] = 1;
+				}
+			}
+		}
+		SDL_UnlockSurface(converted);
+		SDL_FreeSurface(converted);
+
+		// Any range of cells is then checked with four lookups
+		int stride = m_cellsX + 1;
+		m_translucentCells.assign((size_t)stride * (m_cellsY + 1), 0);
+		for (int cellY = 0; cellY < m_cellsY; ++cellY)
+		{
+			for (int cellX = 0; cellX < m_cellsX; ++cellX)
+			{
+				m_translucentCells[(size_t)(cellY + 1) * stride + cellX + 1] = translucent[(size_t)cellY * m_cellsX + cellX] +
+					m_translucentCells[(size_t)cellY * stride + cellX + 1] +
+					m_translucentCells[(size_t)(cellY + 1) * stride + cellX] -
+					m_translucentCells[(size_t)cellY * stride + cellX];
+			}
+		}
+
+		m_fullyOpaque = m_translucentCells.back() == 0;
+	}
+
+	bool OpacityMask::isOpaque(const SDL_Rect& source) const
+	{
+		// SDL clips source rectangles going out of the texture, the destination isn't entirely covered then
+		if (source.w <= 0 || source.h <= 0 || source.x < 0 || source.y < 0 ||
+			source.x + source.w > m_width || source.y + source.h > m_height)
+		{
+			return false;
+		}
+
+		if (m_fullyOpaque) return true;
+		if (m_translucentCells.empty()) return false;
+
+		int stride = m_cellsX + 1;
+		int firstX = source.x / OPACITY_CELL_SIZE;
+		int firstY = source.y / OPACITY_CELL_SIZE;
+		int lastX = (source.x + source.w - 1) / OPACITY_CELL_SIZE + 1;
+		int lastY = (source.y + source.h - 1) / OPACITY_CELL_SIZE + 1;
+
+		unsigned int count = m_translucentCells[(size_t)lastY * stride + lastX] -
+			m_translucentCells[(size_t)firstY * stride + lastX] -
+			m_translucentCells[(size_t)lastY * stride + firstX] +
+			m_translucentCells[(size_t)firstY * stride + firstX];
+
+		return count == 0;
+	}
+}
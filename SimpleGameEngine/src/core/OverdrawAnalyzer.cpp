@@ -0,0 +1,165 @@
+#include "core/OverdrawAnalyzer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace sg
+{
+	namespace
+	{
+		// Heatmap colors, index n is used for tiles written n + 1 times on average
+		const SDL_Color heatColors[] =
+		{
+			{ 40, 80, 255, 90 },
+			{ 40, 200, 80, 110 },
+			{ 240, 220, 40, 130 },
+			{ 255, 130, 30, 150 },
+			{ 255, 30, 30, 170 }
+		};
+	}
+
+	void OverdrawAnalyzer::beginFrame(int width, int height)
+	{
+		m_width = std::max(width, 0);
+		m_height = std::max(height, 0);
+		m_tilesX = (m_width + OVERDRAW_TILE_SIZE - 1) / OVERDRAW_TILE_SIZE;
+		m_tilesY = (m_height + OVERDRAW_TILE_SIZE - 1) / OVERDRAW_TILE_SIZE;
+		m_tilePixels.assign((size_t)m_tilesX * m_tilesY, 0);
+		m_framePixels = 0.0;
+		++m_numFrames;
+	}
+
+	void OverdrawAnalyzer::record(const SDL_Rect& destination, bool blended, const std::string& objectName,
+		const std::string& texturePath, float scale)
+	{
+		int left = std::max(destination.x, 0);
+		int top = std::max(destination.y, 0);
+		int right = std::min(destination.x + destination.w, m_width);
+		int bottom = std::min(destination.y + destination.h, m_height);
+		if (right <= left || bottom <= top) return;
+
+		// Tiles are in screen pixels, the heatmap shows how many layers cover each pixel whatever the scale
+		for (int tileY = top / OVERDRAW_TILE_SIZE; tileY * OVERDRAW_TILE_SIZE < bottom; ++tileY)
+		{
+			int height = std::min(bottom, (tileY + 1) * OVERDRAW_TILE_SIZE) - std::max(top, tileY * OVERDRAW_TILE_SIZE);
+			unsigned int* row = &m_tilePixels[(size_t)tileY * m_tilesX];
+
+			for (int tileX = left / OVERDRAW_TILE_SIZE; tileX * OVERDRAW_TILE_SIZE < right; ++tileX)
+			{
+				int width = std::min(right, (tileX + 1) * OVERDRAW_TILE_SIZE) - std::max(left, tileX * OVERDRAW_TILE_SIZE);
+				row[tileX] += (unsigned int)(width * height);
+			}
+		}
+
+		double pixels = (double)(right - left) * (bottom - top) * scale * scale;
+		double blendedBytes = (blended) ? pixels * OVERDRAW_BYTES_PER_PIXEL : 0.0;
+		m_framePixels += pixels;
+		m_totalPixels += pixels;
+		m_totalBlendedBytes += blendedBytes;
+
+		Entry& entry = m_entries[std::make_pair(objectName, texturePath)];
+		++entry.draws;
+		entry.pixels += pixels;
+		entry.blendedBytes += blendedBytes;
+	}
+
+	void OverdrawAnalyzer::drawHeatmap(SDL_Renderer* renderer)
+	{
+		for (std::vector<SDL_Rect>& rects : m_heatRects)
+		{
+			rects.clear();
+		}
+
+		for (int tileY = 0; tileY < m_tilesY; ++tileY)
+		{
+			for (int tileX = 0; tileX < m_tilesX; ++tileX)
+			{
+				unsigned int pixels = m_tilePixels[(size_t)tileY * m_tilesX + tileX];
+				if (pixels == 0) continue;
+
+				// Tiles on the right and bottom edges may be partly outside of the screen
+				SDL_Rect tile{ tileX * OVERDRAW_TILE_SIZE, tileY * OVERDRAW_TILE_SIZE, OVERDRAW_TILE_SIZE, OVERDRAW_TILE_SIZE };
+				tile.w = std::min(tile.w, m_width - tile.x);
+				tile.h = std::min(tile.h, m_height - tile.y);
+
+				// Average number of writes per pixel of the tile, rounded
+				int writes = (int)((pixels + (unsigned int)(tile.w * tile.h) / 2) / (unsigned int)(tile.w * tile.h));
+				if (writes <= 0) continue;
+
+				m_heatRects[std::min(writes, 5) - 1].push_back(tile);
+			}
+		}
+
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		for (int level = 0; level < 5; ++level)
+		{
+			const SDL_Color& color = heatColors[level];
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+			SDL_RenderFillRects(renderer, m_heatRects[level].data(), (int)m_heatRects[level].size());
+		}
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+	}
+
+	float OverdrawAnalyzer::getOverdraw() const
+	{
+		return (m_width > 0 && m_height > 0) ? (float)(m_framePixels / ((double)m_width * m_height)) : 0.f;
+	}
+
+	bool OverdrawAnalyzer::writeReport(const std::string& path, size_t count) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		double frames = (m_numFrames > 0) ? (double)m_numFrames : 1.0;
+		double screenPixels = std::max((double)m_width * m_height, 1.0);
+
+		file << std::fixed << std::setprecision(2);
+		file << "Overdraw report: " << m_numFrames << " frames at " << m_width << "x" << m_height << "\n";
+		file << "Average overdraw: " << m_totalPixels / frames / screenPixels << " writes per pixel\n";
+		file << "Pixels written per frame: " << m_totalPixels / frames << "\n";
+		file << "Bytes blended per frame: " << m_totalBlendedBytes / frames << "\n\n";
+
+		// Most expensive first
+		std::vector<std::pair<const std::pair<std::string, std::string>*, const Entry*>> sorted;
+		sorted.reserve(m_entries.size());
+		for (const auto& kvp : m_entries)
+		{
+			sorted.push_back(std::make_pair(&kvp.first, &kvp.second));
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b)
+			{
+				return a.second->fillBytes() > b.second->fillBytes();
+			});
+
+		count = std::min(count, sorted.size());
+		file << "Top " << count << " drawables by fill cost, per frame:\n";
+		file << std::setw(14) << "fill bytes" << std::setw(14) << "pixels" << std::setw(16) << "bytes blended"
+			<< std::setw(10) << "draws" << "  object  texture\n";
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const std::pair<std::string, std::string>& key = *sorted[i].first;
+			const Entry& entry = *sorted[i].second;
+
+			file << std::setw(14) << entry.fillBytes() / frames << std::setw(14) << entry.pixels / frames
+				<< std::setw(16) << entry.blendedBytes / frames << std::setw(10) << entry.draws / frames << "  "
+				<< ((key.first.empty()) ? "(unnamed)" : key.first) << "  "
+				<< ((key.second.empty()) ? "(no file)" : key.second) << "\n";
+		}
+
+		return file.good();
+	}
+
+	void OverdrawAnalyzer::reset()
+	{
+		m_numFrames = 0;
+		m_totalPixels = 0.0;
+		m_totalBlendedBytes = 0.0;
+		m_framePixels = 0.0;
+		m_entries.clear();
+	}
+}
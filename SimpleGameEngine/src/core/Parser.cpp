@@ -1,4 +1,7 @@
 #include "core/Parser.h"
+#include "core/Profiler.h"
+#include "core/Stats.h"
+#include "core/Tracepoints.h"
 
 #include <fstream>
 #include <sstream>
@@ -233,6 +236,9 @@ namespace sg
 
 	Parser::Parser(const std::string& path)
 	{
+		SG_PROFILE_SCOPE("Parser");
+		uint64_t loadStart = SG_TRACE_NOW();
+
 		file.open(path);
 
 		if (!file.is_open())
@@ -240,6 +246,11 @@ namespace sg
 			throw ParseException("Failed to open file. Make sure the path is valid.");
 		}
 
+		file.seekg(0, std::ios::end);
+		uint64_t bytes = (uint64_t)file.tellg();
+		Stats::addBytesLoaded(bytes);
+		file.seekg(0, std::ios::beg);
+
 		std::getline(file, line);
 		while (!file.eof())
 		{
@@ -259,6 +270,7 @@ namespace sg
 		}
 
 		file.close();
+		SG_TRACE3(parse_load, path.c_str(), SG_TRACE_NOW() - loadStart, bytes);
 	}
 	
 	std::string Parser::getNameFromContent(const std::string& content) const
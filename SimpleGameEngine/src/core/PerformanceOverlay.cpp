@@ -0,0 +1,248 @@
+#include "core/PerformanceOverlay.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+// Size in screen pixels of a font pixel
+#define OVERLAY_TEXT_SCALE 2
+// Width in screen pixels of a frame in the graph
+#define OVERLAY_BAR_WIDTH 2
+#define OVERLAY_GRAPH_HEIGHT 80
+#define OVERLAY_MARGIN 8
+#define OVERLAY_PADDING 6
+
+namespace sg
+{
+	namespace
+	{
+		// 3x5 pixel glyph, one row per element and the leftmost pixel in the highest bit
+		struct Glyph
+		{
+			char character;
+			unsigned char rows[5];
+		};
+
+		const Glyph glyphs[] =
+		{
+			{ '0', { 7, 5, 5, 5, 7 } }, { '1', { 2, 6, 2, 2, 7 } }, { '2', { 7, 1, 7, 4, 7 } },
+			{ '3', { 7, 1, 7, 1, 7 } }, { '4', { 5, 5, 7, 1, 1 } }, { '5', { 7, 4, 7, 1, 7 } },
+			{ '6', { 7, 4, 7, 5, 7 } }, { '7', { 7, 1, 1, 1, 1 } }, { '8', { 7, 5, 7, 5, 7 } },
+			{ '9', { 7, 5, 7, 1, 7 } }, { 'A', { 2, 5, 7, 5, 5 } }, { 'B', { 6, 5, 6, 5, 6 } },
+			{ 'C', { 3, 4, 4, 4, 3 } }, { 'D', { 6, 5, 5, 5, 6 } }, { 'E', { 7, 4, 6, 4, 7 } },
+			{ 'F', { 7, 4, 6, 4, 4 } }, { 'G', { 3, 4, 5, 5, 3 } }, { 'H', { 5, 5, 7, 5, 5 } },
+			{ 'I', { 7, 2, 2, 2, 7 } }, { 'J', { 1, 1, 1, 5, 2 } }, { 'K', { 5, 5, 6, 5, 5 } },
+			{ 'L', { 4, 4, 4, 4, 7 } }, { 'M', { 5, 7, 7, 5, 5 } }, { 'N', { 6, 5, 5, 5, 5 } },
+			{ 'O', { 2, 5, 5, 5, 2 } }, { 'P', { 6, 5, 6, 4, 4 } }, { 'Q', { 2, 5, 5, 6, 3 } },
+			{ 'R', { 6, 5, 6, 5, 5 } }, { 'S', { 3, 4, 2, 1, 6 } }, { 'T', { 7, 2, 2, 2, 2 } },
+			{ 'U', { 5, 5, 5, 5, 7 } }, { 'V', { 5, 5, 5, 5, 2 } }, { 'W', { 5, 5, 7, 7, 5 } },
+			{ 'X', { 5, 5, 2, 5, 5 } }, { 'Y', { 5, 5, 2, 2, 2 } }, { 'Z', { 7, 1, 2, 4, 7 } },
+			{ '.', { 0, 0, 0, 0, 2 } }, { ':', { 0, 2, 0, 2, 0 } }, { '%', { 5, 1, 2, 4, 5 } },
+			{ '/', { 1, 1, 2, 4, 4 } }, { '-', { 0, 0, 7, 0, 0 } }, { '(', { 2, 4, 4, 4, 2 } },
+			{ ')', { 2, 1, 1, 1, 2 } }
+		};
+
+		const Glyph* findGlyph(char character)
+		{
+			character = (char)std::toupper((unsigned char)character);
+			for (const Glyph& glyph : glyphs)
+			{
+				if (glyph.character == character)
+				{
+					return &glyph;
+				}
+			}
+
+			// Spaces and unknown characters are left blank
+			return nullptr;
+		}
+
+		const SDL_Color seriesColors[] =
+		{
+			{ 80, 160, 255, 255 },	// Update
+			{ 90, 220, 90, 255 },	// Draw
+			{ 255, 170, 60, 255 },	// Present
+			{ 110, 110, 110, 255 }	// Other, mostly waiting for the frame limiter
+		};
+	}
+
+	PerformanceOverlay::PerformanceOverlay()
+	{
+		m_frames.reserve(OVERLAY_GRAPH_FRAMES);
+	}
+
+	void PerformanceOverlay::addFrame(const FrameTimings& timings)
+	{
+		if (m_frames.size() < OVERLAY_GRAPH_FRAMES)
+		{
+			m_frames.push_back(timings);
+		}
+		else
+		{
+			m_frames[m_nextFrame] = timings;
+		}
+		m_nextFrame = (m_nextFrame + 1) % OVERLAY_GRAPH_FRAMES;
+	}
+
+	int PerformanceOverlay::addText(int x, int y, const char* text)
+	{
+		for (const char* character = text; *character != '\0'; ++character)
+		{
+			if (const Glyph* glyph = findGlyph(*character))
+			{
+				for (int row = 0; row < 5; ++row)
+				{
+					// Consecutive pixels of a row are merged in a single rectangle
+					int column = 0;
+					while (column < 3)
+					{
+						if (!(glyph->rows[row] & (4 >> column)))
+						{
+							++column;
+							continue;
+						}
+
+						int runStart = column;
+						while (column < 3 && (glyph->rows[row] & (4 >> column)))
+						{
+							++column;
+						}
+
+						m_textPixels.push_back({ x + runStart * OVERLAY_TEXT_SCALE, y + row * OVERLAY_TEXT_SCALE,
+							(column - runStart) * OVERLAY_TEXT_SCALE, OVERLAY_TEXT_SCALE });
+					}
+				}
+			}
+
+			x += 4 * OVERLAY_TEXT_SCALE;
+		}
+
+		return 7 * OVERLAY_TEXT_SCALE;
+	}
+
+	void PerformanceOverlay::buildGraph(int x, int y)
+	{
+		const float pixelsPerSecond = OVERLAY_GRAPH_HEIGHT / OVERLAY_GRAPH_MAX_TIME;
+		int bottom = y + OVERLAY_GRAPH_HEIGHT;
+
+		// Oldest frame on the left, bars are stacked from the bottom
+		size_t numFrames = m_frames.size();
+		size_t oldest = (numFrames < OVERLAY_GRAPH_FRAMES) ? 0 : m_nextFrame;
+		for (size_t i = 0; i < numFrames; ++i)
+		{
+			const FrameTimings& frame = m_frames[(oldest + i) % numFrames];
+			float other = std::max(0.f, frame.frame - frame.update - frame.draw - frame.present);
+			float values[NumSeries] = { frame.update, frame.draw, frame.present, other };
+
+			int top = bottom;
+			for (int series = 0; series < NumSeries; ++series)
+			{
+				int height = std::min((int)(values[series] * pixelsPerSecond), top - y);
+				if (height <= 0) continue;
+
+				top -= height;
+				m_bars[series].push_back({ x + (int)i * OVERLAY_BAR_WIDTH, top, OVERLAY_BAR_WIDTH, height });
+			}
+		}
+
+		// Guides at 60 and 30 frames per second
+		int width = OVERLAY_GRAPH_FRAMES * OVERLAY_BAR_WIDTH;
+		m_guides.push_back({ x, bottom - (int)(pixelsPerSecond / 60.f), width, 1 });
+		m_guides.push_back({ x, bottom - (int)(pixelsPerSecond / 30.f), width, 1 });
+	}
+
+	void PerformanceOverlay::draw(SDL_Renderer* renderer, const PerformanceCounters& counters)
+	{
+		if (!m_visible) return;
+
+		for (std::vector<SDL_Rect>& bars : m_bars)
+		{
+			bars.clear();
+		}
+		m_guides.clear();
+		m_textPixels.clear();
+
+		int x = OVERLAY_MARGIN + OVERLAY_PADDING;
+		int y = OVERLAY_MARGIN + OVERLAY_PADDING;
+		int width = OVERLAY_GRAPH_FRAMES * OVERLAY_BAR_WIDTH;
+
+		buildGraph(x, y);
+		y += OVERLAY_GRAPH_HEIGHT + OVERLAY_PADDING;
+
+		// Timings are averaged over the frames of the graph to be readable
+		FrameTimings average;
+		for (const FrameTimings& frame : m_frames)
+		{
+			average.update += frame.update;
+			average.draw += frame.draw;
+			average.present += frame.present;
+			average.frame += frame.frame;
+		}
+		if (!m_frames.empty())
+		{
+			float count = (float)m_frames.size();
+			average.update /= count;
+			average.draw /= count;
+			average.present /= count;
+			average.frame /= count;
+		}
+
+		char line[64];
+		snprintf(line, sizeof(line), "FPS %.1f  FRAME %.2f MS", (average.frame > 0.f) ? 1.f / average.frame : 0.f,
+			average.frame * 1000.f);
+		y += addText(x, y, line);
+
+		// Split lines start with a square of the series color
+		const char* names[] = { "UPDATE", "DRAW", "PRESENT" };
+		const float times[] = { average.update, average.draw, average.present };
+		int square = 5 * OVERLAY_TEXT_SCALE;
+		for (int series = 0; series < Present + 1; ++series)
+		{
+			m_bars[series].push_back({ x, y, square, square });
+			snprintf(line, sizeof(line), "%-8s %6.2f MS", names[series], times[series] * 1000.f);
+			y += addText(x + square + 2 * OVERLAY_TEXT_SCALE, y, line);
+		}
+
+		snprintf(line, sizeof(line), "OBJECTS %zu  DRAWABLES %zu", counters.objects, counters.drawables);
+		y += addText(x, y, line);
+		snprintf(line, sizeof(line), "DRAW CALLS %u  SCALE %d%%", counters.drawCalls,
+			(int)(counters.resolutionScale * 100.f + 0.5f));
+		y += addText(x, y, line);
+		if (counters.overdraw > 0.f)
+		{
+			snprintf(line, sizeof(line), "CULLED %u  OVERDRAW %.2fX", counters.culled, counters.overdraw);
+		}
+		else
+		{
+			snprintf(line, sizeof(line), "CULLED %u", counters.culled);
+		}
+		y += addText(x, y, line);
+		snprintf(line, sizeof(line), "TEXTURE CACHE %.1f%% (%zu)", counters.textureCache.hitRate() * 100.f,
+			counters.textureCache.size);
+		y += addText(x, y, line);
+		snprintf(line, sizeof(line), "ANIM CACHE %.1f%% (%zu)", counters.animationCache.hitRate() * 100.f,
+			counters.animationCache.size);
+		y += addText(x, y, line);
+
+		// Translucent background behind everything
+		SDL_Rect panel{ OVERLAY_MARGIN, OVERLAY_MARGIN, width + 2 * OVERLAY_PADDING, y - OVERLAY_MARGIN };
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+		SDL_RenderFillRect(renderer, &panel);
+
+		for (int series = 0; series < NumSeries; ++series)
+		{
+			const SDL_Color& color = seriesColors[series];
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+			SDL_RenderFillRects(renderer, m_bars[series].data(), (int)m_bars[series].size());
+		}
+
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 90);
+		SDL_RenderFillRects(renderer, m_guides.data(), (int)m_guides.size());
+
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+		SDL_RenderFillRects(renderer, m_textPixels.data(), (int)m_textPixels.size());
+
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+	}
+}
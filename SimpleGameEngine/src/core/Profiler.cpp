@@ -0,0 +1,163 @@
+#include "core/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sg
+{
+	std::atomic<bool> Profiler::enabled(false);
+
+	namespace
+	{
+		struct ProfileEvent
+		{
+			const char* name;
+			uint64_t start;
+			uint64_t end;
+		};
+
+		// Written by its thread only, read when exporting
+		struct ThreadBuffer
+		{
+			std::vector<ProfileEvent> events;
+			// Number of events written since the last clear, event n is at n % PROFILER_EVENTS_PER_THREAD
+			std::atomic<uint64_t> count{ 0 };
+			unsigned int id = 0;
+			std::string name;
+		};
+
+		// Buffers outlive their thread so scopes of finished threads can still be exported
+		std::mutex buffersMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		thread_local ThreadBuffer* threadBuffer = nullptr;
+
+		ThreadBuffer& getThreadBuffer()
+		{
+			if (threadBuffer == nullptr)
+			{
+				auto buffer = std::make_unique<ThreadBuffer>();
+
+				std::lock_guard<std::mutex> lock(buffersMutex);
+				buffer->id = (unsigned int)buffers.size() + 1;
+				buffer->name = "Thread " + std::to_string(buffer->id);
+				threadBuffer = buffer.get();
+				buffers.push_back(std::move(buffer));
+			}
+
+			return *threadBuffer;
+		}
+
+		void writeEscaped(std::ofstream& file, const std::string& text)
+		{
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\') file << '\\';
+				file << c;
+			}
+		}
+
+		// Trace timestamps are in microseconds
+		void writeMicroseconds(std::ofstream& file, uint64_t nanoseconds)
+		{
+			file << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+		}
+	}
+
+	uint64_t Profiler::now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Profiler::record(const char* name, uint64_t start, uint64_t end)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+
+		// Allocated by the first scope so naming threads that never record costs nothing
+		if (buffer.events.empty())
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffer.events.resize(PROFILER_EVENTS_PER_THREAD);
+		}
+
+		uint64_t index = buffer.count.load(std::memory_order_relaxed);
+		buffer.events[index % PROFILER_EVENTS_PER_THREAD] = { name, start, end };
+		buffer.count.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::setThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = getThreadBuffer();
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer.name = name;
+	}
+
+	void Profiler::clear()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (auto& buffer : buffers)
+		{
+			buffer->count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	bool Profiler::writeChromeTrace(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		// Timestamps start at the first recorded scope
+		uint64_t origin = UINT64_MAX;
+		for (const auto& buffer : buffers)
+		{
+			uint64_t count = buffer->count.load(std::memory_order_acquire);
+			uint64_t first = (count > PROFILER_EVENTS_PER_THREAD) ? count - PROFILER_EVENTS_PER_THREAD : 0;
+			for (uint64_t i = first; i < count; ++i)
+			{
+				origin = std::min(origin, buffer->events[i % PROFILER_EVENTS_PER_THREAD].start);
+			}
+		}
+		if (origin == UINT64_MAX) origin = 0;
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool firstEvent = true;
+		for (const auto& buffer : buffers)
+		{
+			file << ((firstEvent) ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+				<< ",\"args\":{\"name\":\"";
+			writeEscaped(file, buffer->name);
+			file << "\"}}";
+			firstEvent = false;
+
+			uint64_t count = buffer->count.load(std::memory_order_acquire);
+			uint64_t first = (count > PROFILER_EVENTS_PER_THREAD) ? count - PROFILER_EVENTS_PER_THREAD : 0;
+			for (uint64_t i = first; i < count; ++i)
+			{
+				const ProfileEvent& event = buffer->events[i % PROFILER_EVENTS_PER_THREAD];
+
+				// Complete events hold their duration, viewers rebuild nesting from times
+				file << ",\n{\"name\":\"";
+				writeEscaped(file, event.name);
+				file << "\",\"cat\":\"sge\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":";
+				writeMicroseconds(file, event.start - origin);
+				file << ",\"dur\":";
+				writeMicroseconds(file, event.end - event.start);
+				file << "}";
+			}
+		}
+		file << "\n]}\n";
+
+		return file.good();
+	}
+}
@@ -0,0 +1,649 @@
+#include "core/SoftwareRasterizer.h"
+#include "core/Window.h"
+#include "core/Cpu.h"
+#include "assistants/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SG_USE_SSE2
+#endif
+
+namespace sg
+{
+	bool SoftwareRasterizer::keepPixels = false;
+	std::unordered_map<SDL_Texture*, std::unique_ptr<SoftwareImage>> SoftwareRasterizer::images;
+
+	namespace
+	{
+		const Uint32 opaqueBlack = 0xFF000000;
+
+		void copyRow(Uint32* destination, const Uint32* source, int count)
+		{
+			std::memcpy(destination, source, count * sizeof(Uint32));
+		}
+
+#if defined(SG_USE_AVX2)
+		// Reverse the first pixels of a row 8 at a time, returns the number of pixels reversed
+		SG_TARGET_AVX2 int reverseRowAvx2(Uint32* destination, const Uint32* source, int count)
+		{
+			int i = 0;
+			const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i pixels = _mm256_loadu_si256((const __m256i*)(source + count - 8 - i));
+				_mm256_storeu_si256((__m256i*)(destination + i), _mm256_permutevar8x32_epi32(pixels, reverse));
+			}
+			return i;
+		}
+
+		// Blend the first pixels of a row 8 at a time, returns the number of pixels blended
+		SG_TARGET_AVX2 int blendRowAvx2(Uint32* destination, const Uint32* source, int count)
+		{
+			int i = 0;
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i full = _mm256_set1_epi16(255);
+			const __m256i half = _mm256_set1_epi16(128);
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i src = _mm256_loadu_si256((const __m256i*)(source + i));
+
+				// Skip fully transparent pixels, common around sprites
+				if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_srli_epi32(src, 24), zero)) == -1) continue;
+
+				__m256i dst = _mm256_loadu_si256((const __m256i*)(destination + i));
+				__m256i srcLow = _mm256_unpacklo_epi8(src, zero);
+				__m256i srcHigh = _mm256_unpackhi_epi8(src, zero);
+				__m256i dstLow = _mm256_unpacklo_epi8(dst, zero);
+				__m256i dstHigh = _mm256_unpackhi_epi8(dst, zero);
+
+				// Broadcast alpha to the four channels of each pixel
+				__m256i alphaLow = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcLow, 0xFF), 0xFF);
+				__m256i alphaHigh = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcHigh, 0xFF), 0xFF);
+
+				dstLow = _mm256_mullo_epi16(dstLow, _mm256_sub_epi16(full, alphaLow));
+				dstHigh = _mm256_mullo_epi16(dstHigh, _mm256_sub_epi16(full, alphaHigh));
+
+				// Exact division by 255: (x + 128 + ((x + 128) >> 8)) >> 8
+				dstLow = _mm256_add_epi16(dstLow, half);
+				dstHigh = _mm256_add_epi16(dstHigh, half);
+				dstLow = _mm256_srli_epi16(_mm256_add_epi16(dstLow, _mm256_srli_epi16(dstLow, 8)), 8);
+				dstHigh = _mm256_srli_epi16(_mm256_add_epi16(dstHigh, _mm256_srli_epi16(dstHigh, 8)), 8);
+
+				__m256i result = _mm256_adds_epu8(_mm256_packus_epi16(dstLow, dstHigh), src);
+				_mm256_storeu_si256((__m256i*)(destination + i), result);
+			}
+			return i;
+		}
+#endif
+
+		// destination[i] = source[count - 1 - i]
+		void reverseRow(Uint32* destination, const Uint32* source, int count)
+		{
+			int i = 0;
+#if defined(SG_USE_AVX2)
+			if (Cpu::hasAvx2())
+			{
+				i = reverseRowAvx2(destination, source, count);
+			}
+#endif
+#if defined(SG_USE_SSE2)
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i pixels = _mm_loadu_si128((const __m128i*)(source + count - 4 - i));
+				_mm_storeu_si128((__m128i*)(destination + i), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				destination[i] = source[count - 1 - i];
+			}
+		}
+
+		// Premultiplied "over": destination = source + destination * (255 - source alpha) / 255
+		void blendRow(Uint32* destination, const Uint32* source, int count)
+		{
+			int i = 0;
+#if defined(SG_USE_AVX2)
+			if (Cpu::hasAvx2())
+			{
+				i = blendRowAvx2(destination, source, count);
+			}
+#endif
+#if defined(SG_USE_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i full = _mm_set1_epi16(255);
+			const __m128i half = _mm_set1_epi16(128);
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i src = _mm_loadu_si128((const __m128i*)(source + i));
+
+				// Skip fully transparent pixels, common around sprites
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(src, 24), zero)) == 0xFFFF) continue;
+
+				__m128i dst = _mm_loadu_si128((const __m128i*)(destination + i));
+				__m128i srcLow = _mm_unpacklo_epi8(src, zero);
+				__m128i srcHigh = _mm_unpackhi_epi8(src, zero);
+				__m128i dstLow = _mm_unpacklo_epi8(dst, zero);
+				__m128i dstHigh = _mm_unpackhi_epi8(dst, zero);
+
+				// Broadcast alpha to the four channels of each pixel
+				__m128i alphaLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLow, 0xFF), 0xFF);
+				__m128i alphaHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHigh, 0xFF), 0xFF);
+
+				dstLow = _mm_mullo_epi16(dstLow, _mm_sub_epi16(full, alphaLow));
+				dstHigh = _mm_mullo_epi16(dstHigh, _mm_sub_epi16(full, alphaHigh));
+
+				// Exact division by 255: (x + 128 + ((x + 128) >> 8)) >> 8
+				dstLow = _mm_add_epi16(dstLow, half);
+				dstHigh = _mm_add_epi16(dstHigh, half);
+				dstLow = _mm_srli_epi16(_mm_add_epi16(dstLow, _mm_srli_epi16(dstLow, 8)), 8);
+				dstHigh = _mm_srli_epi16(_mm_add_epi16(dstHigh, _mm_srli_epi16(dstHigh, 8)), 8);
+
+				__m128i result = _mm_adds_epu8(_mm_packus_epi16(dstLow, dstHigh), src);
+				_mm_storeu_si128((__m128i*)(destination + i), result);
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				Uint32 src = source[i];
+				Uint32 inverseAlpha = 255 - (src >> 24);
+				if (inverseAlpha == 255) continue;
+
+				Uint32 dst = destination[i];
+				Uint32 result = 0;
+				for (int shift = 0; shift < 32; shift += 8)
+				{
+					Uint32 channel = ((dst >> shift) & 0xFF) * inverseAlpha + 128;
+					channel = (channel + (channel >> 8)) >> 8;
+					channel = std::min<Uint32>(channel + ((src >> shift) & 0xFF), 255);
+					result |= channel << shift;
+				}
+				destination[i] = result;
+			}
+		}
+
+		// SDL blends layers with straight alpha
+		void unpremultiplyRow(Uint32* pixels, int count)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				Uint32 alpha = pixels[i] >> 24;
+				if (alpha == 0 || alpha == 255) continue;
+
+				Uint32 pixel = pixels[i];
+				Uint32 red = std::min<Uint32>(((pixel >> 16) & 0xFF) * 255 / alpha, 255);
+				Uint32 green = std::min<Uint32>(((pixel >> 8) & 0xFF) * 255 / alpha, 255);
+				Uint32 blue = std::min<Uint32>((pixel & 0xFF) * 255 / alpha, 255);
+				pixels[i] = (alpha << 24) | (red << 16) | (green << 8) | blue;
+			}
+		}
+
+		bool isOpaque(const std::vector<Uint32>& pixels)
+		{
+			for (Uint32 pixel : pixels)
+			{
+				if ((pixel >> 24) != 255) return false;
+			}
+			return true;
+		}
+	}
+
+	void SoftwareRasterizer::setKeepingPixels(bool keep)
+	{
+		keepPixels = keep;
+		if (!keep)
+		{
+			images.clear();
+		}
+	}
+
+	void SoftwareRasterizer::registerTexture(SDL_Texture* texture, SDL_Surface* surface)
+	{
+		if (!keepPixels || texture == nullptr || surface == nullptr) return;
+
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (converted == nullptr) return;
+
+		auto image = std::make_unique<SoftwareImage>();
+		image->width = converted->w;
+		image->height = converted->h;
+		image->pixels.resize((size_t)converted->w * converted->h);
+
+		// Surfaces without alpha are drawn opaque by SDL whatever their alpha bytes are
+		SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+		SDL_GetTextureBlendMode(texture, &blendMode);
+		bool ignoreAlpha = blendMode == SDL_BLENDMODE_NONE;
+
+		SDL_LockSurface(converted);
+		for (int y = 0; y < converted->h; ++y)
+		{
+			const Uint32* row = (const Uint32*)((const Uint8*)converted->pixels + (size_t)y * converted->pitch);
+			Uint32* pixels = &image->pixels[(size_t)y * converted->w];
+
+			for (int x = 0; x < converted->w; ++x)
+			{
+				Uint32 pixel = row[x];
+				Uint32 alpha = (ignoreAlpha) ? 255 : pixel >> 24;
+
+				Uint32 red = (((pixel >> 16) & 0xFF) * alpha + 127) / 255;
+				Uint32 green = (((pixel >> 8) & 0xFF) * alpha + 127) / 255;
+				Uint32 blue = ((pixel & 0xFF) * alpha + 127) / 255;
+				pixels[x] = (alpha << 24) | (red << 16) | (green << 8) | blue;
+			}
+		}
+		SDL_UnlockSurface(converted);
+		SDL_FreeSurface(converted);
+
+		image->opaque = isOpaque(image->pixels);
+		image->blendMode = (ignoreAlpha) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND;
+		images[texture] = std::move(image);
+	}
+
+	void SoftwareRasterizer::registerTargetTexture(SDL_Texture* texture)
+	{
+		if (!keepPixels || texture == nullptr) return;
+
+		auto image = std::make_unique<SoftwareImage>();
+		SDL_QueryTexture(texture, nullptr, nullptr, &image->width, &image->height);
+		image->pixels.resize((size_t)image->width * image->height);
+
+		// Content drawn with alpha blending on a transparent target is already premultiplied
+		SDL_Renderer* renderer = Window::getRenderer();
+		SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+		SDL_SetRenderTarget(renderer, texture);
+		int result = SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, image->pixels.data(),
+			image->width * (int)sizeof(Uint32));
+		SDL_SetRenderTarget(renderer, previousTarget);
+
+		if (result != 0)
+		{
+			images.erase(texture);
+			return;
+		}
+
+		image->opaque = isOpaque(image->pixels);
+		images[texture] = std::move(image);
+	}
+
+	void SoftwareRasterizer::updateTexture(SDL_Texture* texture, const SDL_Rect& region, const Uint32* pixels, int pitch)
+	{
+		auto found = images.find(texture);
+		if (found == images.end()) return;
+
+		SoftwareImage& image = *(found->second);
+		bool regionOpaque = true;
+		for (int y = 0; y < region.h; ++y)
+		{
+			const Uint32* row = (const Uint32*)((const Uint8*)pixels + (size_t)y * pitch);
+			Uint32* destination = &image.pixels[(size_t)(region.y + y) * image.width + region.x];
+
+			for (int x = 0; x < region.w; ++x)
+			{
+				Uint32 pixel = row[x];
+				Uint32 alpha = (image.blendMode == SDL_BLENDMODE_NONE) ? 255 : pixel >> 24;
+				regionOpaque = regionOpaque && alpha == 255;
+
+				Uint32 red = (((pixel >> 16) & 0xFF) * alpha + 127) / 255;
+				Uint32 green = (((pixel >> 8) & 0xFF) * alpha + 127) / 255;
+				Uint32 blue = ((pixel & 0xFF) * alpha + 127) / 255;
+				destination[x] = (alpha << 24) | (red << 16) | (green << 8) | blue;
+			}
+		}
+
+		// Pixels outside of the region only need to be checked when the image may have become opaque
+		image.opaque = regionOpaque && (image.opaque || isOpaque(image.pixels));
+	}
+
+	void SoftwareRasterizer::unregisterTexture(SDL_Texture* texture)
+	{
+		images.erase(texture);
+	}
+
+	const SoftwareImage* SoftwareRasterizer::findImage(SDL_Texture* texture)
+	{
+		auto found = images.find(texture);
+		return (found != images.end()) ? found->second.get() : nullptr;
+	}
+
+	void SoftwareRasterizer::release()
+	{
+		if (m_target)
+		{
+			SDL_DestroyTexture(m_target);
+			m_target = nullptr;
+		}
+		m_width = m_height = 0;
+	}
+
+	void SoftwareRasterizer::begin(SDL_Renderer* renderer, int width, int height, float scale)
+	{
+		m_renderer = renderer;
+		m_screenWidth = width;
+		m_screenHeight = height;
+		m_scale = std::clamp(scale, 0.01f, 1.f);
+		m_opaqueLayer = true;
+
+		int scaledWidth = std::max((int)std::ceil(width * m_scale), 1);
+		int scaledHeight = std::max((int)std::ceil(height * m_scale), 1);
+
+		if (m_target == nullptr || scaledWidth != m_width || scaledHeight != m_height)
+		{
+			release();
+			m_target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+				scaledWidth, scaledHeight);
+			m_width = scaledWidth;
+			m_height = scaledHeight;
+
+			m_tilesX = (m_width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+			m_tilesY = (m_height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+			m_tileBlits.resize((size_t)m_tilesX * m_tilesY);
+		}
+
+		m_blits.clear();
+		for (std::vector<unsigned int>& tile : m_tileBlits)
+		{
+			tile.clear();
+		}
+		m_dirtyTiles = { 0, 0, 0, 0 };
+	}
+
+	SoftwareImage& SoftwareRasterizer::beginImage(SDL_Texture* texture, int width, int height)
+	{
+		std::unique_ptr<SoftwareImage>& image = images[texture];
+		if (image == nullptr)
+		{
+			image = std::make_unique<SoftwareImage>();
+		}
+
+		// Pixels keep their capacity when an image is composed again
+		image->width = width;
+		image->height = height;
+		image->pixels.assign((size_t)width * height, 0);
+		image->opaque = false;
+		image->blendMode = SDL_BLENDMODE_BLEND;
+		return *image;
+	}
+
+	bool SoftwareRasterizer::drawOnImage(SoftwareImage& image, SDL_Texture* texture, const SDL_Rect* source,
+		const SDL_Rect& destination, SDL_RendererFlip flip)
+	{
+		Blit blit;
+		if (!prepareBlit(texture, source, flip, blit)) return false;
+		blit.destination = destination;
+
+		SDL_Rect bounds{ 0, 0, image.width, image.height };
+		SDL_Rect visible;
+		if (!SDL_IntersectRect(&destination, &bounds, &visible)) return true;
+
+		// Rows are blitted in spans no wider than a tile
+		Target target{ image.pixels.data(), image.width * (int)sizeof(Uint32), 0, 0 };
+		for (int x = visible.x; x < visible.x + visible.w; x += RASTER_TILE_SIZE)
+		{
+			SDL_Rect span{ x, visible.y, std::min(RASTER_TILE_SIZE, visible.x + visible.w - x), visible.h };
+			blitRows(blit, span, target);
+		}
+		return true;
+	}
+
+	void SoftwareRasterizer::endImage(SDL_Texture* texture, SoftwareImage& image)
+	{
+		image.opaque = isOpaque(image.pixels);
+
+		// SDL draws the texture from the same premultiplied pixels an SDL render target would hold
+		Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+		SDL_QueryTexture(texture, &format, nullptr, nullptr, nullptr);
+		int pitch = image.width * (int)sizeof(Uint32);
+		if (format == SDL_PIXELFORMAT_ARGB8888)
+		{
+			SDL_UpdateTexture(texture, nullptr, image.pixels.data(), pitch);
+			return;
+		}
+
+		static std::vector<Uint32> converted;
+		converted.resize(image.pixels.size());
+		if (SDL_ConvertPixels(image.width, image.height, SDL_PIXELFORMAT_ARGB8888, image.pixels.data(), pitch,
+			format, converted.data(), pitch) == 0)
+		{
+			SDL_UpdateTexture(texture, nullptr, converted.data(), pitch);
+		}
+	}
+
+	bool SoftwareRasterizer::prepareBlit(SDL_Texture* texture, const SDL_Rect* source, SDL_RendererFlip flip, Blit& blit)
+	{
+		const SoftwareImage* image = findImage(texture);
+		if (image == nullptr) return false;
+
+		// Blend mode and modulation can change at any time, copies that don't draw the image as converted
+		// are left to SDL
+		SDL_BlendMode blendMode = SDL_BLENDMODE_INVALID;
+		Uint8 alpha = 0, red = 0, green = 0, blue = 0;
+		if (SDL_GetTextureBlendMode(texture, &blendMode) != 0 || blendMode != image->blendMode ||
+			SDL_GetTextureAlphaMod(texture, &alpha) != 0 || alpha != 255 ||
+			SDL_GetTextureColorMod(texture, &red, &green, &blue) != 0 || red != 255 || green != 255 || blue != 255)
+		{
+			return false;
+		}
+
+		SDL_Rect imageRect{ 0, 0, image->width, image->height };
+		SDL_Rect sourceRect = (source) ? *source : imageRect;
+
+		// Let SDL handle source rectangles that need clipping
+		SDL_Rect clippedSource;
+		if (!SDL_IntersectRect(&sourceRect, &imageRect, &clippedSource) ||
+			clippedSource.w != sourceRect.w || clippedSource.h != sourceRect.h)
+		{
+			return false;
+		}
+
+		blit.image = image;
+		blit.source = sourceRect;
+		blit.flip = flip;
+		return true;
+	}
+
+	bool SoftwareRasterizer::draw(SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect& destination, SDL_RendererFlip flip)
+	{
+		Blit blit;
+		if (m_target == nullptr || !prepareBlit(texture, source, flip, blit)) return false;
+
+		// Edges are scaled separately so adjacent tiles stay adjacent
+		int left = (int)std::floor(destination.x * m_scale);
+		int top = (int)std::floor(destination.y * m_scale);
+		int right = (int)std::floor((destination.x + destination.w) * m_scale);
+		int bottom = (int)std::floor((destination.y + destination.h) * m_scale);
+		blit.destination = { left, top, right - left, bottom - top };
+
+		SDL_Rect screen{ 0, 0, m_width, m_height };
+		SDL_Rect visible;
+		if (!SDL_IntersectRect(&blit.destination, &screen, &visible))
+		{
+			// Nothing to draw, but the copy was handled
+			return true;
+		}
+
+		unsigned int index = (unsigned int)m_blits.size();
+		m_blits.push_back(blit);
+
+		int firstTileX = visible.x / RASTER_TILE_SIZE, lastTileX = (visible.x + visible.w - 1) / RASTER_TILE_SIZE;
+		int firstTileY = visible.y / RASTER_TILE_SIZE, lastTileY = (visible.y + visible.h - 1) / RASTER_TILE_SIZE;
+		for (int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+		{
+			for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+			{
+				m_tileBlits[(size_t)tileY * m_tilesX + tileX].push_back(index);
+			}
+		}
+
+		if (m_dirtyTiles.w == 0)
+		{
+			m_dirtyTiles = { firstTileX, firstTileY, lastTileX - firstTileX + 1, lastTileY - firstTileY + 1 };
+		}
+		else
+		{
+			int right = std::max(m_dirtyTiles.x + m_dirtyTiles.w, lastTileX + 1);
+			int bottom = std::max(m_dirtyTiles.y + m_dirtyTiles.h, lastTileY + 1);
+			m_dirtyTiles.x = std::min(m_dirtyTiles.x, firstTileX);
+			m_dirtyTiles.y = std::min(m_dirtyTiles.y, firstTileY);
+			m_dirtyTiles.w = right - m_dirtyTiles.x;
+			m_dirtyTiles.h = bottom - m_dirtyTiles.y;
+		}
+
+		return true;
+	}
+
+	void SoftwareRasterizer::blitRows(const Blit& blit, const SDL_Rect& clip, const Target& output)
+	{
+		const SoftwareImage& image = *blit.image;
+		const SDL_Rect& source = blit.source;
+		const SDL_Rect& destination = blit.destination;
+		bool flipHorizontal = (blit.flip & SDL_FLIP_HORIZONTAL) != 0;
+		bool flipVertical = (blit.flip & SDL_FLIP_VERTICAL) != 0;
+		bool sameWidth = destination.w == source.w;
+
+		int firstColumn = clip.x - destination.x;
+		Uint32 scratch[RASTER_TILE_SIZE];
+
+		for (int y = clip.y; y < clip.y + clip.h; ++y)
+		{
+			// Nearest source row, sampled at the center of the destination pixel
+			int v = y - destination.y;
+			int sourceRow = (destination.h == source.h) ? v : (int)(((long long)v * 2 + 1) * source.h / (destination.h * 2));
+			if (flipVertical) sourceRow = source.h - 1 - sourceRow;
+
+			const Uint32* row = &image.pixels[(size_t)(source.y + sourceRow) * image.width + source.x];
+			Uint32* target = output.row(clip.x, y);
+			const Uint32* pixels;
+
+			if (sameWidth && !flipHorizontal)
+			{
+				pixels = row + firstColumn;
+			}
+			else if (sameWidth)
+			{
+				// Mirrored span of the source row
+				const Uint32* span = row + (source.w - firstColumn - clip.w);
+				if (image.opaque)
+				{
+					reverseRow(target, span, clip.w);
+					continue;
+				}
+				reverseRow(scratch, span, clip.w);
+				pixels = scratch;
+			}
+			else
+			{
+				for (int i = 0; i < clip.w; ++i)
+				{
+					int u = firstColumn + i;
+					int sourceColumn = (int)(((long long)u * 2 + 1) * source.w / (destination.w * 2));
+					if (flipHorizontal) sourceColumn = source.w - 1 - sourceColumn;
+					scratch[i] = row[sourceColumn];
+				}
+				pixels = scratch;
+			}
+
+			if (image.opaque)
+			{
+				copyRow(target, pixels, clip.w);
+			}
+			else
+			{
+				blendRow(target, pixels, clip.w);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::rasterizeTile(size_t tile)
+	{
+		int tileX = (int)(tile % m_tilesX) * RASTER_TILE_SIZE;
+		int tileY = (int)(tile / m_tilesX) * RASTER_TILE_SIZE;
+		SDL_Rect tileRect{ tileX, tileY, std::min(RASTER_TILE_SIZE, m_width - tileX), std::min(RASTER_TILE_SIZE, m_height - tileY) };
+
+		Uint32 clearColor = (m_opaqueLayer) ? opaqueBlack : 0;
+		for (int y = tileRect.y; y < tileRect.y + tileRect.h; ++y)
+		{
+			Uint32* row = m_locked.row(tileRect.x, y);
+			std::fill(row, row + tileRect.w, clearColor);
+		}
+
+		// Blits are in drawing order, a tile is only touched by its own thread
+		for (unsigned int index : m_tileBlits[tile])
+		{
+			const Blit& blit = m_blits[index];
+			SDL_Rect clip;
+			if (SDL_IntersectRect(&blit.destination, &tileRect, &clip))
+			{
+				blitRows(blit, clip, m_locked);
+			}
+		}
+
+		if (!m_opaqueLayer)
+		{
+			for (int y = tileRect.y; y < tileRect.y + tileRect.h; ++y)
+			{
+				unpremultiplyRow(m_locked.row(tileRect.x, y), tileRect.w);
+			}
+		}
+	}
+
+	void SoftwareRasterizer::flush()
+	{
+		if (m_blits.empty() || m_target == nullptr)
+		{
+			// SDL draws on screen next, later layers must keep them visible
+			m_opaqueLayer = false;
+			return;
+		}
+
+		// The screen was cleared before the first layer, only tiles holding copies need to be drawn. Scaled frames
+		// are filtered when presented and draw every tile so edges don't sample pixels left from other layers
+		SDL_Rect tiles = (m_scale < 1.f) ? SDL_Rect{ 0, 0, m_tilesX, m_tilesY } : m_dirtyTiles;
+		SDL_Rect region{ tiles.x * RASTER_TILE_SIZE, tiles.y * RASTER_TILE_SIZE, 0, 0 };
+		region.w = std::min((tiles.x + tiles.w) * RASTER_TILE_SIZE, m_width) - region.x;
+		region.h = std::min((tiles.y + tiles.h) * RASTER_TILE_SIZE, m_height) - region.y;
+
+		void* pixels = nullptr;
+		int pitch = 0;
+		if (SDL_LockTexture(m_target, &region, &pixels, &pitch) == 0)
+		{
+			m_locked = { (Uint32*)pixels, pitch, region.x, region.y };
+			Parallel::forRange((size_t)tiles.w * tiles.h, 1, [this, &tiles](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						rasterizeTile((size_t)(tiles.y + (int)i / tiles.w) * m_tilesX + tiles.x + (int)i % tiles.w);
+					}
+				});
+			m_locked = { nullptr, 0, 0, 0 };
+			SDL_UnlockTexture(m_target);
+
+			SDL_SetTextureBlendMode(m_target, (m_opaqueLayer) ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+			SDL_SetTextureScaleMode(m_target, (m_scale < 1.f) ? SDL_ScaleModeLinear : SDL_ScaleModeNearest);
+
+			if (m_scale < 1.f)
+			{
+				SDL_Rect screen{ 0, 0, m_screenWidth, m_screenHeight };
+				SDL_RenderCopy(m_renderer, m_target, nullptr, &screen);
+			}
+			else
+			{
+				SDL_RenderCopy(m_renderer, m_target, &region, &region);
+			}
+		}
+
+		m_blits.clear();
+		for (int tileY = tiles.y; tileY < tiles.y + tiles.h; ++tileY)
+		{
+			for (int tileX = tiles.x; tileX < tiles.x + tiles.w; ++tileX)
+			{
+				m_tileBlits[(size_t)tileY * m_tilesX + tileX].clear();
+			}
+		}
+		m_dirtyTiles = { 0, 0, 0, 0 };
+		m_opaqueLayer = false;
+	}
+}
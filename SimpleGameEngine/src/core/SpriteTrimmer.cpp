@@ -0,0 +1,165 @@
+#include "core/SpriteTrimmer.h"
+#include "core/Profiler.h"
+#include "core/Stats.h"
+#include "core/Tracepoints.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace sg
+{
+	namespace
+	{
+		// Bounding box of the pixels with a non-zero alpha inside the rectangle, empty if there are none
+		SDL_Rect findVisibleBounds(const SDL_Surface* image, const SDL_Rect& rect)
+		{
+			int left = rect.x + rect.w, right = rect.x - 1;
+			int top = rect.y + rect.h, bottom = rect.y - 1;
+
+			for (int y = rect.y; y < rect.y + rect.h; ++y)
+			{
+				const Uint32* row = (const Uint32*)((const Uint8*)image->pixels + (size_t)y * image->pitch);
+				for (int x = rect.x; x < rect.x + rect.w; ++x)
+				{
+					if (row[x] & 0xFF000000)
+					{
+						left = std::min(left, x);
+						right = std::max(right, x);
+						top = std::min(top, y);
+						bottom = std::max(bottom, y);
+					}
+				}
+			}
+
+			if (right < left) return { 0, 0, 0, 0 };
+			return { left, top, right - left + 1, bottom - top + 1 };
+		}
+	}
+
+	std::unique_ptr<Texture> SpriteTrimmer::cook(const std::string& imagePath, const std::string& cacheKey,
+		const std::vector<SDL_Rect>& frames, std::vector<TrimmedFrame>& trimmedFrames)
+	{
+		SG_PROFILE_SCOPE("SpriteTrimmer::cook");
+		uint64_t loadStart = SG_TRACE_NOW();
+		SDL_Surface* loaded = IMG_Load(imagePath.c_str());
+		if (loaded == nullptr)
+		{
+			throw TextureException("Failed to load image");
+		}
+		uint64_t bytes = (uint64_t)loaded->pitch * loaded->h;
+		Stats::addBytesLoaded(bytes);
+
+		// Alpha is read from and pixels are copied in a single known format
+		SDL_Surface* image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(loaded);
+		if (image == nullptr)
+		{
+			throw TextureException("Failed to convert image");
+		}
+		SDL_LockSurface(image);
+
+		// Trimmed area of each frame in the image. Identical areas are packed once
+		SDL_Rect imageRect{ 0, 0, image->w, image->h };
+		std::vector<SDL_Rect> visible(frames.size());
+		std::map<std::tuple<int, int, int, int>, SDL_Rect> packed;
+		trimmedFrames.assign(frames.size(), TrimmedFrame{ { 0, 0, 0, 0 }, { 0, 0, 0, 0 } });
+
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			const SDL_Rect& frame = frames[i];
+			SDL_Rect clipped;
+			visible[i] = (SDL_IntersectRect(&frame, &imageRect, &clipped)) ? findVisibleBounds(image, clipped) : SDL_Rect{ 0, 0, 0, 0 };
+
+			trimmedFrames[i].trim = { 0, 0, frame.w, frame.h };
+			if (visible[i].w > 0)
+			{
+				trimmedFrames[i].trim.x = visible[i].x - frame.x;
+				trimmedFrames[i].trim.y = visible[i].y - frame.y;
+				packed[std::make_tuple(visible[i].x, visible[i].y, visible[i].w, visible[i].h)] = visible[i];
+			}
+		}
+
+		// Shelf packing, tallest areas first
+		std::vector<SDL_Rect*> areas;
+		int totalArea = 0, widest = 0;
+		for (auto& kvp : packed)
+		{
+			areas.push_back(&kvp.second);
+			totalArea += (kvp.second.w + 2 * TRIMMED_FRAME_PADDING) * (kvp.second.h + 2 * TRIMMED_FRAME_PADDING);
+			widest = std::max(widest, kvp.second.w + 2 * TRIMMED_FRAME_PADDING);
+		}
+		std::stable_sort(areas.begin(), areas.end(), [](const SDL_Rect* a, const SDL_Rect* b) { return a->h > b->h; });
+
+		int atlasWidth = std::max(widest, (int)std::ceil(std::sqrt((double)totalArea)));
+		int x = 0, y = 0, shelfHeight = 0;
+		std::vector<SDL_Rect> destinations(areas.size());
+		for (size_t i = 0; i < areas.size(); ++i)
+		{
+			int width = areas[i]->w + 2 * TRIMMED_FRAME_PADDING;
+			int height = areas[i]->h + 2 * TRIMMED_FRAME_PADDING;
+			if (x + width > atlasWidth)
+			{
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+
+			destinations[i] = { x + TRIMMED_FRAME_PADDING, y + TRIMMED_FRAME_PADDING, areas[i]->w, areas[i]->h };
+			x += width;
+			shelfHeight = std::max(shelfHeight, height);
+		}
+		int atlasHeight = std::max(y + shelfHeight, 1);
+		atlasWidth = std::max(atlasWidth, 1);
+
+		SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (atlas == nullptr)
+		{
+			SDL_UnlockSurface(image);
+			SDL_FreeSurface(image);
+			throw TextureException("Failed to create trimmed sprite sheet");
+		}
+
+		// Pixels are copied as is, blitting would blend them with the transparent atlas
+		SDL_LockSurface(atlas);
+		for (int row = 0; row < atlasHeight; ++row)
+		{
+			std::memset((Uint8*)atlas->pixels + (size_t)row * atlas->pitch, 0, (size_t)atlasWidth * 4);
+		}
+		for (size_t i = 0; i < areas.size(); ++i)
+		{
+			const SDL_Rect& source = *areas[i];
+			const SDL_Rect& destination = destinations[i];
+			for (int row = 0; row < source.h; ++row)
+			{
+				std::memcpy((Uint8*)atlas->pixels + (size_t)(destination.y + row) * atlas->pitch + (size_t)destination.x * 4,
+					(const Uint8*)image->pixels + (size_t)(source.y + row) * image->pitch + (size_t)source.x * 4,
+					(size_t)source.w * 4);
+			}
+
+			// Frames now point to their area in the atlas
+			*areas[i] = destination;
+		}
+		SDL_UnlockSurface(atlas);
+		SDL_UnlockSurface(image);
+		SDL_FreeSurface(image);
+
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			if (visible[i].w > 0)
+			{
+				trimmedFrames[i].source = packed[std::make_tuple(visible[i].x, visible[i].y, visible[i].w, visible[i].h)];
+			}
+		}
+
+		// The texture takes ownership of the atlas surface
+		std::unique_ptr<Texture> texture = std::make_unique<Texture>(atlas, cacheKey);
+		SG_TRACE3(texture_load, imagePath.c_str(), SG_TRACE_NOW() - loadStart, bytes);
+		return texture;
+	}
+}
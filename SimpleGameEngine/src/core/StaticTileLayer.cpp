@@ -0,0 +1,432 @@
+#include "core/StaticTileLayer.h"
+#include "core/Window.h"
+#include "core/Profiler.h"
+#include "core/Object/Object.h"
+
+#include "components/TilesetComponent.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sg
+{
+	std::map<int, StaticTileLayer::Layer> StaticTileLayer::layers;
+	std::unordered_map<const TilesetComponent*, StaticTileLayer::Placement> StaticTileLayer::placements;
+	std::vector<TilesetComponent*> StaticTileLayer::pendingTiles;
+	std::map<int, StaticTileLayer::Layer>::iterator StaticTileLayer::nextLayer = StaticTileLayer::layers.end();
+	std::map<int, StaticTileLayer::Layer>::reverse_iterator StaticTileLayer::nextCulledLayer = StaticTileLayer::layers.rend();
+	unsigned int StaticTileLayer::numDrawCalls = 0;
+	unsigned int StaticTileLayer::numCulled = 0;
+
+	uint64_t StaticTileLayer::makeKey(int chunkX, int chunkY)
+	{
+		// Chunks left of or above the origin have negative coordinates, shifting them is undefined
+		return ((uint64_t)(uint32_t)chunkX << 32) | (uint32_t)chunkY;
+	}
+
+	void StaticTileLayer::add(TilesetComponent* tile)
+	{
+		pendingTiles.push_back(tile);
+	}
+
+	void StaticTileLayer::remove(TilesetComponent* tile)
+	{
+		// The tile might not have been placed yet
+		auto pending = std::find(pendingTiles.begin(), pendingTiles.end(), tile);
+		if (pending != pendingTiles.end())
+		{
+			pendingTiles.erase(pending);
+			return;
+		}
+
+		auto placement = placements.find(tile);
+		if (placement == placements.end())
+		{
+			return;
+		}
+
+		Layer& layer = layers[placement->second.zIndex];
+		for (uint64_t key : placement->second.chunkKeys)
+		{
+			auto chunk = layer.chunks.find(key);
+			if (chunk == layer.chunks.end()) continue;
+
+			std::vector<TilesetComponent*>& tiles = chunk->second.tiles;
+			tiles.erase(std::remove(tiles.begin(), tiles.end(), tile), tiles.end());
+
+			// Release chunks that don't hold any tile anymore
+			if (tiles.empty())
+			{
+				layer.chunks.erase(chunk);
+			}
+			else
+			{
+				chunk->second.dirty = true;
+			}
+		}
+
+		placements.erase(placement);
+	}
+
+	void StaticTileLayer::markDirty(const TilesetComponent* tile)
+	{
+		auto placement = placements.find(tile);
+		if (placement == placements.end())
+		{
+			return;
+		}
+
+		Layer& layer = layers[placement->second.zIndex];
+		for (uint64_t key : placement->second.chunkKeys)
+		{
+			auto chunk = layer.chunks.find(key);
+			if (chunk != layer.chunks.end())
+			{
+				chunk->second.dirty = true;
+			}
+		}
+	}
+
+	void StaticTileLayer::markAllDirty()
+	{
+		for (auto& layer : layers)
+		{
+			for (auto& chunk : layer.second.chunks)
+			{
+				chunk.second.dirty = true;
+			}
+		}
+	}
+
+	void StaticTileLayer::place(TilesetComponent* tile)
+	{
+		// Tiles on screen-position objects don't follow the camera, draw them like any other component
+		if (tile->getObject().isScreenPosition())
+		{
+			tile->m_static = false;
+			return;
+		}
+
+		SDL_Rect rect = tile->getDrawRect();
+		if (rect.w <= 0 || rect.h <= 0)
+		{
+			return;
+		}
+
+		// Find every chunk the tile overlaps
+		int firstX = (int)std::floor(rect.x / (float)STATIC_CHUNK_SIZE);
+		int firstY = (int)std::floor(rect.y / (float)STATIC_CHUNK_SIZE);
+		int lastX = (int)std::floor((rect.x + rect.w - 1) / (float)STATIC_CHUNK_SIZE);
+		int lastY = (int)std::floor((rect.y + rect.h - 1) / (float)STATIC_CHUNK_SIZE);
+
+		Placement& placement = placements[tile];
+		placement.zIndex = tile->zIndex;
+		Layer& layer = layers[tile->zIndex];
+
+		for (int chunkY = firstY; chunkY <= lastY; ++chunkY)
+		{
+			for (int chunkX = firstX; chunkX <= lastX; ++chunkX)
+			{
+				uint64_t key = makeKey(chunkX, chunkY);
+				Chunk& chunk = layer.chunks[key];
+				chunk.tiles.push_back(tile);
+				chunk.dirty = true;
+				placement.chunkKeys.push_back(key);
+			}
+		}
+	}
+
+	SDL_Rect StaticTileLayer::getChunkDestination(const TilesetComponent* tile, int chunkX, int chunkY)
+	{
+		// Tiles are drawn relative to the chunk's upper left corner
+		SDL_Rect destination = tile->getDrawRect();
+		destination.x -= chunkX * STATIC_CHUNK_SIZE;
+		destination.y -= chunkY * STATIC_CHUNK_SIZE;
+		return destination;
+	}
+
+	bool StaticTileLayer::bakeOnCpu(Chunk& chunk, int chunkX, int chunkY)
+	{
+		SDL_Texture* texture = chunk.texture->get();
+		SoftwareImage& image = SoftwareRasterizer::beginImage(texture, STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE);
+
+		for (const TilesetComponent* tile : chunk.tiles)
+		{
+			if (!tile->getObject().isVisible()) continue;
+
+			SDL_Rect source = tile->getSourceRect();
+			if (!SoftwareRasterizer::drawOnImage(image, tile->getTexture()->get(), &source,
+				getChunkDestination(tile, chunkX, chunkY), tile->getFlipValue()))
+			{
+				return false;
+			}
+		}
+
+		SoftwareRasterizer::endImage(texture, image);
+		return true;
+	}
+
+	void StaticTileLayer::bake(Chunk& chunk, int chunkX, int chunkY)
+	{
+		if (chunk.texture == nullptr)
+		{
+			chunk.texture = std::make_unique<Texture>(STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE);
+		}
+
+		// With the software rasterizer, tiles are copied on the CPU and the chunk is uploaded once instead of
+		// drawn by SDL then read back. Tiles the rasterizer can't copy, e.g. tinted ones, are left to SDL
+		if (!SoftwareRasterizer::isKeepingPixels() || !bakeOnCpu(chunk, chunkX, chunkY))
+		{
+			chunk.texture->startDrawingOnTexture();
+			chunk.texture->clear();
+			for (const TilesetComponent* tile : chunk.tiles)
+			{
+				if (!tile->getObject().isVisible()) continue;
+
+				chunk.texture->renderOnTexture(*tile->getTexture(), tile->getSourceRect(),
+					getChunkDestination(tile, chunkX, chunkY), tile->getFlipValue());
+			}
+			chunk.texture->stopDrawingOnTexture();
+
+			// Keep a CPU copy for the software rasterizer
+			SoftwareRasterizer::registerTargetTexture(chunk.texture->get());
+		}
+
+		chunk.opaqueRects.clear();
+		SDL_Rect bounds{ 0, 0, STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE };
+		for (const TilesetComponent* tile : chunk.tiles)
+		{
+			if (!tile->getObject().isVisible()) continue;
+
+			SDL_Rect destination = getChunkDestination(tile, chunkX, chunkY);
+			SDL_Rect source = tile->getSourceRect();
+			SDL_Rect opaque;
+			if (tile->getTexture()->isOpaque(&source) && SDL_IntersectRect(&destination, &bounds, &opaque))
+			{
+				chunk.opaqueRects.push_back(opaque);
+			}
+		}
+		chunk.dirty = false;
+
+		// Tiles are mostly laid out on a grid, a few rectangles are enough to describe a chunk
+		mergeRects(chunk.opaqueRects);
+	}
+
+	bool StaticTileLayer::beginFrame()
+	{
+		SG_PROFILE_SCOPE("Static tiles");
+
+		bool baked = false;
+		numDrawCalls = 0;
+		numCulled = 0;
+
+		for (TilesetComponent* tile : pendingTiles)
+		{
+			place(tile);
+		}
+		pendingTiles.clear();
+
+		// Camera view in world coordinates
+		const vec2& topLeft = Window::getCameraTopLeft();
+		float zoom = Window::getCameraZoom();
+		vec2 viewSize = Window::getWindowSize() * (1.f / zoom);
+		int firstX = (int)std::floor(topLeft.x / STATIC_CHUNK_SIZE);
+		int firstY = (int)std::floor(topLeft.y / STATIC_CHUNK_SIZE);
+		int lastX = (int)std::floor((topLeft.x + viewSize.x - 1.f / zoom) / STATIC_CHUNK_SIZE);
+		int lastY = (int)std::floor((topLeft.y + viewSize.y - 1.f / zoom) / STATIC_CHUNK_SIZE);
+
+		for (auto& kvp : layers)
+		{
+			Layer& layer = kvp.second;
+			layer.visibleChunks.clear();
+
+			for (int chunkY = firstY; chunkY <= lastY; ++chunkY)
+			{
+				for (int chunkX = firstX; chunkX <= lastX; ++chunkX)
+				{
+					auto chunk = layer.chunks.find(makeKey(chunkX, chunkY));
+					if (chunk == layer.chunks.end()) continue;
+
+					// Only visible chunks are baked, others will be baked when they come into view
+					if (chunk->second.dirty)
+					{
+						bake(chunk->second, chunkX, chunkY);
+						baked = true;
+					}
+
+					// Rounding both edges keeps neighbouring chunks seamless when zoomed
+					vec2 origin{ (chunkX * STATIC_CHUNK_SIZE - topLeft.x) * zoom, (chunkY * STATIC_CHUNK_SIZE - topLeft.y) * zoom };
+					SDL_Rect destination;
+					destination.x = (int)std::floor(origin.x);
+					destination.y = (int)std::floor(origin.y);
+					destination.w = (int)std::floor(origin.x + STATIC_CHUNK_SIZE * zoom) - destination.x;
+					destination.h = (int)std::floor(origin.y + STATIC_CHUNK_SIZE * zoom) - destination.y;
+					layer.visibleChunks.push_back({ &(chunk->second), origin, destination, false });
+				}
+			}
+		}
+
+		nextLayer = layers.begin();
+		nextCulledLayer = layers.rbegin();
+		return baked;
+	}
+
+	void StaticTileLayer::drawLayer(Layer& layer, SoftwareRasterizer* rasterizer)
+	{
+		SDL_Renderer* renderer = Window::getRenderer();
+		for (const VisibleChunk& visible : layer.visibleChunks)
+		{
+			if (visible.occluded) continue;
+
+			++numDrawCalls;
+			SDL_Texture* texture = visible.chunk->texture->get();
+			if (rasterizer)
+			{
+				if (rasterizer->draw(texture, nullptr, visible.destination, SDL_FLIP_NONE)) continue;
+
+				// Queued copies are drawn first to keep drawing order
+				rasterizer->flush();
+			}
+
+			SDL_RenderCopy(renderer, texture, nullptr, &(visible.destination));
+		}
+	}
+
+	void StaticTileLayer::cullLayer(Layer& layer, CoverageGrid& coverage)
+	{
+		float zoom = Window::getCameraZoom();
+		for (VisibleChunk& visible : layer.visibleChunks)
+		{
+			if (coverage.isCovered(visible.destination))
+			{
+				visible.occluded = true;
+				++numCulled;
+				continue;
+			}
+
+			// Only pixels entirely inside opaque rectangles are covered
+			for (const SDL_Rect& opaque : visible.chunk->opaqueRects)
+			{
+				int left = (int)std::ceil(visible.origin.x + opaque.x * zoom);
+				int top = (int)std::ceil(visible.origin.y + opaque.y * zoom);
+				int right = (int)std::floor(visible.origin.x + (opaque.x + opaque.w) * zoom);
+				int bottom = (int)std::floor(visible.origin.y + (opaque.y + opaque.h) * zoom);
+				coverage.cover({ left, top, right - left, bottom - top });
+			}
+		}
+	}
+
+	void StaticTileLayer::cullAbove(int zIndex, CoverageGrid& coverage)
+	{
+		// Layers are drawn below components sharing their zIndex
+		while (nextCulledLayer != layers.rend() && nextCulledLayer->first > zIndex)
+		{
+			cullLayer(nextCulledLayer->second, coverage);
+			++nextCulledLayer;
+		}
+	}
+
+	void StaticTileLayer::cullRemaining(CoverageGrid& coverage)
+	{
+		while (nextCulledLayer != layers.rend())
+		{
+			cullLayer(nextCulledLayer->second, coverage);
+			++nextCulledLayer;
+		}
+	}
+
+	void StaticTileLayer::recordOverdraw(OverdrawAnalyzer& analyzer, float scale)
+	{
+		for (const auto& kvp : layers)
+		{
+			std::string name = "Static tiles (zIndex " + std::to_string(kvp.first) + ")";
+			for (const VisibleChunk& visible : kvp.second.visibleChunks)
+			{
+				// Chunks are transparent where there are no tiles and always blended
+				if (!visible.occluded)
+				{
+					analyzer.record(visible.destination, true, name, "", scale);
+				}
+			}
+		}
+	}
+
+	void StaticTileLayer::mergeRects(std::vector<SDL_Rect>& rects)
+	{
+		if (rects.size() < 2) return;
+
+		// Rows first: rectangles sharing the same vertical span and touching horizontally
+		std::sort(rects.begin(), rects.end(), [](const SDL_Rect& a, const SDL_Rect& b)
+			{
+				if (a.y != b.y) return a.y < b.y;
+				if (a.h != b.h) return a.h < b.h;
+				return a.x < b.x;
+			});
+
+		size_t count = 1;
+		for (size_t i = 1; i < rects.size(); ++i)
+		{
+			const SDL_Rect& rect = rects[i];
+			SDL_Rect& last = rects[count - 1];
+			if (last.y == rect.y && last.h == rect.h && rect.x <= last.x + last.w)
+			{
+				last.w = std::max(last.x + last.w, rect.x + rect.w) - last.x;
+			}
+			else
+			{
+				rects[count++] = rect;
+			}
+		}
+		rects.resize(count);
+
+		// Then columns: rows sharing the same horizontal span and touching vertically
+		std::sort(rects.begin(), rects.end(), [](const SDL_Rect& a, const SDL_Rect& b)
+			{
+				if (a.x != b.x) return a.x < b.x;
+				if (a.w != b.w) return a.w < b.w;
+				return a.y < b.y;
+			});
+
+		count = 1;
+		for (size_t i = 1; i < rects.size(); ++i)
+		{
+			const SDL_Rect& rect = rects[i];
+			SDL_Rect& last = rects[count - 1];
+			if (last.x == rect.x && last.w == rect.w && rect.y <= last.y + last.h)
+			{
+				last.h = std::max(last.y + last.h, rect.y + rect.h) - last.y;
+			}
+			else
+			{
+				rects[count++] = rect;
+			}
+		}
+		rects.resize(count);
+	}
+
+	void StaticTileLayer::drawUpTo(int zIndex, SoftwareRasterizer* rasterizer)
+	{
+		while (nextLayer != layers.end() && nextLayer->first <= zIndex)
+		{
+			drawLayer(nextLayer->second, rasterizer);
+			++nextLayer;
+		}
+	}
+
+	void StaticTileLayer::drawRemaining(SoftwareRasterizer* rasterizer)
+	{
+		while (nextLayer != layers.end())
+		{
+			drawLayer(nextLayer->second, rasterizer);
+			++nextLayer;
+		}
+	}
+
+	void StaticTileLayer::quit()
+	{
+		layers.clear();
+		placements.clear();
+		nextLayer = layers.end();
+		nextCulledLayer = layers.rend();
+	}
+}
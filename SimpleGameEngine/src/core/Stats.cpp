@@ -0,0 +1,189 @@
+#include "core/Stats.h"
+#include "core/Game.h"
+#include "core/Audio.h"
+#include "core/Texture.h"
+#include "core/AllocationTracker.h"
+#include "components/Component.h"
+#include "components/AnimatedTextureComponent.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace sg
+{
+	EngineStats Stats::current;
+	float Stats::frameBudget = 1.f / 60.f;
+	std::vector<float> Stats::frameTimes(STATS_FRAME_HISTORY, 0.f);
+	std::vector<float> Stats::sortedFrameTimes;
+	std::map<std::string, double> Stats::counters;
+	std::atomic<uint64_t> Stats::bytesLoaded{ 0 };
+	double Stats::sessionTime = 0.0;
+
+	std::ofstream Stats::dumpFile;
+	float Stats::dumpInterval = 10.f;
+	float Stats::timeSinceDump = 0.f;
+	uint64_t Stats::framesSinceDump = 0;
+	uint64_t Stats::hitchesAtDump = 0;
+	uint64_t Stats::stuttersAtDump = 0;
+
+	namespace
+	{
+		void writeEscaped(std::ofstream& file, const std::string& text)
+		{
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\') file << '\\';
+				file << c;
+			}
+		}
+
+		void writeCache(std::ofstream& file, const char* name, const CacheStatistics& statistics)
+		{
+			file << ",\"" << name << "\":{\"hits\":" << statistics.hits << ",\"misses\":" << statistics.misses
+				<< ",\"size\":" << statistics.size << "}";
+		}
+
+		// Nearest rank percentile of sorted values
+		float percentile(const std::vector<float>& sorted, float ratio)
+		{
+			size_t rank = (size_t)std::ceil(ratio * (float)sorted.size());
+			return sorted[(rank > 0) ? rank - 1 : 0];
+		}
+	}
+
+	FrameTimePercentiles Stats::getFrameTimes(size_t frames)
+	{
+		FrameTimePercentiles result;
+		result.frames = (size_t)std::min<uint64_t>({ (uint64_t)frames, current.frame, (uint64_t)STATS_FRAME_HISTORY });
+		if (result.frames == 0) return result;
+
+		sortedFrameTimes.clear();
+		for (uint64_t i = current.frame - result.frames; i < current.frame; ++i)
+		{
+			sortedFrameTimes.push_back(frameTimes[i % STATS_FRAME_HISTORY]);
+		}
+		std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+
+		result.p50 = percentile(sortedFrameTimes, 0.5f);
+		result.p95 = percentile(sortedFrameTimes, 0.95f);
+		result.p99 = percentile(sortedFrameTimes, 0.99f);
+		result.max = sortedFrameTimes.back();
+		return result;
+	}
+
+	size_t Stats::getRecentHitches(size_t frames)
+	{
+		uint64_t numFrames = std::min<uint64_t>({ (uint64_t)frames, current.frame, (uint64_t)STATS_FRAME_HISTORY });
+
+		size_t hitches = 0;
+		for (uint64_t i = current.frame - numFrames; i < current.frame; ++i)
+		{
+			hitches += frameTimes[i % STATS_FRAME_HISTORY] > frameBudget;
+		}
+		return hitches;
+	}
+
+	double Stats::getCounter(const std::string& name)
+	{
+		auto found = counters.find(name);
+		return (found != counters.end()) ? found->second : 0.0;
+	}
+
+	bool Stats::setDumpFile(const std::string& path, float intervalSeconds)
+	{
+		dumpFile.close();
+		dumpInterval = intervalSeconds;
+		timeSinceDump = 0.f;
+		framesSinceDump = 0;
+		hitchesAtDump = current.totalHitches;
+		stuttersAtDump = current.totalStutters;
+
+		if (path.empty()) return true;
+
+		// Sessions are appended, each line tells which frame of its session it was written at
+		dumpFile.open(path, std::ios::app);
+		return dumpFile.is_open();
+	}
+
+	void Stats::dump()
+	{
+		if (!dumpFile.is_open()) return;
+
+		FrameTimePercentiles times = getFrameTimes((size_t)std::max<uint64_t>(framesSinceDump, 1));
+
+		dumpFile << "{\"frame\":" << current.frame << ",\"sessionTime\":" << sessionTime
+			<< ",\"frameTime\":{\"frames\":" << times.frames << ",\"p50\":" << times.p50 << ",\"p95\":" << times.p95
+			<< ",\"p99\":" << times.p99 << ",\"max\":" << times.max << "}"
+			<< ",\"frameBudget\":" << frameBudget
+			<< ",\"hitches\":" << current.totalHitches - hitchesAtDump << ",\"totalHitches\":" << current.totalHitches
+			<< ",\"stutters\":" << current.totalStutters - stuttersAtDump << ",\"totalStutters\":" << current.totalStutters
+			<< ",\"objects\":" << current.objects << ",\"components\":" << current.components
+			<< ",\"drawables\":" << current.drawables << ",\"drawCalls\":" << current.drawCalls
+			<< ",\"textureSwitches\":" << current.textureSwitches << ",\"culled\":" << current.culled
+			<< ",\"soundsPlaying\":" << current.soundsPlaying << ",\"bytesLoaded\":" << current.totalBytesLoaded
+			<< ",\"allocations\":" << current.allocations << ",\"allocatedBytes\":" << current.allocatedBytes;
+		writeCache(dumpFile, "textureCache", current.textureCache);
+		writeCache(dumpFile, "animationCache", current.animationCache);
+
+		dumpFile << ",\"counters\":{";
+		bool first = true;
+		for (const auto& counter : counters)
+		{
+			dumpFile << ((first) ? "\"" : ",\"");
+			writeEscaped(dumpFile, counter.first);
+			dumpFile << "\":" << counter.second;
+			first = false;
+		}
+		dumpFile << "}}\n";
+
+		// Dashboards read the file while the game runs
+		dumpFile.flush();
+
+		timeSinceDump = 0.f;
+		framesSinceDump = 0;
+		hitchesAtDump = current.totalHitches;
+		stuttersAtDump = current.totalStutters;
+	}
+
+	void Stats::endFrame(const EngineStats& stats)
+	{
+		uint64_t frame = current.frame;
+		uint64_t totalHitches = current.totalHitches, totalStutters = current.totalStutters;
+
+		current = stats;
+		current.frame = frame + 1;
+		current.objects = Game::getAllObjects().size();
+		current.components = Component::getCount();
+		current.soundsPlaying = Audio::getNumPlayingSounds();
+		current.textureCache = Texture::getCacheStatistics();
+		current.animationCache = AnimatedTextureComponent::getCacheStatistics();
+		current.totalBytesLoaded = bytesLoaded.load(std::memory_order_relaxed);
+		current.allocations = AllocationTracker::getLastFrame().allocations;
+		current.allocatedBytes = AllocationTracker::getLastFrame().bytes;
+		current.totalHitches = totalHitches + (stats.frameTime > frameBudget);
+
+		// Compared with the median of the frames before it, a constant slow frame rate isn't a stutter
+		current.totalStutters = totalStutters;
+		if (frame >= STATS_STUTTER_WINDOW)
+		{
+			std::array<float, STATS_STUTTER_WINDOW> recent;
+			for (size_t i = 0; i < STATS_STUTTER_WINDOW; ++i)
+			{
+				recent[i] = frameTimes[(frame - STATS_STUTTER_WINDOW + i) % STATS_FRAME_HISTORY];
+			}
+			std::nth_element(recent.begin(), recent.begin() + STATS_STUTTER_WINDOW / 2, recent.end());
+			current.totalStutters += stats.frameTime > STATS_STUTTER_RATIO * recent[STATS_STUTTER_WINDOW / 2];
+		}
+
+		frameTimes[frame % STATS_FRAME_HISTORY] = stats.frameTime;
+		sessionTime += stats.frameTime;
+
+		++framesSinceDump;
+		timeSinceDump += stats.frameTime;
+		if (dumpFile.is_open() && timeSinceDump >= dumpInterval)
+		{
+			dump();
+		}
+	}
+}
@@ -1,5 +1,9 @@
 #include "core/Texture.h"
 #include "core/Window.h"
+#include "core/SoftwareRasterizer.h"
+#include "core/Profiler.h"
+#include "core/Stats.h"
+#include "core/Tracepoints.h"
 #include "assistants/Resources.h"
 
 #include <SDL_image.h>
@@ -9,6 +13,8 @@
 namespace sg
 {
 	Cache<std::string, SDL_Texture*> Texture::cachedTextures;
+	std::unordered_map<SDL_Texture*, std::shared_ptr<const OpacityMask>> Texture::cachedOpacities;
+	std::unordered_map<SDL_Texture*, std::shared_ptr<const TextureLevels>> Texture::cachedLevels;
 
 	TextureException::TextureException(const char* message) : m_message(message) {}
 
@@ -20,37 +26,69 @@ namespace sg
 		std::pair<CacheRef<std::string, SDL_Texture*>, bool> ref = cachedTextures.find(path);
 		if (ref.second)
 		{
+			SG_TRACE1(texture_cache_hit, path.c_str());
 			m_cachedTexture = std::make_unique<CacheRef<std::string, SDL_Texture*>>(ref.first);
+			m_opacity = cachedOpacities[m_cachedTexture->get()];
+			m_levels = cachedLevels[m_cachedTexture->get()];
 		}
 		// Otherwise load a new texture and add it to the cache
 		else
 		{
+			SG_TRACE1(texture_cache_miss, path.c_str());
+			SG_PROFILE_SCOPE("Texture load");
+			uint64_t loadStart = SG_TRACE_NOW();
 			SDL_Surface* surface = IMG_Load(path.c_str());
 
 			if (surface == nullptr)
 			{
 				throw TextureException("Failed to load image");
 			}
+			uint64_t bytes = (uint64_t)surface->pitch * surface->h;
+			Stats::addBytesLoaded(bytes);
 
-			m_cachedTexture = std::make_unique<CacheRef<std::string, SDL_Texture*>>(cachedTextures.add(path, SDL_CreateTextureFromSurface(Window::getRenderer(), surface)));
+			SDL_Texture* texture = SDL_CreateTextureFromSurface(Window::getRenderer(), surface);
+			SoftwareRasterizer::registerTexture(texture, surface);
+			m_opacity = std::make_shared<OpacityMask>(surface);
+			cachedOpacities[texture] = m_opacity;
+			m_levels = std::make_shared<TextureLevels>(Window::getRenderer(), surface);
+			cachedLevels[texture] = m_levels;
+			m_cachedTexture = std::make_unique<CacheRef<std::string, SDL_Texture*>>(cachedTextures.add(path, texture));
 			SDL_FreeSurface(surface);
+			SG_TRACE3(texture_load, path.c_str(), SG_TRACE_NOW() - loadStart, bytes);
 		}
 	}
 
 	void Texture::makeTexture(const std::string& path)
 	{
+		SG_PROFILE_SCOPE("Texture load");
+		uint64_t loadStart = SG_TRACE_NOW();
 		SDL_Surface* surface = IMG_Load(Resources::pathTo(path).c_str());
 
 		if (surface == nullptr)
 		{
 			throw TextureException("Failed to load image");
 		}
+		uint64_t bytes = (uint64_t)surface->pitch * surface->h;
+		Stats::addBytesLoaded(bytes);
 
 		m_texture = SDL_CreateTextureFromSurface(Window::getRenderer(), surface);
+		SoftwareRasterizer::registerTexture(m_texture, surface);
+		m_opacity = std::make_shared<OpacityMask>(surface);
+		m_levels = std::make_shared<TextureLevels>(Window::getRenderer(), surface);
 		SDL_FreeSurface(surface);
+		SG_TRACE3(texture_load, path.c_str(), SG_TRACE_NOW() - loadStart, bytes);
+	}
+
+	void Texture::querySize()
+	{
+		if (SDL_Texture* texture = get())
+		{
+			SDL_QueryTexture(texture, nullptr, nullptr, &m_width, &m_height);
+		}
 	}
 
 	Texture::Texture(const std::string& path, bool useCache)
+		: m_path(path)
 	{
 		if (useCache)
 		{
@@ -60,18 +98,74 @@ namespace sg
 		{
 			makeTexture(path);
 		}
+
+		querySize();
 	}
 
 	Texture::Texture(SDL_Surface* surface)
 	{
 		m_texture = SDL_CreateTextureFromSurface(Window::getRenderer(), surface);
+		SoftwareRasterizer::registerTexture(m_texture, surface);
+		m_opacity = std::make_shared<OpacityMask>(surface);
 		SDL_FreeSurface(surface);
+		querySize();
 	}
 
-	Texture::Texture(int width, int height)
+	Texture::Texture(SDL_Surface* surface, const std::string& cacheKey)
+		: m_path(cacheKey)
 	{
-		m_texture = SDL_CreateTexture(Window::getRenderer(), SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
-		isTargetTexture = true;
+		std::pair<CacheRef<std::string, SDL_Texture*>, bool> ref = cachedTextures.find(cacheKey);
+		if (ref.second)
+		{
+			SG_TRACE1(texture_cache_hit, cacheKey.c_str());
+			m_cachedTexture = std::make_unique<CacheRef<std::string, SDL_Texture*>>(ref.first);
+			m_opacity = cachedOpacities[m_cachedTexture->get()];
+			m_levels = cachedLevels[m_cachedTexture->get()];
+		}
+		else
+		{
+			SG_TRACE1(texture_cache_miss, cacheKey.c_str());
+			SDL_Texture* texture = SDL_CreateTextureFromSurface(Window::getRenderer(), surface);
+			SoftwareRasterizer::registerTexture(texture, surface);
+			m_opacity = std::make_shared<OpacityMask>(surface);
+			cachedOpacities[texture] = m_opacity;
+			m_levels = std::make_shared<TextureLevels>(Window::getRenderer(), surface);
+			cachedLevels[texture] = m_levels;
+			m_cachedTexture = std::make_unique<CacheRef<std::string, SDL_Texture*>>(cachedTextures.add(cacheKey, texture));
+		}
+
+		SDL_FreeSurface(surface);
+		querySize();
+	}
+
+	Texture::Texture(int width, int height, SDL_TextureAccess access)
+		: m_width(width), m_height(height)
+	{
+		if (access != SDL_TEXTUREACCESS_STREAMING)
+		{
+			m_texture = SDL_CreateTexture(Window::getRenderer(), SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+			isTargetTexture = true;
+			return;
+		}
+
+		m_texture = SDL_CreateTexture(Window::getRenderer(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+		if (m_texture == nullptr)
+		{
+			throw TextureException("Failed to create streaming texture");
+		}
+		SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+
+		// Content of a new texture is undefined, start from transparent pixels
+		m_pixels.assign((size_t)width * height, 0);
+		m_dirtyPixels.push_back({ 0, 0, width, height });
+		uploadPixels();
+
+		if (SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(m_pixels.data(), width, height, 32,
+			width * (int)sizeof(Uint32), SDL_PIXELFORMAT_ARGB8888))
+		{
+			SoftwareRasterizer::registerTexture(m_texture, surface);
+			SDL_FreeSurface(surface);
+		}
 	}
 
 	Texture::~Texture()
@@ -79,20 +173,100 @@ namespace sg
 		// If we are not relying on the cache for this texture we must destroy it
 		if (m_texture)
 		{
+			SoftwareRasterizer::unregisterTexture(m_texture);
 			SDL_DestroyTexture(m_texture);
 		}
 
 		// Make sure this texture is the last reference to the texture in the cache
 		if (m_cachedTexture && m_cachedTexture->getNumRef() == 1)
 		{
+			SoftwareRasterizer::unregisterTexture(m_cachedTexture->get());
+			cachedOpacities.erase(m_cachedTexture->get());
+			cachedLevels.erase(m_cachedTexture->get());
 			SDL_DestroyTexture(m_cachedTexture->get());
 		}
 	}
 
+	bool Texture::isOpaque(const SDL_Rect* source) const
+	{
+		if (m_opacity == nullptr) return false;
+
+		// Modulated alpha and blend modes other than regular blending change what's below
+		SDL_Texture* texture = get();
+		SDL_BlendMode blendMode;
+		Uint8 alpha;
+		if (SDL_GetTextureBlendMode(texture, &blendMode) != 0 || SDL_GetTextureAlphaMod(texture, &alpha) != 0 || alpha != 255)
+		{
+			return false;
+		}
+
+		// Without blending every pixel is copied as is, the source only has to stay inside the texture
+		if (blendMode == SDL_BLENDMODE_NONE)
+		{
+			return source == nullptr || (source->w > 0 && source->h > 0 && source->x >= 0 && source->y >= 0 &&
+				source->x + source->w <= m_width && source->y + source->h <= m_height);
+		}
+		if (blendMode != SDL_BLENDMODE_BLEND) return false;
+
+		return (source) ? m_opacity->isOpaque(*source) : m_opacity->isFullyOpaque();
+	}
+
+	Uint32* Texture::lockPixels(const SDL_Rect* region)
+	{
+		if (m_pixels.empty()) return nullptr;
+
+		// Callers write the size they asked for from the returned pixel, a clipped region would let them
+		// write outside of the buffer
+		SDL_Rect locked{ 0, 0, m_width, m_height };
+		if (region)
+		{
+			if (region->w <= 0 || region->h <= 0 || region->x < 0 || region->y < 0 ||
+				region->x > m_width - region->w || region->y > m_height - region->h)
+			{
+				return nullptr;
+			}
+			locked = *region;
+		}
+
+		m_pixelsLocked = true;
+		if (m_dirtyPixels.size() < MAX_DIRTY_PIXEL_REGIONS)
+		{
+			m_dirtyPixels.push_back(locked);
+		}
+		else
+		{
+			// Too many small uploads cost more than a larger one
+			SDL_UnionRect(&m_dirtyPixels[0], &locked, &m_dirtyPixels[0]);
+			for (size_t i = 1; i < m_dirtyPixels.size(); ++i)
+			{
+				SDL_UnionRect(&m_dirtyPixels[0], &m_dirtyPixels[i], &m_dirtyPixels[0]);
+			}
+			m_dirtyPixels.resize(1);
+		}
+
+		return &m_pixels[(size_t)locked.y * m_width + locked.x];
+	}
+
+	bool Texture::uploadPixels()
+	{
+		if (m_pixelsLocked || m_dirtyPixels.empty()) return false;
+
+		for (const SDL_Rect& region : m_dirtyPixels)
+		{
+			const Uint32* pixels = &m_pixels[(size_t)region.y * m_width + region.x];
+			SDL_UpdateTexture(m_texture, &region, pixels, m_width * (int)sizeof(Uint32));
+			SoftwareRasterizer::updateTexture(m_texture, region, pixels, m_width * (int)sizeof(Uint32));
+		}
+
+		m_dirtyPixels.clear();
+		return true;
+	}
+
 	void Texture::startDrawingOnTexture()
 	{
 		if (isTargetTexture)
 		{
+			m_previousTarget = SDL_GetRenderTarget(Window::getRenderer());
 			SDL_SetRenderTarget(Window::getRenderer(), m_texture);
 			initializedTextureDrawing = true;
 		}
@@ -102,23 +276,39 @@ namespace sg
 	{
 		if (isTargetTexture && initializedTextureDrawing)
 		{
-			int w, h;
-			SDL_QueryTexture(texture.get(), nullptr, nullptr, &w, &h);
 			SDL_Rect textureInfo{ 0, 0, 0, 0 };
 			textureInfo.x = (int)position.x;
 			textureInfo.y = (int)position.y;
-			textureInfo.w = w;
-			textureInfo.h = h;
+			textureInfo.w = texture.getWidth();
+			textureInfo.h = texture.getHeight();
 			SDL_RenderCopyEx(Window::getRenderer(), texture.get(), nullptr, &textureInfo, 0.f, nullptr, SDL_FLIP_NONE);
 		}
 	}
 
+	void Texture::renderOnTexture(const Texture& texture, const SDL_Rect& source, const SDL_Rect& destination, SDL_RendererFlip flip)
+	{
+		if (isTargetTexture && initializedTextureDrawing)
+		{
+			SDL_RenderCopyEx(Window::getRenderer(), texture.get(), &source, &destination, 0.f, nullptr, flip);
+		}
+	}
+
+	void Texture::clear()
+	{
+		if (isTargetTexture && initializedTextureDrawing)
+		{
+			SDL_SetRenderDrawColor(Window::getRenderer(), 0, 0, 0, 0);
+			SDL_RenderClear(Window::getRenderer());
+		}
+	}
+
 	void Texture::stopDrawingOnTexture()
 	{
 		if (isTargetTexture && initializedTextureDrawing)
 		{
 			initializedTextureDrawing = false;
-			SDL_SetRenderTarget(Window::getRenderer(), nullptr);
+			SDL_SetRenderTarget(Window::getRenderer(), m_previousTarget);
+			m_previousTarget = nullptr;
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "core/TextureLevels.h"
+#include "core/SoftwareRasterizer.h"
+
+#include <SDL.h>
+
+namespace sg
+{
+	bool TextureLevels::generating = false;
+	int TextureLevels::padding = 0;
+
+	namespace
+	{
+		// Average 2x2 blocks of an ARGB8888 surface into a surface half its size
+		SDL_Surface* downscale(SDL_Surface* image)
+		{
+			int width = image->w / 2, height = image->h / 2;
+			SDL_Surface* level = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+			if (level == nullptr) return nullptr;
+
+			SDL_LockSurface(image);
+			SDL_LockSurface(level);
+			for (int y = 0; y < height; ++y)
+			{
+				const Uint32* top = (const Uint32*)((const Uint8*)image->pixels + (size_t)(2 * y) * image->pitch);
+				const Uint32* bottom = (const Uint32*)((const Uint8*)image->pixels + (size_t)(2 * y + 1) * image->pitch);
+				Uint32* row = (Uint32*)((Uint8*)level->pixels + (size_t)y * level->pitch);
+
+				for (int x = 0; x < width; ++x)
+				{
+					Uint32 block[4] = { top[2 * x], top[2 * x + 1], bottom[2 * x], bottom[2 * x + 1] };
+					Uint32 alpha = 0, red = 0, green = 0, blue = 0;
+					for (Uint32 pixel : block)
+					{
+						Uint32 a = pixel >> 24;
+						alpha += a;
+						red += ((pixel >> 16) & 0xFF) * a;
+						green += ((pixel >> 8) & 0xFF) * a;
+						blue += (pixel & 0xFF) * a;
+					}
+
+					if (alpha == 0)
+					{
+						row[x] = 0;
+						continue;
+					}
+
+					// Colors are weighted by alpha, then alpha is averaged
+					red = (red + alpha / 2) / alpha;
+					green = (green + alpha / 2) / alpha;
+					blue = (blue + alpha / 2) / alpha;
+					row[x] = (((alpha + 2) / 4) << 24) | (red << 16) | (green << 8) | blue;
+				}
+			}
+			SDL_UnlockSurface(level);
+			SDL_UnlockSurface(image);
+
+			return level;
+		}
+	}
+
+	TextureLevels::TextureLevels(SDL_Renderer* renderer, SDL_Surface* surface)
+	{
+		if (!generating || surface == nullptr ||
+			surface->w < 2 * TEXTURE_LEVEL_MIN_SIZE || surface->h < 2 * TEXTURE_LEVEL_MIN_SIZE)
+		{
+			return;
+		}
+
+		// Color keyed pixels become transparent when converted to a format with alpha,
+		// pixels of surfaces without alpha channel become opaque
+		SDL_Surface* image = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (image == nullptr) return;
+
+		while (m_levels.size() < TEXTURE_MAX_LEVELS &&
+			image->w / 2 >= TEXTURE_LEVEL_MIN_SIZE && image->h / 2 >= TEXTURE_LEVEL_MIN_SIZE)
+		{
+			SDL_Surface* level = downscale(image);
+			SDL_FreeSurface(image);
+			image = level;
+			if (image == nullptr) break;
+
+			SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, image);
+			if (texture == nullptr) break;
+
+			SoftwareRasterizer::registerTexture(texture, image);
+			m_levels.push_back(texture);
+		}
+
+		if (image)
+		{
+			SDL_FreeSurface(image);
+		}
+	}
+
+	TextureLevels::~TextureLevels()
+	{
+		for (SDL_Texture* texture : m_levels)
+		{
+			SoftwareRasterizer::unregisterTexture(texture);
+			SDL_DestroyTexture(texture);
+		}
+	}
+
+	int TextureLevels::select(SDL_Rect* source, int width, int height, const SDL_Rect& destination) const
+	{
+		// The whole image has no neighbours to bleed from
+		bool part = source && (source->x != 0 || source->y != 0 || source->w != width || source->h != height);
+
+		int sourceWidth = (source) ? source->w : width;
+		int sourceHeight = (source) ? source->h : height;
+
+		// Never draw a level smaller than the destination, it would be upscaled
+		int level = 0;
+		while ((size_t)level < m_levels.size() &&
+			(sourceWidth >> (level + 1)) >= destination.w && (sourceHeight >> (level + 1)) >= destination.h)
+		{
+			// Blocks of the next level must not straddle the edges of the rectangle
+			int block = 1 << (level + 1);
+			if (part && (padding < block ||
+				(source->x | source->y | source->w | source->h) & (block - 1)))
+			{
+				break;
+			}
+			++level;
+		}
+
+		if (level > 0 && source)
+		{
+			// Exact since the rectangle is aligned to the level, or is the whole image
+			*source = { source->x >> level, source->y >> level, source->w >> level, source->h >> level };
+		}
+
+		return level;
+	}
+
+	void TextureLevels::copyModulation(SDL_Texture* from, SDL_Texture* to)
+	{
+		Uint8 red = 255, green = 255, blue = 255, alpha = 255;
+		SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+		SDL_ScaleMode scaleMode = SDL_ScaleModeNearest;
+
+		SDL_GetTextureColorMod(from, &red, &green, &blue);
+		SDL_GetTextureAlphaMod(from, &alpha);
+		SDL_GetTextureBlendMode(from, &blendMode);
+		SDL_GetTextureScaleMode(from, &scaleMode);
+
+		SDL_SetTextureColorMod(to, red, green, blue);
+		SDL_SetTextureAlphaMod(to, alpha);
+		SDL_SetTextureBlendMode(to, blendMode);
+		SDL_SetTextureScaleMode(to, scaleMode);
+	}
+}
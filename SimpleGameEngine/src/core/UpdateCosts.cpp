@@ -0,0 +1,166 @@
+#include "core/UpdateCosts.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace sg
+{
+	bool UpdateCosts::enabled = false;
+	std::unordered_map<std::type_index, size_t> UpdateCosts::indices;
+	std::vector<UpdateCosts::Entry> UpdateCosts::entries;
+	std::type_index UpdateCosts::lastType = typeid(void);
+	size_t UpdateCosts::lastIndex = 0;
+	uint64_t UpdateCosts::numFrames = 0;
+
+	namespace
+	{
+		std::string readableName(const std::type_info& type)
+		{
+#if defined(__GNUG__)
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+			if (status == 0 && demangled)
+			{
+				std::string name(demangled);
+				std::free(demangled);
+				return name;
+			}
+#endif
+			// MSVC names are already readable
+			return type.name();
+		}
+	}
+
+	void UpdateCosts::beginFrame()
+	{
+		for (Entry& entry : entries)
+		{
+			entry.frameSeconds = 0.0;
+			entry.frameCalls = 0;
+		}
+	}
+
+	void UpdateCosts::endFrame()
+	{
+		size_t slot = numFrames % UPDATE_COST_HISTORY;
+		for (Entry& entry : entries)
+		{
+			entry.history[slot] = (float)entry.frameSeconds;
+			entry.historyCalls[slot] = entry.frameCalls;
+			entry.totalSeconds += entry.frameSeconds;
+			entry.totalCalls += entry.frameCalls;
+		}
+		++numFrames;
+	}
+
+	void UpdateCosts::record(const std::type_info& type, std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+		std::type_index index(type);
+		if (index != lastType)
+		{
+			auto found = indices.find(index);
+			if (found == indices.end())
+			{
+				Entry entry;
+				entry.name = readableName(type);
+				entry.history.assign(UPDATE_COST_HISTORY, 0.f);
+				entry.historyCalls.assign(UPDATE_COST_HISTORY, 0);
+				found = indices.emplace(index, entries.size()).first;
+				entries.push_back(std::move(entry));
+			}
+
+			lastType = index;
+			lastIndex = found->second;
+		}
+
+		Entry& entry = entries[lastIndex];
+		entry.frameSeconds += duration.count();
+		++entry.frameCalls;
+	}
+
+	std::vector<UpdateCostSummary> UpdateCosts::getTop(size_t count)
+	{
+		size_t frames = (size_t)std::min<uint64_t>(numFrames, UPDATE_COST_HISTORY);
+		std::vector<UpdateCostSummary> summaries;
+		summaries.reserve(entries.size());
+
+		std::vector<float> sorted;
+		for (const Entry& entry : entries)
+		{
+			UpdateCostSummary summary;
+			summary.name = entry.name;
+			summary.total = entry.totalSeconds * 1000.0;
+			summary.totalCalls = entry.totalCalls;
+
+			if (frames > 0)
+			{
+				sorted.assign(entry.history.begin(), entry.history.begin() + frames);
+				std::sort(sorted.begin(), sorted.end());
+
+				double sum = 0.0;
+				for (float seconds : sorted) sum += seconds;
+				uint64_t calls = 0;
+				for (size_t i = 0; i < frames; ++i) calls += entry.historyCalls[i];
+
+				// Nearest rank percentile
+				size_t rank = (frames * 99 + 99) / 100;
+				summary.average = sum / frames * 1000.0;
+				summary.p99 = sorted[rank - 1] * 1000.0;
+				summary.max = sorted.back() * 1000.0;
+				summary.callsPerFrame = (double)calls / frames;
+			}
+
+			summaries.push_back(std::move(summary));
+		}
+
+		std::sort(summaries.begin(), summaries.end(), [](const UpdateCostSummary& a, const UpdateCostSummary& b)
+			{
+				return a.average > b.average;
+			});
+		summaries.resize(std::min(count, summaries.size()));
+		return summaries;
+	}
+
+	bool UpdateCosts::writeReport(const std::string& path, size_t count)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		std::vector<UpdateCostSummary> top = getTop(count);
+
+		file << std::fixed << std::setprecision(3);
+		file << "Update cost report: " << numFrames << " frames, last "
+			<< std::min<uint64_t>(numFrames, UPDATE_COST_HISTORY) << " used for per frame values\n\n";
+		file << "Top " << top.size() << " types by average cost per frame, in milliseconds:\n";
+		file << std::setw(10) << "average" << std::setw(10) << "p99" << std::setw(10) << "max"
+			<< std::setw(12) << "calls" << std::setw(12) << "total" << "  type\n";
+
+		for (const UpdateCostSummary& summary : top)
+		{
+			file << std::setw(10) << summary.average << std::setw(10) << summary.p99 << std::setw(10) << summary.max
+				<< std::setw(12) << summary.callsPerFrame << std::setw(12) << summary.total << "  " << summary.name << "\n";
+		}
+
+		return file.good();
+	}
+
+	void UpdateCosts::reset()
+	{
+		indices.clear();
+		entries.clear();
+		lastType = typeid(void);
+		lastIndex = 0;
+		numFrames = 0;
+	}
+}
@@ -5,6 +5,8 @@
 #include <SDL_ttf.h>
 #include <tuple>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 #include "core/Window.h"
 #include "core/Input.h"
@@ -12,12 +14,23 @@
 #include "core/Game.h"
 #include "core/Quadtree.h"
 #include "core/Audio.h"
+#include "core/StaticTileLayer.h"
+#include "core/Tracepoints.h"
 
 #include "components/DrawableComponent.h"
 #include "components/BoxComponent.h"
+#include "components/AnimatedTextureComponent.h"
 
 namespace sg
 {
+	namespace
+	{
+		float secondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
 	WindowException::WindowException(const char* message, bool sdlError)
 	{
 		m_message += "[Window Error] ";
@@ -35,9 +48,9 @@ namespace sg
 	}
 
 	Window* Window::instance = nullptr;
-	using DrawablePair = std::tuple<Object*, DrawableComponent*>;
 
-	Window::Window(const char* title, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+	Window::Window(const char* title, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+		const WindowOptions& options)
 	{
 		if (instance != nullptr)
 		{
@@ -45,23 +58,119 @@ namespace sg
 		}
 
 		instance = this;
+
+		if (!Log::isOpen())
+		{
+			if (!Log::open(options.logPath))
+			{
+				throw WindowException("Failed to open the log file", false);
+			}
+			m_closeLog = true;
+		}
+
+		// Drivers are picked when SDL initializes
+		if (options.headless)
+		{
+			SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+		}
 		SDL_Init(SDL_INIT_EVERYTHING);
 		TTF_Init();
 
-		m_window = SDL_CreateWindow(title, x, y, width, height, SDL_WINDOW_OPENGL);
+		m_softwareRenderer = options.softwareRenderer || options.headless;
+
+		// The software renderer draws in the window's surface, OpenGL isn't available with every video driver
+		Uint32 windowFlags = (m_softwareRenderer) ? 0 : SDL_WINDOW_OPENGL;
+		m_window = SDL_CreateWindow(title, x, y, width, height, windowFlags);
 
 		if (m_window == nullptr)
 		{
 			throw WindowException("Failed to create window");
 		}
 
-		m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+		Uint32 presentFlag = (options.vsync) ? SDL_RENDERER_PRESENTVSYNC : 0;
+
+		if (!m_softwareRenderer)
+		{
+			m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_ACCELERATED | presentFlag);
+
+			// No GPU or driver available, e.g. on servers
+			if (m_renderer == nullptr && options.softwareFallback)
+			{
+				SG_LOG_WARNING("No accelerated renderer available, using the software renderer: %s", SDL_GetError());
+				m_softwareRenderer = true;
+			}
+		}
+
+		if (m_softwareRenderer)
+		{
+			m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_SOFTWARE | presentFlag);
+		}
 
 		if (m_renderer == nullptr)
 		{
 			throw WindowException("Failed to create renderer");
 		}
 
+		// The renderer may not honor the vsync request
+		SDL_RendererInfo rendererInfo;
+		m_vsync = SDL_GetRendererInfo(m_renderer, &rendererInfo) == 0 && (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC);
+		m_frameLimiter.setTargetFrameRate(options.frameRateLimit);
+		m_performanceOverlayKey = options.performanceOverlayKey;
+		m_occlusionCulling = options.occlusionCulling;
+		m_overdrawKey = options.overdrawKey;
+		m_overdrawReportPath = options.overdrawReportPath;
+		m_profilerKey = options.profilerKey;
+		m_profilerTracePath = options.profilerTracePath;
+		Profiler::setThreadName("Main");
+		m_updateCostReportPath = options.updateCostReportPath;
+		UpdateCosts::setEnabled(options.trackUpdateCosts);
+		m_idleRendering = options.idleRendering;
+
+		if (!options.inputReplayPath.empty())
+		{
+			if (!InputRecorder::startReplay(options.inputReplayPath))
+			{
+				throw WindowException("Failed to read the input recording", false);
+			}
+			m_quitAfterReplay = true;
+		}
+		else if (!options.inputRecordPath.empty() && !InputRecorder::startRecording(options.inputRecordPath, options.inputRecordDelta))
+		{
+			throw WindowException("Failed to create the input recording", false);
+		}
+		m_idleTimeout = options.idleTimeout;
+
+		if (options.allocationFreeAfterFrames > 0 && !AllocationTracker::isAvailable())
+		{
+			throw WindowException("Checking allocations requires building with SG_TRACK_ALLOCATIONS", false);
+		}
+		m_allocationReportPath = options.allocationReportPath;
+		m_allocationFreeAfterFrames = options.allocationFreeAfterFrames;
+
+		Stats::setFrameBudget(options.frameBudget);
+		if (!Stats::setDumpFile(options.statsDumpPath, options.statsDumpInterval))
+		{
+			throw WindowException("Failed to open the stats file", false);
+		}
+
+		TextureLevels::setGenerating(options.textureLevels);
+		TextureLevels::setPadding(options.textureLevelPadding);
+
+		// Textures must keep a CPU copy of their pixels from now on
+		if (m_softwareRenderer && options.softwareRasterizer)
+		{
+			SoftwareRasterizer::setKeepingPixels(true);
+			m_rasterizerEnabled = true;
+		}
+
+		// Skipped frames are spaced like displayed ones
+		SDL_DisplayMode displayMode;
+		if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(m_window), &displayMode) == 0 && displayMode.refresh_rate > 0)
+		{
+			m_refreshInterval = (Uint32)(1000 / displayMode.refresh_rate);
+		}
+
 		SDL_ShowWindow(m_window);
 
 		m_camera = new Camera();
@@ -86,12 +195,37 @@ namespace sg
 
 	Window::~Window()
 	{
+		if (UpdateCosts::isEnabled() && !m_updateCostReportPath.empty())
+		{
+			UpdateCosts::writeReport(m_updateCostReportPath);
+		}
+
+		if (AllocationTracker::isAvailable() && !m_allocationReportPath.empty())
+		{
+			AllocationTracker::writeReport(m_allocationReportPath);
+		}
+
+		InputRecorder::stop();
+
+		// Frames since the last periodic dump aren't lost
+		Stats::dump();
+		Stats::setDumpFile("");
+
 		Audio::quit();
+		StaticTileLayer::quit();
+		m_frameCapture.stop();
+		m_rasterizer.release();
+		SoftwareRasterizer::setKeepingPixels(false);
 		SDL_DestroyWindow(m_window);
 		SDL_DestroyRenderer(m_renderer);
 		TTF_Quit();
 		SDL_Quit();
 		instance = nullptr;
+
+		if (m_closeLog)
+		{
+			Log::close();
+		}
 	}
 
 	void Window::setLogicalSize(unsigned int logicalWidth, unsigned int logicalHeight)
@@ -99,11 +233,31 @@ namespace sg
 		SDL_RenderSetLogicalSize(m_renderer, (int)logicalWidth, (int)logicalHeight);
 	}
 
-	bool Window::processEvents() const
+	bool Window::processEvents()
 	{
+		SG_PROFILE_SCOPE("Window::processEvents");
+
+		if (m_quitAfterReplay && InputRecorder::isReplayFinished())
+		{
+			return false;
+		}
+
+		// Nothing can change until an event arrives, the event stays in the queue
+		if (m_idle && !m_animating && !Game::isTickRequested())
+		{
+			SDL_WaitEventTimeout(nullptr, (int)m_idleTimeout);
+		}
+
+		SG_TRACE1(frame_begin, Stats::get().frame);
+
+		auto updateStart = std::chrono::steady_clock::now();
+
 		// Updating input sub-system is used to determine when a key is up/down
 		Input::update();
 
+		// During a replay the user's input doesn't reach scripts, window shortcuts still work
+		bool userInput = !InputRecorder::isReplaying();
+
 		SDL_Event pendingEvent;
 		while (SDL_PollEvent(&pendingEvent))
 		{
@@ -115,33 +269,102 @@ namespace sg
 
 			// Update mouse position
 			case SDL_MOUSEMOTION:
-				Input::updateMouse(pendingEvent.motion);
+				if (userInput) Input::updateMouse(pendingEvent.motion);
 				break;
 
 			// Add or remove mouse buttons
 			case SDL_MOUSEBUTTONDOWN:
-				Input::addButton(pendingEvent.button.button);
+				if (userInput) Input::addButton(pendingEvent.button.button);
 				break;
 			case SDL_MOUSEBUTTONUP:
-				Input::removeButton(pendingEvent.button.button);
+				if (userInput) Input::removeButton(pendingEvent.button.button);
 				break;
 
 			// add or remove pressed keys
 			case SDL_KEYDOWN:
-				Input::addKey(pendingEvent.key.keysym.sym);
+				if (userInput) Input::addKey(pendingEvent.key.keysym.sym);
+
+				if (pendingEvent.key.keysym.sym == m_performanceOverlayKey && !pendingEvent.key.repeat &&
+					m_performanceOverlayKey != SDLK_UNKNOWN)
+				{
+					m_performanceOverlay.setVisible(!m_performanceOverlay.isVisible());
+					m_forceRedraw = true;
+				}
+
+				if (pendingEvent.key.keysym.sym == m_overdrawKey && !pendingEvent.key.repeat && m_overdrawKey != SDLK_UNKNOWN)
+				{
+					if (m_overdrawAnalysis && !m_overdrawReportPath.empty())
+					{
+						m_overdraw.writeReport(m_overdrawReportPath, 20);
+					}
+					setOverdrawAnalysis(!m_overdrawAnalysis);
+					m_forceRedraw = true;
+				}
+
+				if (pendingEvent.key.keysym.sym == m_profilerKey && !pendingEvent.key.repeat && m_profilerKey != SDLK_UNKNOWN)
+				{
+					// Stopping writes the trace, starting again begins a new one
+					if (Profiler::isEnabled())
+					{
+						Profiler::setEnabled(false);
+						if (!m_profilerTracePath.empty())
+						{
+							Profiler::writeChromeTrace(m_profilerTracePath);
+						}
+					}
+					else
+					{
+						Profiler::clear();
+						Profiler::setEnabled(true);
+					}
+				}
 				break;
 			case SDL_KEYUP:
-				Input::removeKey(pendingEvent.key.keysym.sym);
+				if (userInput) Input::removeKey(pendingEvent.key.keysym.sym);
+				break;
+
+			// The window may have been resized, uncovered or restored
+			case SDL_WINDOWEVENT:
+				m_forceRedraw = true;
+				break;
+
+			// The content of target textures is lost, baked chunks must be drawn again
+			case SDL_RENDER_TARGETS_RESET:
+			case SDL_RENDER_DEVICE_RESET:
+				StaticTileLayer::markAllDirty();
+				m_dirtyRegions.invalidate();
+				m_uiLayerDirty = true;
+				m_forceRedraw = true;
 				break;
 			}
 		}
 
+		// Input of this frame is complete, it's recorded or replaced by the replayed one
+		InputRecorder::processFrame();
+
 		// Update all scripts
 		Game::dispatchUpdates();
 
+		m_frameTimings.update = secondsSince(updateStart);
 		return true;
 	}
 
+	bool Window::setVSync(bool enabled)
+	{
+		if (SDL_RenderSetVSync(m_renderer, (int)enabled) != 0)
+		{
+			return false;
+		}
+
+		m_vsync = enabled;
+		return true;
+	}
+
+	void Window::setFrameRateLimit(unsigned int frameRate)
+	{
+		m_frameLimiter.setTargetFrameRate(frameRate);
+	}
+
 	void Window::setFullscreen(bool fullscreen)
 	{
 		SDL_SetWindowFullscreen(m_window, (int)fullscreen);
@@ -176,186 +399,650 @@ namespace sg
 
 	void Window::updateTopLeftCameraPosition()
 	{
+		m_cameraZoom = (m_camera->zoom > 0.f) ? m_camera->zoom : 1.f;
+
+		// The camera sees the window's size in screen pixels, less of the world when zoomed in
+		m_camera->size = m_windowSize * (1.f / m_cameraZoom);
+
 		// Camera location to top left corner of screen
-		m_cameraTopLeft.x = m_camera->position.x - (m_windowSize.x / 2);
-		m_cameraTopLeft.y = m_camera->position.y - (m_windowSize.y / 2);
+		m_cameraTopLeft.x = m_camera->position.x - (m_camera->size.x / 2);
+		m_cameraTopLeft.y = m_camera->position.y - (m_camera->size.y / 2);
 	}
 
-	void Window::drawTexture(const Object* object, DrawableComponent* component)
+	void Window::submit(const DrawCommand& command)
 	{
-		SDL_Rect textureInfo;
-		SDL_QueryTexture(component->getTexture()->get(), nullptr, nullptr, &(textureInfo.w), &(textureInfo.h));
-		textureInfo.h *= (int)object->getSize().y;
-		textureInfo.w *= (int)object->getSize().x;
+		// Levels are drawn like the texture they were generated from
+		if (command.level > 0)
+		{
+			TextureLevels::copyModulation(command.component->getTexture()->get(), command.texture);
+		}
 
-		// determine upper left corner location of the component
-		vec2 componentPositionUpperLeftCorner;
-		vec2 componentPosition = object->getPosition();
-		if (component->centerOrigin())
+		if (!command.customDraw && command.texture && command.texture != m_lastTexture)
 		{
-			componentPositionUpperLeftCorner.x = (componentPosition.x - (textureInfo.w / 2));
-			componentPositionUpperLeftCorner.y = (componentPosition.y - (textureInfo.h / 2));
+			++m_textureSwitches;
+			m_lastTexture = command.texture;
 		}
-		else
+
+		if (m_activeRasterizer && !command.customDraw && command.texture)
 		{
-			componentPositionUpperLeftCorner.x = componentPosition.x;
-			componentPositionUpperLeftCorner.y = componentPosition.y;
+			if (m_activeRasterizer->draw(command.texture, (command.fullTexture) ? nullptr : &(command.source),
+				command.destination, command.flip))
+			{
+				++m_drawCalls;
+				return;
+			}
 		}
 
-		if (object->isScreenPosition())
+		// Copies queued on the rasterizer are drawn before anything drawn by SDL
+		if (m_activeRasterizer)
 		{
-			textureInfo.x = (int)(componentPositionUpperLeftCorner.x);
-			textureInfo.y = (int)(componentPositionUpperLeftCorner.y);
+			m_activeRasterizer->flush();
 		}
-		// Offset object by camera translation
-		else
+
+		if (command.customDraw)
 		{
-			vec2 objCamRelative = positionCamRelative(componentPositionUpperLeftCorner);
-			textureInfo.x = (int)(objCamRelative.x);
-			textureInfo.y = (int)(objCamRelative.y);
+			++m_drawCalls;
+			if (command.component->getObject().isScreenPosition())
+			{
+				command.component->customDraw(m_renderer, { 0.f, 0.f });
+				return;
+			}
+
+			// Custom drawn components work in world units, the renderer applies the zoom
+			float scaleX, scaleY;
+			SDL_RenderGetScale(m_renderer, &scaleX, &scaleY);
+			SDL_RenderSetScale(m_renderer, scaleX * m_cameraZoom, scaleY * m_cameraZoom);
+			command.component->customDraw(m_renderer, m_cameraTopLeft);
+			SDL_RenderSetScale(m_renderer, scaleX, scaleY);
+			return;
 		}
 
-		SDL_RenderCopyEx(m_renderer, component->getTexture()->get(), nullptr, &textureInfo, 0.0f , nullptr, component->getFlipValue());
+		if (command.texture == nullptr) return;
+
+		++m_drawCalls;
+		SDL_RenderCopyEx(m_renderer, command.texture, (command.fullTexture) ? nullptr : &(command.source),
+			&(command.destination), 0.0f, nullptr, command.flip);
 	}
 
-	void Window::drawTexturePortion(const Object* object, DrawableComponent* component)
+	void Window::gatherDrawables()
 	{
-		SDL_Rect textureInfo;
-		textureInfo.w = component->getSourceRect().w * (int)object->getSize().x;
-		textureInfo.h = component->getSourceRect().h * (int)object->getSize().y;
+		SG_PROFILE_SCOPE("Gather drawables");
 
-		// determine upper left corner location of the component
-		vec2 componentPositionUpperLeftCorner;
-		vec2 componentPosition = object->getPosition();
-		if (component->centerOrigin())
+		m_drawables.clear();
+		m_animating = false;
+
+		// Vectors keep their capacity from one frame to another
+		m_orphans.clear();
+		Game::getAllOrphanObjects(m_orphans);
+
+		// gather drawable components
+		for (Object* obj : m_orphans)
 		{
-			componentPositionUpperLeftCorner.x = (componentPosition.x - (textureInfo.w / 2));
-			componentPositionUpperLeftCorner.y = (componentPosition.y - (textureInfo.h / 2));
+			// draw object if it's flagged as visible and has DrawableComponents
+			if (obj->isVisible())
+			{
+				m_objectDrawables.clear();
+				obj->getComponents<DrawableComponent>(m_objectDrawables);
+				for (DrawableComponent* component : m_objectDrawables)
+				{
+					// Static components are drawn by the StaticTileLayer
+					if (component->isStatic()) continue;
+
+					m_drawables.push_back(component);
+					m_animating = m_animating || component->isAnimating();
+				}
+			}
 		}
-		else
+	}
+
+	void Window::cullOccludedDrawables()
+	{
+		SG_PROFILE_SCOPE("Occlusion culling");
+
+		std::vector<DrawCommand>& commands = m_drawCommands.getCommands();
+
+		// Destinations are in logical coordinates when a logical size is set, it may be larger than the window
+		int width = 0, height = 0;
+		SDL_RenderGetLogicalSize(m_renderer, &width, &height);
+		if (width == 0 || height == 0)
+		{
+			SDL_GetRendererOutputSize(m_renderer, &width, &height);
+		}
+		m_coverage.reset(width, height);
+		m_numCulled = 0;
+		StaticTileLayer::startCulling();
+
+		// Front to back, the last command drawn is visited first
+		for (size_t i = commands.size(); i-- > 0;)
 		{
-			componentPositionUpperLeftCorner.x = componentPosition.x;
-			componentPositionUpperLeftCorner.y = componentPosition.y;
+			DrawCommand& command = commands[i];
+			if (!isWorldCommand(command)) continue;
+
+			// Static tile layers above this command may hide it
+			StaticTileLayer::cullAbove(command.zIndex, m_coverage);
+
+			if (m_coverage.isCovered(command.destination))
+			{
+				command.occluded = true;
+				++m_numCulled;
+				continue;
+			}
+
+			if (command.customDraw || command.texture == nullptr) continue;
+
+			// Opacity is known for the source rectangle in the texture the level was generated from
+			SDL_Rect source = (command.level > 0) ? command.component->getSourceRect() : command.source;
+			if (command.component->getTexture()->isOpaque((command.fullTexture) ? nullptr : &source))
+			{
+				m_coverage.cover(command.destination);
+			}
 		}
 
-		// Offset object by camera translation
-		if (object->isScreenPosition())
+		StaticTileLayer::cullRemaining(m_coverage);
+	}
+
+	void Window::setOverdrawAnalysis(bool enabled)
+	{
+		if (enabled && !m_overdrawAnalysis)
 		{
-			textureInfo.x = (int)(componentPositionUpperLeftCorner.x);
-			textureInfo.y = (int)(componentPositionUpperLeftCorner.y);
+			m_overdraw.reset();
 		}
-		else
+		m_overdrawAnalysis = enabled;
+	}
+
+	void Window::analyzeOverdraw()
+	{
+		m_overdraw.beginFrame((int)m_windowSize.x, (int)m_windowSize.y);
+
+		// The world is rasterized at the resolution scale, user interface drawn apart stays at native resolution
+		float scale = getResolutionScale();
+		StaticTileLayer::recordOverdraw(m_overdraw, scale);
+
+		for (const DrawCommand& command : m_drawCommands.getCommands())
 		{
-			vec2 objCamRelative = positionCamRelative(componentPositionUpperLeftCorner);
-			textureInfo.x = (int)(objCamRelative.x);
-			textureInfo.y = (int)(objCamRelative.y);
+			if (command.occluded || (command.texture == nullptr && !command.customDraw)) continue;
+
+			// Custom drawn components are approximated by the area they cover
+			SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+			if (command.texture)
+			{
+				SDL_GetTextureBlendMode(command.texture, &blendMode);
+			}
+
+			Texture* texture = command.component->getTexture();
+			m_overdraw.record(command.destination, blendMode != SDL_BLENDMODE_NONE, command.component->getObject().getName(),
+				(texture) ? texture->getPath() : std::string(), (isWorldCommand(command)) ? scale : 1.f);
 		}
 
-		SDL_Rect compSourceRect = component->getSourceRect();
-		SDL_RenderCopyEx(m_renderer, component->getTexture()->get(), &compSourceRect, &textureInfo, 0.0f, nullptr, component->getFlipValue());
+		m_overdraw.drawHeatmap(m_renderer);
 	}
 
-	std::vector<DrawablePair> Window::getAllDrawableObjects()
+	bool Window::sceneChanged()
 	{
-		auto objects = Game::getAllOrphanObjects();
+		const std::vector<DrawCommand>& commands = m_drawCommands.getCommands();
 
-		// initialize a vector that contains tuples
-		std::vector<DrawablePair> drawables;
+		// Static tile chunks aren't draw commands, they only move along with the camera
+		bool changed = m_cameraTopLeft.x != m_previousCameraTopLeft.x || m_cameraTopLeft.y != m_previousCameraTopLeft.y ||
+			m_cameraZoom != m_previousCameraZoom || commands.size() != m_previousCommands.size();
 
-		// gather drawable objects
-		for (Object* obj : objects)
+		for (size_t i = 0; i < commands.size() && !changed; ++i)
 		{
-			// draw object if it's flagged as visible and has DrawableComponents
-			if (obj->isVisible())
+			const DrawCommand& command = commands[i];
+			const DrawCommand& previous = m_previousCommands[i];
+
+			// Custom drawn components that aren't animating look the same as long as they don't move
+			if (command.customDraw)
 			{
-				for (DrawableComponent* component : obj->getComponents<DrawableComponent>())
-				{
-					Object* componentOwner = &component->getObject();
-					drawables.push_back(std::make_tuple(componentOwner, component));
-				}
+				changed = !previous.customDraw || command.component != previous.component || command.zIndex != previous.zIndex ||
+					!SDL_RectEquals(&command.destination, &previous.destination);
+			}
+			else
+			{
+				changed = command != previous;
 			}
 		}
 
-		return drawables;
+		if (changed)
+		{
+			m_previousCommands = commands;
+			m_previousCameraTopLeft = m_cameraTopLeft;
+			m_previousCameraZoom = m_cameraZoom;
+		}
+
+		return changed;
+	}
+
+	void Window::setIdleRendering(bool enabled)
+	{
+		m_idleRendering = enabled;
+		m_idle = false;
+		m_forceRedraw = true;
+	}
+
+	bool Window::startFrameCapture(const FrameCaptureSettings& settings)
+	{
+		int width = 0, height = 0;
+		if (SDL_GetRendererOutputSize(m_renderer, &width, &height) != 0)
+		{
+			return false;
+		}
+
+		// Read frames in the format the renderer draws in, SDL would convert every frame otherwise.
+		// The software renderer draws in the window surface, OpenGL reads ARGB8888 from the back buffer
+		Uint32 pixelFormat = SDL_PIXELFORMAT_ARGB8888;
+		if (m_softwareRenderer && SDL_BYTESPERPIXEL(SDL_GetWindowPixelFormat(m_window)) == 4)
+		{
+			pixelFormat = SDL_GetWindowPixelFormat(m_window);
+		}
+
+		return m_frameCapture.start(width, height, settings, pixelFormat);
 	}
 
 	void Window::drawDebugs()
 	{
 #ifdef _DEBUG
-		SDL_Rect objRect;
-		objRect.w = objRect.h = 4;
+		// Gather every rectangle first so each color is drawn in a single call
+		m_debugRects.clear();
 		for (Object* obj : Game::getAllObjects())
 		{
-			for (BoxComponent* box : obj->getComponents<BoxComponent>())
+			// Components of children are gathered through their orphan ancestor
+			if (!obj->isOrphan()) continue;
+
+			m_debugBoxes.clear();
+			obj->getComponents<BoxComponent>(m_debugBoxes);
+
+			for (BoxComponent* box : m_debugBoxes)
 			{
 				// Find box components to debug draw
 				if (box->drawDebug)
 				{
-					SDL_SetRenderDrawColor(m_renderer, 255, 0, 0, 255);
 					SDL_Rect rect = box->getAsRect();
 
 					// If owner's position is not screen position the rectangle relative
 					// to the camera 
-					if (!obj->isScreenPosition())
+					if (!box->getObject().isScreenPosition())
 					{
 						vec2 positionCam = positionCamRelative({ (float)rect.x, (float)rect.y });
 						rect.x = (int)positionCam.x; rect.y = (int)positionCam.y;
+						rect.w = (int)(rect.w * m_cameraZoom); rect.h = (int)(rect.h * m_cameraZoom);
 					}
 
-					SDL_RenderDrawRect(m_renderer, &rect);
+					m_debugRects.push_back(rect);
 				}
 			}
+		}
+
+		SDL_SetRenderDrawColor(m_renderer, 255, 0, 0, 255);
+		SDL_RenderDrawRects(m_renderer, m_debugRects.data(), (int)m_debugRects.size());
 
-			// Draw object debug as well if needed
+		// Draw object debug as well if needed
+		m_debugRects.clear();
+		for (Object* obj : Game::getAllObjects())
+		{
 			if (obj->shouldDrawDebug())
 			{
 				// Position relative to camera if needed
 				vec2 position = (obj->isScreenPosition()) ? obj->getPosition() : positionCamRelative(obj->getPosition());
-				objRect.x = (int)(position.x - 2.0f);
-				objRect.y = (int)(position.y - 2.0f);
-
-				SDL_SetRenderDrawColor(m_renderer, 143, 225, 255, 255);
-				SDL_RenderDrawRect(m_renderer, &objRect);
+				m_debugRects.push_back({ (int)(position.x - 2.0f), (int)(position.y - 2.0f), 4, 4 });
 			}
 		}
+
+		SDL_SetRenderDrawColor(m_renderer, 143, 225, 255, 255);
+		SDL_RenderDrawRects(m_renderer, m_debugRects.data(), (int)m_debugRects.size());
 #endif
 	}
 
-	void Window::draw()
+	void Window::drawPerformanceOverlay()
+	{
+		if (!m_performanceOverlay.isVisible()) return;
+
+		PerformanceCounters counters;
+		counters.objects = Game::getAllObjects().size();
+		counters.drawables = m_drawables.size();
+		counters.drawCalls = m_drawCalls + StaticTileLayer::getNumDrawCalls();
+		counters.culled = m_numCulled + StaticTileLayer::getNumCulled();
+		counters.overdraw = (m_overdrawAnalysis) ? m_overdraw.getOverdraw() : 0.f;
+		counters.resolutionScale = getResolutionScale();
+		counters.textureCache = Texture::getCacheStatistics();
+		counters.animationCache = AnimatedTextureComponent::getCacheStatistics();
+
+		m_performanceOverlay.draw(m_renderer, counters);
+	}
+
+	void Window::setDirtyRectMode(bool enabled)
+	{
+		m_dirtyRectMode = enabled;
+
+		// Start from a fully redrawn back buffer next time the mode is enabled
+		m_dirtyRegions.clear();
+		if (!enabled)
+		{
+			m_backBuffer = nullptr;
+		}
+	}
+
+	void Window::drawScene(const SDL_Rect* region)
+	{
+		StaticTileLayer::startDrawing();
+
+		for (const DrawCommand& command : m_drawCommands.getCommands())
+		{
+			if (!isWorldCommand(command) || command.occluded) continue;
+
+			// Skip drawables outside of the region being redrawn
+			if (region && !SDL_HasIntersection(region, &command.destination)) continue;
+
+			// Static tiles layers are drawn below components that share their zIndex
+			StaticTileLayer::drawUpTo(command.zIndex, m_activeRasterizer);
+
+			submit(command);
+		}
+
+		StaticTileLayer::drawRemaining(m_activeRasterizer);
+	}
+
+	void Window::drawDirtyRegions(bool redrawAll)
+	{
+		int width = (int)m_windowSize.x, height = (int)m_windowSize.y;
+
+		// The back buffer keeps the previous frame, only regions that changed are drawn again
+		if (m_backBuffer == nullptr || m_backBufferWidth != width || m_backBufferHeight != height)
+		{
+			m_backBuffer = std::make_unique<Texture>(width, height);
+			SDL_SetTextureBlendMode(m_backBuffer->get(), SDL_BLENDMODE_NONE);
+			SDL_SetTextureScaleMode(m_backBuffer->get(), SDL_ScaleModeLinear);
+			m_backBufferWidth = width;
+			m_backBufferHeight = height;
+			redrawAll = true;
+		}
+
+		if (m_cameraTopLeft.x != m_backBufferCameraTopLeft.x || m_cameraTopLeft.y != m_backBufferCameraTopLeft.y ||
+			m_cameraZoom != m_backBufferCameraZoom)
+		{
+			m_backBufferCameraTopLeft = m_cameraTopLeft;
+			m_backBufferCameraZoom = m_cameraZoom;
+			redrawAll = true;
+		}
+
+		if (redrawAll)
+		{
+			m_dirtyRegions.invalidate();
+		}
+
+		for (const DrawCommand& command : m_drawCommands.getCommands())
+		{
+			if (isWorldCommand(command))
+			{
+				m_dirtyRegions.track(command);
+			}
+		}
+
+		SDL_Rect screen{ 0, 0, width, height };
+		const std::vector<SDL_Rect>& regions = m_dirtyRegions.endFrame(screen);
+
+		// Regions are in native coordinates, the renderer scales them along with the drawables
+		float scale = getResolutionScale();
+		m_backBuffer->startDrawingOnTexture();
+		SDL_RenderSetScale(m_renderer, scale, scale);
+		for (const SDL_Rect& region : regions)
+		{
+			SDL_RenderSetClipRect(m_renderer, &region);
+
+			// SDL_RenderClear ignores the clip rectangle, fill the region instead
+			SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_NONE);
+			SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+			SDL_RenderFillRect(m_renderer, &region);
+
+			drawScene(&region);
+		}
+		SDL_RenderSetClipRect(m_renderer, nullptr);
+		SDL_RenderSetScale(m_renderer, 1.f, 1.f);
+		m_backBuffer->stopDrawingOnTexture();
+
+		SDL_Rect source{ 0, 0, (int)std::ceil(width * scale), (int)std::ceil(height * scale) };
+		SDL_RenderCopy(m_renderer, m_backBuffer->get(), &source, &screen);
+		++m_drawCalls;
+	}
+
+	void Window::setUILayerCaching(bool enabled)
+	{
+		m_uiLayerCaching = enabled;
+		m_uiLayerDirty = true;
+		m_uiCommands.clear();
+
+		if (!enabled)
+		{
+			m_uiLayer = nullptr;
+		}
+
+		// User interface drawables move in or out of the world
+		m_dirtyRegions.invalidate();
+	}
+
+	void Window::drawUserInterfaceLayer()
+	{
+		int width = (int)m_windowSize.x, height = (int)m_windowSize.y;
+
+		if (m_uiLayer == nullptr || m_uiLayer->getWidth() != width || m_uiLayer->getHeight() != height)
+		{
+			m_uiLayer = std::make_unique<Texture>(width, height);
+
+			// Content is drawn on transparent pixels so colors are premultiplied by alpha.
+			// Renderers that don't support custom blend modes fall back to regular blending
+			SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+				SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+				SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+			if (SDL_SetTextureBlendMode(m_uiLayer->get(), premultiplied) != 0)
+			{
+				SDL_SetTextureBlendMode(m_uiLayer->get(), SDL_BLENDMODE_BLEND);
+			}
+
+			m_uiLayerDirty = true;
+		}
+
+		// Compare user interface commands with the ones the texture was rendered with
+		size_t numCommands = 0;
+		for (const DrawCommand& command : m_drawCommands.getCommands())
+		{
+			if (!command.userInterface) continue;
+
+			if (numCommands >= m_uiCommands.size() || m_uiCommands[numCommands] != command)
+			{
+				m_uiLayerDirty = true;
+				break;
+			}
+			++numCommands;
+		}
+		if (numCommands != m_uiCommands.size())
+		{
+			m_uiLayerDirty = true;
+		}
+
+		if (m_uiLayerDirty)
+		{
+			m_uiCommands.clear();
+			m_uiLayer->startDrawingOnTexture();
+			m_uiLayer->clear();
+
+			for (const DrawCommand& command : m_drawCommands.getCommands())
+			{
+				if (command.userInterface)
+				{
+					submit(command);
+					m_uiCommands.push_back(command);
+				}
+			}
+
+			m_uiLayer->stopDrawingOnTexture();
+			m_uiLayerDirty = false;
+		}
+
+		SDL_Rect screen{ 0, 0, width, height };
+		SDL_RenderCopy(m_renderer, m_uiLayer->get(), nullptr, &screen);
+		++m_drawCalls;
+	}
+
+	void Window::enableDynamicResolution(const DynamicResolutionSettings& settings)
+	{
+		m_dynamicResolution.setSettings(settings);
+		m_dynamicResolutionEnabled = true;
+
+		// User interface drawables move out of the world
+		m_dirtyRegions.invalidate();
+	}
+
+	void Window::disableDynamicResolution()
+	{
+		m_dynamicResolutionEnabled = false;
+		m_worldBuffer = nullptr;
+		m_dirtyRegions.invalidate();
+	}
+
+	void Window::drawScaledWorld()
+	{
+		int width = (int)m_windowSize.x, height = (int)m_windowSize.y;
+
+		// Allocated once at full scale, scale changes only use a smaller part of it
+		if (m_worldBuffer == nullptr || m_worldBuffer->getWidth() != width || m_worldBuffer->getHeight() != height)
+		{
+			m_worldBuffer = std::make_unique<Texture>(width, height);
+			SDL_SetTextureBlendMode(m_worldBuffer->get(), SDL_BLENDMODE_NONE);
+			SDL_SetTextureScaleMode(m_worldBuffer->get(), SDL_ScaleModeLinear);
+		}
+
+		float scale = m_dynamicResolution.getScale();
+
+		// The render target resets the renderer's scale, set it afterwards
+		m_worldBuffer->startDrawingOnTexture();
+		SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+		SDL_RenderClear(m_renderer);
+		SDL_RenderSetScale(m_renderer, scale, scale);
+
+		drawScene();
+
+		SDL_RenderSetScale(m_renderer, 1.f, 1.f);
+		m_worldBuffer->stopDrawingOnTexture();
+
+		SDL_Rect source{ 0, 0, (int)std::ceil(width * scale), (int)std::ceil(height * scale) };
+		SDL_Rect screen{ 0, 0, width, height };
+		SDL_RenderCopy(m_renderer, m_worldBuffer->get(), &source, &screen);
+		++m_drawCalls;
+	}
+
+	void Window::drawRasterizedWorld()
 	{
-		// Clear screen
 		SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
 		SDL_RenderClear(m_renderer);
 
+		// The rasterizer handles the resolution scale itself
+		m_rasterizer.begin(m_renderer, (int)m_windowSize.x, (int)m_windowSize.y, getResolutionScale());
+		m_activeRasterizer = &m_rasterizer;
+
+		drawScene();
+
+		m_rasterizer.flush();
+		m_activeRasterizer = nullptr;
+	}
+
+	void Window::drawUserInterface()
+	{
+		for (const DrawCommand& command : m_drawCommands.getCommands())
+		{
+			if (command.userInterface)
+			{
+				submit(command);
+			}
+		}
+	}
+
+	void Window::draw()
+	{
+		SG_PROFILE_SCOPE("Window::draw");
+
+		auto drawStart = std::chrono::steady_clock::now();
+		m_drawCalls = 0;
+		m_textureSwitches = 0;
+		m_lastTexture = nullptr;
+
 		updateTopLeftCameraPosition();
 
-		// Gather all drawable objects
-		std::vector<DrawablePair> drawables = getAllDrawableObjects();
+		// Bake static tiles that changed before drawing anything on screen
+		bool bakedStaticTiles = StaticTileLayer::beginFrame();
+
+		// Compute draw commands, the renderer only has to submit them afterwards
+		gatherDrawables();
+		m_drawCommands.prepare(m_drawables, m_cameraTopLeft, m_cameraZoom);
+
+		if (m_idleRendering)
+		{
+			// Overlays change every frame. The scene is always compared so the last drawn frame stays up to date
+			bool changed = sceneChanged() || bakedStaticTiles || m_forceRedraw || m_animating ||
+				m_performanceOverlay.isVisible() || m_overdrawAnalysis;
+			m_forceRedraw = false;
+			m_idle = !changed;
 
-		// Sort drawable objects according to their zIndex property
-		std::sort(drawables.begin(), drawables.end(),
-			[](const DrawablePair& a, const DrawablePair& b) -> bool
+			// Keep the last presented frame on screen
+			if (m_idle)
 			{
-				return std::get<1>(a)->zIndex < std::get<1>(b)->zIndex;
-			});
+				// Without waiting for events the loop would spin, space skipped frames like displayed ones
+				if (Game::isTickRequested())
+				{
+					SDL_Delay(m_refreshInterval);
+				}
+				m_skippedFrames = true;
+				endAllocationFrame();
+				return;
+			}
+		}
 
-		// Draw objects
-		for (DrawablePair& tuple : drawables)
+		m_numCulled = 0;
+		if (m_occlusionCulling)
 		{
-			auto* component = std::get<1>(tuple);
+			cullOccludedDrawables();
+		}
 
-			component->preDrawOperations();
-			if (component->drawFullTexture())
+		{
+			SG_PROFILE_SCOPE("Submit draw commands");
+			if (m_dirtyRectMode)
+			{
+				// Baked chunks aren't tracked individually, redraw everything when one changes or the camera moves
+				drawDirtyRegions(bakedStaticTiles);
+			}
+			else if (m_rasterizerEnabled)
 			{
-				drawTexture(std::get<0>(tuple), component);
+				drawRasterizedWorld();
+			}
+			else if (m_dynamicResolutionEnabled)
+			{
+				drawScaledWorld();
 			}
 			else
 			{
-				drawTexturePortion(std::get<0>(tuple), component);
+				// Clear screen
+				SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
+				SDL_RenderClear(m_renderer);
+
+				drawScene();
+			}
+
+			if (m_uiLayerCaching)
+			{
+				drawUserInterfaceLayer();
+			}
+			else if (m_dynamicResolutionEnabled)
+			{
+				// User interface stays at native resolution
+				drawUserInterface();
+			}
+
+			if (m_overdrawAnalysis)
+			{
+				analyzeOverdraw();
 			}
-		}
 
-		drawDebugs();
+			drawDebugs();
+			drawPerformanceOverlay();
+		}
 	
 		//auto tiles = Game::getQuadtree().computeDrawData();
 		//for (SDL_Rect& tile : tiles)
@@ -366,6 +1053,73 @@ namespace sg
 		//	SDL_RenderDrawRect(m_renderer, &rect);
 		//}
 
-		SDL_RenderPresent(m_renderer);
+		// The frame is complete, capture it before presenting it
+		m_frameCapture.capture(m_renderer);
+
+		m_frameTimings.draw = secondsSince(drawStart);
+
+		auto presentStart = std::chrono::steady_clock::now();
+		{
+			SG_PROFILE_SCOPE("Present");
+			SDL_RenderPresent(m_renderer);
+		}
+		m_frameTimings.present = secondsSince(presentStart);
+
+		if (m_skippedFrames)
+		{
+			// The first frame drawn after idling would last the whole idle time, it isn't recorded
+			m_skippedFrames = false;
+			m_frameLimiter.reset();
+		}
+		else
+		{
+			// Wait for the next frame if the frame rate is capped
+			{
+				SG_PROFILE_SCOPE("Frame limiter");
+				m_frameLimiter.endFrame();
+			}
+
+			m_frameTimings.frame = m_frameLimiter.getLastFrameTime();
+			m_performanceOverlay.addFrame(m_frameTimings);
+
+			EngineStats stats;
+			stats.frameTime = m_frameTimings.frame;
+			stats.drawables = m_drawables.size();
+			stats.drawCalls = m_drawCalls + StaticTileLayer::getNumDrawCalls();
+			stats.textureSwitches = m_textureSwitches;
+			stats.culled = m_numCulled + StaticTileLayer::getNumCulled();
+			Stats::endFrame(stats);
+			SG_TRACE3(frame_end, Stats::get().frame - 1, (uint64_t)(stats.frameTime * 1e9f), stats.drawCalls);
+		}
+
+		endAllocationFrame();
+
+		// Time spent waiting for the frame limiter doesn't count
+		if (m_dynamicResolutionEnabled &&
+			m_dynamicResolution.update(m_frameTimings.update + m_frameTimings.draw + m_frameTimings.present))
+		{
+			// The back buffer content was rendered at another scale
+			m_dirtyRegions.invalidate();
+		}
+	}
+
+	void Window::endAllocationFrame()
+	{
+		AllocationTracker::endFrame();
+
+		AllocationCounts allocated = AllocationTracker::getLastFrame();
+		if (m_allocationFreeAfterFrames > 0 && AllocationTracker::getFrame() > m_allocationFreeAfterFrames &&
+			allocated.allocations > 0)
+		{
+			// The report lists the call sites of the frame that allocated
+			if (!m_allocationReportPath.empty())
+			{
+				AllocationTracker::writeReport(m_allocationReportPath);
+			}
+
+			std::string message = "Frame " + std::to_string(AllocationTracker::getFrame()) + " allocated " +
+				std::to_string(allocated.allocations) + " times (" + std::to_string(allocated.bytes) + " bytes) in steady state";
+			throw WindowException(message.c_str(), false);
+		}
 	}
 }
\ No newline at end of file